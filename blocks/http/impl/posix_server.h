@@ -45,6 +45,7 @@ SOFTWARE.
 #include "../../../bricks/sync/owned_borrowed.h"
 #include "../../../bricks/time/chrono.h"
 #include "../../../bricks/util/accumulative_scoped_deleter.h"
+#include "../../../bricks/util/histogram.h"
 
 namespace current {
 namespace http {
@@ -156,6 +157,65 @@ struct StaticFileServer {
   }
 };
 
+// Per-route counters and latency histograms. Updated without locking, by the serving thread and by whichever
+// thread the response is sent from. All times are in microseconds, from the moment the request has been read
+// and is about to be passed to the handler.
+struct HTTPRouteMetrics final {
+  // The requests passed to the handler, and those of them not yet responded to in full.
+  std::atomic<uint64_t> requests{0u};
+  std::atomic<uint64_t> in_flight{0u};
+  // The responses by the first digit of their HTTP code, `[0]` being 1xx, through `[4]` being 5xx.
+  std::atomic<uint64_t> responses[5];
+  // The exceptions caught as they left the handler.
+  std::atomic<uint64_t> exceptions{0u};
+  // Until the handler returns, which may be long before the response is sent, if it is sent from another thread.
+  LogLinearHistogram<std::atomic<uint64_t>> handler_us;
+  // Until the response starts going out.
+  LogLinearHistogram<std::atomic<uint64_t>> first_byte_us;
+  // Until the response is sent in full and the connection is closed.
+  LogLinearHistogram<std::atomic<uint64_t>> response_us;
+
+  HTTPRouteMetrics() {
+    for (auto& counter : responses) {
+      counter.store(0u, std::memory_order_relaxed);
+    }
+  }
+
+  static std::chrono::microseconds SteadyNow() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch());
+  }
+
+  static uint64_t MicrosecondsSince(std::chrono::microseconds begin) {
+    return static_cast<uint64_t>((SteadyNow() - begin).count());
+  }
+
+  // Attached to the connection of each request passed to the handler. Shares the ownership of the metrics,
+  // as the request, and thus the connection, may well outlive the server.
+  class Observer final : public current::net::HTTPServerConnectionObserver {
+   public:
+    explicit Observer(std::shared_ptr<HTTPRouteMetrics> metrics) : metrics_(std::move(metrics)), begin_(SteadyNow()) {
+      metrics_->requests.fetch_add(1u, std::memory_order_relaxed);
+      metrics_->in_flight.fetch_add(1u, std::memory_order_relaxed);
+    }
+    ~Observer() {
+      metrics_->response_us.Record(MicrosecondsSince(begin_));
+      metrics_->in_flight.fetch_sub(1u, std::memory_order_relaxed);
+    }
+    void OnResponse(current::net::HTTPResponseCodeValue code) override {
+      metrics_->first_byte_us.Record(MicrosecondsSince(begin_));
+      const int index = static_cast<int>(code) / 100 - 1;
+      if (index >= 0 && index < 5) {
+        metrics_->responses[index].fetch_add(1u, std::memory_order_relaxed);
+      }
+    }
+    std::chrono::microseconds Begin() const { return begin_; }
+
+   private:
+    const std::shared_ptr<HTTPRouteMetrics> metrics_;
+    const std::chrono::microseconds begin_;
+  };
+};
+
 // HTTP server bound to a specific port.
 class HTTPServerPOSIX final {
  public:
@@ -340,6 +400,94 @@ class HTTPServerPOSIX final {
     return scope;
   }
 
+  // Registers the route to serve the metrics of all the routes of this server, in the Prometheus text format.
+  HTTPRoutesScopeEntry ServeMetrics(const std::string& path = "/metrics") {
+    return Register(path, [this](Request r) {
+      r(MetricsAsPrometheusText(), HTTPResponseCode.OK, current::net::http::Headers(), "text/plain; version=0.0.4");
+    });
+  }
+
+  std::string MetricsAsPrometheusText() const {
+    std::map<std::string, const HTTPRouteMetrics*> routes;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const auto& route : route_metrics_) {
+        routes[route.first] = route.second.get();
+      }
+    }
+    const std::string port = "port=\"" + current::ToString(port_) + '\"';
+    std::ostringstream os;
+    const auto labels = [&port](const std::string& route) {
+      std::string escaped;
+      for (char c : route) {
+        if (c == '\\' || c == '\"') {
+          escaped += '\\';
+        }
+        escaped += c;
+      }
+      return port + ",route=\"" + escaped + '\"';
+    };
+    const auto header = [&os](const char* name, const char* type, const char* help) {
+      os << "# HELP " << name << ' ' << help << "\n# TYPE " << name << ' ' << type << '\n';
+    };
+    const auto counters = [&](const char* name,
+                              const char* type,
+                              const char* help,
+                              std::function<uint64_t(const HTTPRouteMetrics&)> f) {
+      header(name, type, help);
+      for (const auto& route : routes) {
+        os << name << '{' << labels(route.first) << "} " << f(*route.second) << '\n';
+      }
+    };
+    const auto summaries = [&](const char* name,
+                               const char* help,
+                               const LogLinearHistogram<std::atomic<uint64_t>> HTTPRouteMetrics::*histogram) {
+      header(name, "summary", help);
+      for (const auto& route : routes) {
+        // Take a copy, not to walk the buckets being updated once per quantile.
+        const LogLinearHistogram<> snapshot(route.second->*histogram);
+        for (double quantile : {0.5, 0.9, 0.99, 0.999}) {
+          os << name << '{' << labels(route.first) << ",quantile=\"" << quantile << "\"} "
+             << 1e-6 * snapshot.Percentile(quantile) << '\n';
+        }
+        os << name << "_sum{" << labels(route.first) << "} " << 1e-6 * snapshot.Sum() << '\n';
+        os << name << "_count{" << labels(route.first) << "} " << snapshot.Count() << '\n';
+      }
+    };
+
+    counters("current_http_requests_total",
+             "counter",
+             "Requests passed to the handler of the route.",
+             [](const HTTPRouteMetrics& m) { return m.requests.load(std::memory_order_relaxed); });
+    counters("current_http_requests_in_flight",
+             "gauge",
+             "Requests passed to the handler of the route and not yet responded to in full.",
+             [](const HTTPRouteMetrics& m) { return m.in_flight.load(std::memory_order_relaxed); });
+    header("current_http_responses_total", "counter", "Responses sent by the route, by the class of the HTTP code.");
+    for (const auto& route : routes) {
+      for (size_t i = 0; i < 5; ++i) {
+        os << "current_http_responses_total{" << labels(route.first) << ",code=\"" << (i + 1) << "xx\"} "
+           << route.second->responses[i].load(std::memory_order_relaxed) << '\n';
+      }
+    }
+    counters("current_http_handler_exceptions_total",
+             "counter",
+             "Exceptions thrown by the handler of the route.",
+             [](const HTTPRouteMetrics& m) { return m.exceptions.load(std::memory_order_relaxed); });
+    summaries("current_http_handler_seconds",
+              "Time until the handler of the route returned.",
+              &HTTPRouteMetrics::handler_us);
+    summaries("current_http_time_to_first_byte_seconds",
+              "Time until the response started going out.",
+              &HTTPRouteMetrics::first_byte_us);
+    summaries("current_http_response_seconds",
+              "Time until the response was sent in full.",
+              &HTTPRouteMetrics::response_us);
+    header("current_http_not_found_total", "counter", "Requests to which no route matched.");
+    os << "current_http_not_found_total{" << port << "} " << not_found_.load(std::memory_order_relaxed) << '\n';
+    return os.str();
+  }
+
   size_t PathHandlersCount() const {
     // NOTE: The total number of handlers is no longer an interesting measure.
     //       Just return the number of distinct paths, which may be path prefixes.
@@ -353,8 +501,8 @@ class HTTPServerPOSIX final {
   // Note: If the user code handles the request synchronously, the scoped HTTP registerers will do the job.
   // If the user handles the request from another thread, it's the responsibility of the user to make sure
   // the very object ("this") does not get destroyed while the request is being handled.
-  Optional<Borrowed<std::function<void(Request)>>> FindHandler(const std::string& path,
-                                                               URLPathArgs& output_url_args) const {
+  Optional<Borrowed<std::function<void(Request)>>> FindHandler(
+      const std::string& path, URLPathArgs& output_url_args, std::shared_ptr<HTTPRouteMetrics>& output_metrics) const {
     std::lock_guard<std::mutex> lock(mutex_);
 
     // LCOV_EXCL_START
@@ -384,6 +532,7 @@ class HTTPServerPOSIX final {
       if (cit != handlers_.end()) {
         const auto cit2 = cit->second.find(output_url_args.size());
         if (cit2 != cit->second.end()) {
+          output_metrics = route_metrics_.at(remaining_path);
           return Borrowed<std::function<void(Request)>>(cit2->second);
         }
       }
@@ -413,8 +562,12 @@ class HTTPServerPOSIX final {
           break;
         }
         URLPathArgs url_path_args;
-        const auto handler = FindHandler(connection->HTTPRequest().URL().path, url_path_args);
+        std::shared_ptr<HTTPRouteMetrics> metrics;
+        const auto handler = FindHandler(connection->HTTPRequest().URL().path, url_path_args, metrics);
         if (Exists(handler)) {
+          auto observer = std::make_unique<HTTPRouteMetrics::Observer>(metrics);
+          const std::chrono::microseconds begin = observer->Begin();
+          connection->SetObserver(std::move(observer));
           // OK, here's the tricky part with error handling and exceptions in this multithreaded world.
           // * On the one hand, the connection should be std::move-d into the request,
           //   since it might end up being served in another thread, via a message queue, etc.
@@ -439,9 +592,12 @@ class HTTPServerPOSIX final {
             // WARNING: This `catch` is really not sufficient, it just logs a message
             // if a user exception occurred in the same thread that ran the handler.
             // DO NOT COUNT ON IT.
+            metrics->exceptions.fetch_add(1u, std::memory_order_relaxed);          // LCOV_EXCL_LINE
             std::cerr << "HTTP route failed in user code: " << e.what() << '\n';  // LCOV_EXCL_LINE
           }
+          metrics->handler_us.Record(HTTPRouteMetrics::MicrosecondsSince(begin));
         } else {
+          not_found_.fetch_add(1u, std::memory_order_relaxed);
           connection->SendHTTPResponse(current::net::DefaultNotFoundMessage(),
                                        HTTPResponseCode.NotFound,
                                        current::net::http::Headers(),
@@ -510,6 +666,10 @@ class HTTPServerPOSIX final {
 
     {
       // Step 2: Update.
+      auto& metrics = route_metrics_[path];
+      if (!metrics) {
+        metrics = std::make_shared<HTTPRouteMetrics>();
+      }
       auto& handlers_per_path = handlers_[path];
       URLPathArgs::CountMask mask = URLPathArgs::CountMask::None;  // `None` == 1 == (1 << 0).
       for (size_t i = 0; i <= URLPathArgs::MaxArgsCount; ++i, mask = mask << 1) {
@@ -536,6 +696,9 @@ class HTTPServerPOSIX final {
   mutable std::mutex mutex_;
 
   std::map<std::string, std::map<size_t, Owned<std::function<void(Request)>>>> handlers_;
+  // Never removed, so that the counters do not go back. Shared with the observers of the requests in flight.
+  std::map<std::string, std::shared_ptr<HTTPRouteMetrics>> route_metrics_;
+  std::atomic<uint64_t> not_found_{0u};
   std::vector<std::unique_ptr<StaticFileServer>> static_file_servers_;
 };
 
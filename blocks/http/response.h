@@ -57,11 +57,17 @@ template <>
 struct FillResponseHelper<false> {
   template <typename T>
   static std::string AsString(T&& object) {
-    return JSON(std::forward<T>(object)) + '\n';
+    std::string result;
+    AppendJSON(result, std::forward<T>(object));
+    result += '\n';
+    return result;
   }
   template <typename T>
   static std::string AsString(T&& object, const std::string& object_name) {
-    return "{\"" + object_name + "\":" + JSON(std::forward<T>(object)) + "}\n";
+    std::string result = "{\"" + object_name + "\":";
+    AppendJSON(result, std::forward<T>(object));
+    result += "}\n";
+    return result;
   }
   static std::string DefaultContentType() { return net::constants::kDefaultJSONContentType; }
 };
@@ -187,7 +193,9 @@ struct Response final : IHasDoRespondViaHTTP {
 
   template <typename T>
   Response& JSON(const T& object) {
-    body = current::JSON(object) + '\n';
+    body.clear();
+    current::AppendJSON(body, object);
+    body += '\n';
     content_type = net::constants::kDefaultJSONContentType;
     initialized = true;
     return *this;
@@ -195,7 +203,9 @@ struct Response final : IHasDoRespondViaHTTP {
 
   template <typename T>
   Response& JSON(const T& object, const std::string& object_name) {
-    body = "{\"" + object_name + "\":" + current::JSON(object) + "}\n";
+    body = "{\"" + object_name + "\":";
+    current::AppendJSON(body, object);
+    body += "}\n";
     content_type = net::constants::kDefaultJSONContentType;
     initialized = true;
     return *this;
@@ -263,6 +263,77 @@ TEST(HTTPAPI, ScopedUnRegister) {
   }
 }
 
+TEST(HTTPAPI, RouteMetrics) {
+  const auto scope =
+      HTTP(FLAGS_net_api_test_port).Register("/metrics_ok", [](Request r) { r("OK"); }) +
+      HTTP(FLAGS_net_api_test_port).Register("/metrics_fail",
+                                             [](Request r) { r("Nope.", HTTPResponseCode.ServiceUnavailable); }) +
+      HTTP(FLAGS_net_api_test_port).Register("/metrics_async",
+                                             [](Request r) {
+                                               std::thread([](Request inner) { inner("Later."); }, std::move(r))
+                                                   .detach();
+                                             }) +
+      HTTP(FLAGS_net_api_test_port).ServeMetrics("/metrics");
+  const string url = Printf("http://localhost:%d", FLAGS_net_api_test_port);
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_EQ("OK", HTTP(GET(url + "/metrics_ok")).body);
+  }
+  EXPECT_EQ(503, static_cast<int>(HTTP(GET(url + "/metrics_fail")).code));
+  EXPECT_EQ("Later.", HTTP(GET(url + "/metrics_async")).body);
+  EXPECT_EQ(404, static_cast<int>(HTTP(GET(url + "/metrics_no_such_route")).code));
+
+  const auto response = HTTP(GET(url + "/metrics"));
+  EXPECT_EQ(200, static_cast<int>(response.code));
+  const string& text = response.body;
+  const string ok = Printf("port=\"%d\",route=\"/metrics_ok\"", FLAGS_net_api_test_port);
+  const string fail = Printf("port=\"%d\",route=\"/metrics_fail\"", FLAGS_net_api_test_port);
+  const string async = Printf("port=\"%d\",route=\"/metrics_async\"", FLAGS_net_api_test_port);
+  const auto has = [&text](const string& line) { return text.find(line + '\n') != string::npos; };
+  EXPECT_TRUE(has("# TYPE current_http_requests_total counter"));
+  EXPECT_TRUE(has("current_http_requests_total{" + ok + "} 3"));
+  EXPECT_TRUE(has("current_http_requests_total{" + fail + "} 1"));
+  EXPECT_TRUE(has("current_http_requests_total{" + async + "} 1"));
+  EXPECT_TRUE(has("current_http_responses_total{" + ok + ",code=\"2xx\"} 3"));
+  EXPECT_TRUE(has("current_http_responses_total{" + fail + ",code=\"2xx\"} 0"));
+  EXPECT_TRUE(has("current_http_responses_total{" + fail + ",code=\"5xx\"} 1"));
+  EXPECT_TRUE(has("current_http_responses_total{" + async + ",code=\"2xx\"} 1"));
+  EXPECT_TRUE(has("current_http_handler_seconds_count{" + ok + "} 3"));
+  EXPECT_TRUE(has("current_http_time_to_first_byte_seconds_count{" + ok + "} 3"));
+  EXPECT_TRUE(has("current_http_time_to_first_byte_seconds_count{" + async + "} 1"));
+  EXPECT_TRUE(text.find("current_http_handler_seconds{" + ok + ",quantile=\"0.99\"} ") != string::npos);
+  // The request to `/metrics` itself is in flight as the metrics are being generated.
+  EXPECT_TRUE(
+      has(Printf("current_http_requests_in_flight{port=\"%d\",route=\"/metrics\"} 1", FLAGS_net_api_test_port)));
+  EXPECT_TRUE(has("current_http_requests_in_flight{" + ok + "} 0"));
+  EXPECT_TRUE(text.find(Printf("current_http_not_found_total{port=\"%d\"} ", FLAGS_net_api_test_port)) !=
+              string::npos);
+}
+
+TEST(HTTPAPI, RouteMetricsOutliveTheServer) {
+  const int port = PickPortForUnitTest();
+  std::unique_ptr<Request> held;
+  std::atomic_bool request_held(false);
+  string body;
+  std::thread client;
+  {
+    HTTPServerPOSIX server(port);
+    auto scope = server.Register("/hold", [&held, &request_held](Request r) {
+      held = std::make_unique<Request>(std::move(r));
+      request_held = true;
+    });
+    client = std::thread([port, &body]() { body = HTTP(GET(Printf("http://localhost:%d/hold", port))).body; });
+    while (!request_held) {
+      std::this_thread::yield();
+    }
+    scope = nullptr;
+  }
+  // The server is gone, while the request, and the observer updating the metrics of its route, are still here.
+  (*held)("Done.");
+  held = nullptr;
+  client.join();
+  EXPECT_EQ("Done.", body);
+}
+
 TEST(HTTPAPI, ScopeCanBeAssignedNullPtr) {
   auto scope = HTTP(FLAGS_net_api_test_port).Register("/are_we_there_yet", [](Request r) { r("So far."); });
   const string url = Printf("http://localhost:%d/are_we_there_yet", FLAGS_net_api_test_port);
@@ -26,12 +26,23 @@ SOFTWARE.
 #define BLOCKS_MMQ_MMPQ_H
 
 // MMPQ is an in-memory priority queue, with the external interface loosely resembling the one of the original MMQ.
+//
+// The pending entries are ordered by their timestamps, and by their indexes for equal timestamps. Most entries
+// are published in order, and they are appended to a FIFO queue. The ones that are not, i.e. scheduled into
+// the future ahead of others, go into a 4-ary min-heap on top of an `std::vector`. The consumer thread pops
+// all the entries that are ready, up to `DEFAULT_BUFFER_SIZE` of them at once, from whichever of the two has
+// the earlier one, and passes them to the consumer after releasing the mutex. Thus the publishers never wait
+// for the consumer, and a single lock acquisition covers a batch of entries. The publishers that buffer entries
+// on their side can hand them over as a batch too, via `PublishBatchAndUpdateHead()`.
 
 #include <chrono>
+#include <algorithm>
 #include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <thread>
-#include <set>
+#include <utility>
+#include <vector>
 
 #include "../ss/ss.h"
 
@@ -80,11 +91,37 @@ class MMPQImpl {
     // Does not update `last_idx_ts_.us` at all. `UpdateHead()` must be called.
     // This is to ensure the regular `Publish`, coming through the interface defined in `Blocks/ss/pubsub.h`,
     // can publish into the future and utilize the full power of MMPQ.
-    queue_.emplace(std::forward<E>(entry), idxts_t(last_idx_ts_.index, us));
-    condition_variable_.notify_all();
+    Push(Entry(message_t(std::forward<E>(entry)), idxts_t(last_idx_ts_.index, us)));
+    if (!(us > last_idx_ts_.us)) {
+      // No need to wake up the consumer for an entry from the future, `UpdateHead()` will do it.
+      condition_variable_.notify_one();
+    }
     return last_idx_ts_;
   }
 
+  // Publishes a batch of entries, in order, and moves the head to the timestamp of the last one. Takes the lock once,
+  // and wakes up the consumer at most once. The timestamps must be strictly increasing. Clears the batch. THREAD SAFE.
+  void PublishBatchAndUpdateHead(std::vector<std::pair<message_t, std::chrono::microseconds>>& batch) {
+    if (batch.empty()) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::chrono::microseconds previous = last_idx_ts_.us;
+    for (const auto& entry : batch) {
+      if (!(entry.second > previous)) {
+        CURRENT_THROW(ss::InconsistentTimestampException(previous + std::chrono::microseconds(1), entry.second));
+      }
+      previous = entry.second;
+    }
+    for (auto& entry : batch) {
+      ++last_idx_ts_.index;
+      Push(Entry(std::move(entry.first), idxts_t(last_idx_ts_.index, entry.second)));
+    }
+    last_idx_ts_.us = previous;
+    batch.clear();
+    condition_variable_.notify_one();
+  }
+
   // NOTE: `UpdateHead` must be called for the entries to be processed, since otherwise, as entries can be published
   // at non-increasing timestamps order, they must be held in the queue.
   template <current::locks::MutexLockStatus MLS = current::locks::MutexLockStatus::NeedToLock, typename TIMESTAMP>
@@ -95,7 +132,7 @@ class MMPQImpl {
       CURRENT_THROW(ss::InconsistentTimestampException(last_idx_ts_.us + std::chrono::microseconds(1), us));
     }
     last_idx_ts_.us = us;
-    condition_variable_.notify_all();
+    condition_variable_.notify_one();
   }
 
  private:
@@ -104,24 +141,129 @@ class MMPQImpl {
   void operator=(const MMPQImpl&) = delete;
   void operator=(MMPQImpl&&) = delete;
 
+  // The `Entry` struct keeps the entries along with their timestamps.
+  struct Entry {
+    idxts_t index_timestamp;
+    message_t message_body;
+    Entry() = default;
+    Entry(Entry&&) = default;
+    Entry& operator=(Entry&&) = default;
+    Entry(message_t&& message_body, idxts_t index_timestamp)
+        : index_timestamp(index_timestamp), message_body(std::move(message_body)) {}
+    // The entries published at the same timestamp are dispatched in the order they were published in.
+    bool operator<(const Entry& rhs) const {
+      return index_timestamp.us < rhs.index_timestamp.us ||
+             (index_timestamp.us == rhs.index_timestamp.us && index_timestamp.index < rhs.index_timestamp.index);
+    }
+  };
+
   void ConsumerThread() {
+    std::vector<Entry> batch;
     while (true) {
-      std::unique_lock<std::mutex> lock(mutex_);
+      idxts_t last_idx_ts;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        condition_variable_.wait(lock, [this] { return HasReadyEntry() || destructing_; });
+
+        if (destructing_) {
+          return;  // LCOV_EXCL_LINE
+        }
+
+        while (HasReadyEntry() && batch.size() < DEFAULT_BUFFER_SIZE) {
+          batch.push_back(PopEarliest());
+        }
+        last_idx_ts = last_idx_ts_;
+      }
+
+      for (Entry& entry : batch) {
+        consumer_(std::move(entry.message_body), entry.index_timestamp, last_idx_ts);
+      }
+      batch.clear();
+    }
+  }
+
+  // The earliest entry, or `nullptr` if there are none.
+  const Entry* Earliest() const {
+    if (in_order_.empty()) {
+      return heap_.empty() ? nullptr : &heap_.front();
+    } else if (heap_.empty() || in_order_.front() < heap_.front()) {
+      return &in_order_.front();
+    } else {
+      return &heap_.front();
+    }
+  }
+
+  bool HasReadyEntry() const {
+    const Entry* earliest = Earliest();
+    return earliest && !(earliest->index_timestamp.us > last_idx_ts_.us);
+  }
+
+  void Push(Entry&& entry) {
+    if (in_order_.empty() || !(entry < in_order_.back())) {
+      in_order_.push_back(std::move(entry));
+    } else {
+      HeapPush(std::move(entry));
+    }
+  }
+
+  Entry PopEarliest() {
+    if (!heap_.empty() && Earliest() == &heap_.front()) {
+      return HeapPop();
+    } else {
+      Entry result = std::move(in_order_.front());
+      in_order_.pop_front();
+      return result;
+    }
+  }
 
-      condition_variable_.wait(lock,
-                               [this] {
-                                 return (!queue_.empty() && queue_.begin()->index_timestamp.us <= last_idx_ts_.us) ||
-                                        destructing_;
-                               });
+  // The heap is `kHeapArity`-ary, with the children of `heap_[i]` being `heap_[i * kHeapArity + 1]` and onwards.
+  // Compared to a binary heap, it is half as deep, and the children of each node share a cache line or two.
+  constexpr static size_t kHeapArity = 4;
 
-      if (destructing_) {
-        return;  // LCOV_EXCL_LINE
+  void HeapPush(Entry&& entry) {
+    size_t i = heap_.size();
+    heap_.push_back(std::move(entry));
+    Entry moving = std::move(heap_[i]);
+    while (i) {
+      const size_t parent = (i - 1) / kHeapArity;
+      if (!(moving < heap_[parent])) {
+        break;
       }
+      heap_[i] = std::move(heap_[parent]);
+      i = parent;
+    }
+    heap_[i] = std::move(moving);
+  }
 
-      auto it = queue_.begin();
-      consumer_(std::move(const_cast<Entry&>(*it).message_body), it->index_timestamp, last_idx_ts_);
-      queue_.erase(it);
+  Entry HeapPop() {
+    Entry top = std::move(heap_.front());
+    Entry moving = std::move(heap_.back());
+    heap_.pop_back();
+    const size_t size = heap_.size();
+    if (size) {
+      size_t i = 0;
+      while (true) {
+        const size_t first_child = i * kHeapArity + 1;
+        if (first_child >= size) {
+          break;
+        }
+        const size_t end = std::min(first_child + kHeapArity, size);
+        size_t best = first_child;
+        for (size_t child = first_child + 1; child < end; ++child) {
+          if (heap_[child] < heap_[best]) {
+            best = child;
+          }
+        }
+        if (!(heap_[best] < moving)) {
+          break;
+        }
+        heap_[i] = std::move(heap_[best]);
+        i = best;
+      }
+      heap_[i] = std::move(moving);
     }
+    return top;
   }
 
   bool consumer_thread_created_ = false;
@@ -129,18 +271,8 @@ class MMPQImpl {
   // The instance of the consuming side of the FIFO buffer.
   consumer_t& consumer_;
 
-  // The `Entry` struct keeps the entries along with their timestamps.
-  struct Entry {
-    idxts_t index_timestamp;
-    message_t message_body;
-    Entry() = default;
-    Entry(Entry&&) = default;
-    Entry(message_t&& message_body, idxts_t index_timestamp)
-        : index_timestamp(index_timestamp), message_body(std::move(message_body)) {}
-    bool operator<(const Entry& rhs) const { return index_timestamp.us < rhs.index_timestamp.us; }
-  };
-
-  std::set<Entry> queue_;
+  std::deque<Entry> in_order_;
+  std::vector<Entry> heap_;
   idxts_t last_idx_ts_ = idxts_t(0, std::chrono::microseconds(-1));
   std::mutex mutex_;
   std::condition_variable condition_variable_;
@@ -413,3 +413,119 @@ TEST(InMemoryMQ, MMPQSupportsUpdateHead) {
   EXPECT_EQ("three @ 3, seven @ 7, ace @ 100, king @ 101, queen @ 102, jack @ 103, joker @ 1000",
             current::strings::Join(c.messages_by_timestamps_, ", "));
 }
+
+TEST(InMemoryMQ, MMPQKeepsTheOrderOfEntriesWithEqualTimestamps) {
+  current::time::ResetToZero();
+
+  struct ConsumerImpl {
+    std::vector<std::string> messages_;
+    std::atomic_size_t processed_messages_;
+    ConsumerImpl() : processed_messages_(0u) {}
+    EntryResponse operator()(const std::string& s, idxts_t idxts, idxts_t) {
+      messages_.push_back(s + " @ " + current::ToString(idxts.us));
+      ++processed_messages_;
+      return EntryResponse::More;
+    }
+  };
+
+  using Consumer = current::ss::EntrySubscriber<ConsumerImpl, std::string>;
+
+  Consumer c;
+  MMPQ<std::string, Consumer> mmpq(c);
+
+  // Publish in a mixed up order, with several entries per timestamp, and release them all at once.
+  std::vector<std::string> expected;
+  for (size_t i = 0; i < 100; ++i) {
+    const uint64_t us = 1 + (i * 37) % 10;
+    mmpq.Publish(current::ToString(i), std::chrono::microseconds(us));
+  }
+  for (uint64_t us = 1; us <= 10; ++us) {
+    for (size_t i = 0; i < 100; ++i) {
+      if (1 + (i * 37) % 10 == us) {
+        expected.push_back(current::ToString(i) + " @ " + current::ToString(us));
+      }
+    }
+  }
+  mmpq.UpdateHead(std::chrono::microseconds(10));
+  while (c.processed_messages_ != 100) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ(current::strings::Join(expected, ", "), current::strings::Join(c.messages_, ", "));
+}
+
+TEST(InMemoryMQ, MMPQDoesNotBlockPublishersWhileTheConsumerIsBusy) {
+  current::time::ResetToZero();
+
+  struct ConsumerImpl {
+    std::atomic_bool may_proceed_;
+    std::atomic_size_t processed_messages_;
+    ConsumerImpl() : may_proceed_(false), processed_messages_(0u) {}
+    EntryResponse operator()(const std::string&, idxts_t, idxts_t) {
+      while (!may_proceed_) {
+        std::this_thread::yield();
+      }
+      ++processed_messages_;
+      return EntryResponse::More;
+    }
+  };
+
+  using Consumer = current::ss::EntrySubscriber<ConsumerImpl, std::string>;
+
+  Consumer c;
+  MMPQ<std::string, Consumer> mmpq(c);
+
+  // The consumer is stuck on the first message, yet the rest of them can be published.
+  mmpq.Publish("first", std::chrono::microseconds(1));
+  mmpq.UpdateHead(std::chrono::microseconds(1));
+  for (uint64_t us = 2; us <= 1000; ++us) {
+    mmpq.Publish("more", std::chrono::microseconds(us));
+    mmpq.UpdateHead(std::chrono::microseconds(us));
+  }
+  EXPECT_EQ(0u, c.processed_messages_);
+
+  c.may_proceed_ = true;
+  while (c.processed_messages_ != 1000) {
+    std::this_thread::yield();
+  }
+}
+
+TEST(InMemoryMQ, MMPQPublishesBatches) {
+  current::time::ResetToZero();
+
+  struct ConsumerImpl {
+    std::vector<std::string> messages_;
+    std::atomic_size_t processed_messages_;
+    ConsumerImpl() : processed_messages_(0u) {}
+    EntryResponse operator()(const std::string& s, idxts_t idxts, idxts_t) {
+      messages_.push_back(s + " @ " + current::ToString(idxts.us));
+      ++processed_messages_;
+      return EntryResponse::More;
+    }
+  };
+
+  using Consumer = current::ss::EntrySubscriber<ConsumerImpl, std::string>;
+
+  Consumer c;
+  MMPQ<std::string, Consumer> mmpq(c);
+
+  // Entries scheduled into the future are released by the batch, as it moves the head.
+  mmpq.Publish("scheduled", std::chrono::microseconds(3));
+
+  std::vector<std::pair<std::string, std::chrono::microseconds>> batch;
+  batch.emplace_back("one", std::chrono::microseconds(1));
+  batch.emplace_back("two", std::chrono::microseconds(2));
+  batch.emplace_back("four", std::chrono::microseconds(4));
+  mmpq.PublishBatchAndUpdateHead(batch);
+  EXPECT_TRUE(batch.empty());
+
+  // The timestamps of the next batch should be strictly greater than the head.
+  batch.emplace_back("five", std::chrono::microseconds(5));
+  batch.emplace_back("four again", std::chrono::microseconds(4));
+  ASSERT_THROW(mmpq.PublishBatchAndUpdateHead(batch), current::ss::InconsistentTimestampException);
+  EXPECT_EQ(2u, batch.size());
+
+  while (c.processed_messages_ != 4) {
+    std::this_thread::yield();
+  }
+  EXPECT_EQ("one @ 1, two @ 2, scheduled @ 3, four @ 4", current::strings::Join(c.messages_, ", "));
+}
@@ -527,6 +527,30 @@ using HTTPRequestData = GenericHTTPRequestData<HTTPDefaultHelper>;
 
 enum class ChunkFlush : bool { NoFlush = false, Flush = true };
 
+// An optional observer of a server-side connection. It is notified right before the response starts going out,
+// and destroyed along with the connection, i.e. once the response has been sent in full.
+// Used by the HTTP server to keep per-route metrics. As the connection may outlive the server that has set
+// the observer, the observer should own, or share the ownership of, whatever it updates.
+struct HTTPServerConnectionObserver {
+  virtual ~HTTPServerConnectionObserver() = default;
+  virtual void OnResponse(HTTPResponseCodeValue code) = 0;
+};
+
+namespace impl {
+
+// The response code among the arguments passed to `SendHTTPResponse()`, which defaults to `OK`.
+inline HTTPResponseCodeValue ResponseCodeFromArguments() { return HTTPResponseCode.OK; }
+template <typename... TS>
+HTTPResponseCodeValue ResponseCodeFromArguments(HTTPResponseCodeValue code, TS&&...) {
+  return code;
+}
+template <typename T, typename... TS>
+HTTPResponseCodeValue ResponseCodeFromArguments(T&&, TS&&... rest) {
+  return ResponseCodeFromArguments(std::forward<TS>(rest)...);
+}
+
+}  // namespace current::net::impl
+
 template <class HTTP_REQUEST_DATA>
 class GenericHTTPServerConnection final : public HTTPResponder {
  public:
@@ -544,6 +568,7 @@ class GenericHTTPServerConnection final : public HTTPResponder {
       // But, at least, capitalized "INTERNAL SERVER ERROR" will be returned.
       // It's also a good place for a breakpoint to tell the source of that exception.
       // LCOV_EXCL_START
+      NotifyObserver(HTTPResponseCode.InternalServerError);
       try {
         HTTPResponder::SendHTTPResponse(connection_,
                                         DefaultInternalServerErrorMessage(),
@@ -571,6 +596,7 @@ class GenericHTTPServerConnection final : public HTTPResponder {
     if (responded_) {
       CURRENT_THROW(AttemptedToSendHTTPResponseMoreThanOnce());
     } else {
+      NotifyObserver(impl::ResponseCodeFromArguments(args...));
       HTTPResponder::SendHTTPResponse(connection_, std::forward<ARGS>(args)...);
       responded_ = true;
     }
@@ -704,6 +730,7 @@ class GenericHTTPServerConnection final : public HTTPResponder {
       CURRENT_THROW(AttemptedToSendHTTPResponseMoreThanOnce());
     } else {
       responded_ = true;
+      NotifyObserver(code);
       std::ostringstream os;
       PrepareHTTPResponseHeader(os, ConnectionKeepAlive, code, headers, content_type);
       os << "Transfer-Encoding: chunked" << constants::kCRLF << constants::kCRLF;
@@ -728,7 +755,17 @@ class GenericHTTPServerConnection final : public HTTPResponder {
 
   Connection& RawConnection() { return connection_; }
 
+  void SetObserver(std::unique_ptr<HTTPServerConnectionObserver> observer) { observer_ = std::move(observer); }
+
  private:
+  void NotifyObserver(HTTPResponseCodeValue code) {
+    if (observer_) {
+      observer_->OnResponse(code);
+    }
+  }
+
+  // Declared first to be destroyed last, after the connection is closed.
+  std::unique_ptr<HTTPServerConnectionObserver> observer_;
   bool responded_ = false;
   Connection connection_;
   GenericHTTPRequestData<HTTP_REQUEST_DATA> message_;
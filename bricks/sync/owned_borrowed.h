@@ -41,6 +41,8 @@ SOFTWARE.
 //   if and only if the master scope (the scope of `Owned<T>`) is being terminated, and is currently
 //   awaiting until all the borrowers are done.
 //
+//   Creating, copying, and destroying a `Borrowed<T>` is lock-free: it only updates an atomic reference count.
+//
 // * BorrowedWithCallback<T> borrower(master, [&signal]() { signal.SignalTermination(); });
 //   Initializes `borrower` passing it an external signal that will be likely `std::move()` it into a different thread.
 //   The lifetime of the `borrower` object will be strictly inside the lifetime of `master`.
@@ -78,14 +80,24 @@ struct ConstructBorrowedObjectViaMoveConstructor {};
 
 struct ConstructUniqueContainerViaMoveConstructor {};
 
-// The actual instance, kept along with its destructing status, and a list of registered borrowers.
+// The actual instance, kept along with its destructing status, the list of registered borrowers with callbacks,
+// and the reference count of the borrowers without callbacks.
 template <typename T>
 struct UniqueInstance final {
   // Constructor: Construct an instance of the object.
-  UniqueInstance() : destructing_(false), instance_(), total_borrowers_spawned_throughout_lifetime_(0u) {}
+  UniqueInstance()
+      : destructing_(false),
+        instance_(),
+        references_(1u),
+        owner_reference_released_(false),
+        total_borrowers_spawned_throughout_lifetime_(0u) {}
   template <typename... ARGS>
   UniqueInstance(ARGS&&... args)
-      : destructing_(false), instance_(std::forward<ARGS>(args)...), total_borrowers_spawned_throughout_lifetime_(0u) {}
+      : destructing_(false),
+        instance_(std::forward<ARGS>(args)...),
+        references_(1u),
+        owner_reference_released_(false),
+        total_borrowers_spawned_throughout_lifetime_(0u) {}
 
   // Destructor: Block until all the borrowers are done.
   ~UniqueInstance() {
@@ -106,18 +118,60 @@ struct UniqueInstance final {
       f();
     }
 
+    // Release the reference of the owner, so that the last borrower without a callback to go signals it has.
+    // Done under the mutex, for `NumberOfReferencingBorrowers()` to see the flag and the count consistently.
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      owner_reference_released_ = true;
+      if (references_.fetch_sub(1u, std::memory_order_acq_rel) == 1u) {
+        all_references_released_ = true;
+      }
+    }
+
     // Wait until all the borrowers have terminated.
     {
       std::unique_lock<std::mutex> lock(mutex_);
-      condition_variable_.wait(lock, [this]() { return borrowers_.empty(); });
+      condition_variable_.wait(lock, [this]() { return borrowers_.empty() && all_references_released_; });
+    }
+  }
+
+  // Add a reference for a newly spawned borrower without a callback. Lock-free, unless the count was zero.
+  // Must be called on behalf of an existing owner or borrower, for the instance to outlive this call.
+  // The count can only be zero if the owner is gone, and the destructor is waiting for a borrower with a callback,
+  // from which this one is being spawned. Then the destructor must wait for this borrower too.
+  void AddReference() {
+    if (references_.fetch_add(1u, std::memory_order_acq_rel) == 0u) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      all_references_released_ = false;
     }
+    total_borrowers_spawned_throughout_lifetime_.fetch_add(1u, std::memory_order_relaxed);
+  }
+
+  // Release a reference. Lock-free, unless it is the very last one, which can only be after the owner has
+  // released its own, i.e. when the destructor is waiting for it. The flag is set, and the destructor is notified,
+  // while holding the mutex, so that the destructor does not proceed until this thread is done with the mutex.
+  void ReleaseReference() {
+    if (references_.fetch_sub(1u, std::memory_order_acq_rel) == 1u) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      all_references_released_ = true;
+      condition_variable_.notify_one();
+    }
+  }
+
+  // The number of the borrowers without callbacks. For unit-testing purposes mostly.
+  // Must be called from within a mutex-locked section.
+  size_t NumberOfReferencingBorrowersFromLockedSection() const {
+    const size_t references = references_.load();
+    return owner_reference_released_ ? references : references - 1u;
   }
 
   // Register ("increase the ref-count") a newly spawned borrower, along with its termination signal callback.
   // Must be called from within a mutex-locked section.
   size_t RegisterBorrowerFromLockedSection(std::function<void()> destruction_callback) {
-    borrowers_[++total_borrowers_spawned_throughout_lifetime_] = destruction_callback;
-    return total_borrowers_spawned_throughout_lifetime_;
+    const size_t key = ++next_borrower_key_;
+    total_borrowers_spawned_throughout_lifetime_.fetch_add(1u, std::memory_order_relaxed);
+    borrowers_[key] = destruction_callback;
+    return key;
   }
 
   void UpdateBorrowersCallbackFromLockedSection(size_t key, std::function<void()> destruction_callback) {
@@ -126,16 +180,13 @@ struct UniqueInstance final {
 
   // Unregister ("decrease the ref-count") a previously spawned borrower.
   // Locks its own mutex; must be called from outside a mutex-locked section.
+  // Notifies while holding the mutex, as once it is released the destructor may proceed and destroy the instance.
   void UnRegisterBorrower(size_t borrower_index) {
-    bool notify = false;
-    {
-      std::lock_guard<std::mutex> lock(mutex_);
-      auto it = borrowers_.find(borrower_index);
-      CURRENT_ASSERT(it != borrowers_.end());
-      borrowers_.erase(it);
-      notify = borrowers_.empty();
-    }
-    if (notify) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = borrowers_.find(borrower_index);
+    CURRENT_ASSERT(it != borrowers_.end());
+    borrowers_.erase(it);
+    if (borrowers_.empty()) {
       condition_variable_.notify_one();
     }
   }
@@ -145,12 +196,16 @@ struct UniqueInstance final {
   UniqueInstance& operator=(const UniqueInstance&) = delete;
   UniqueInstance& operator=(UniqueInstance&&) = delete;
 
-  std::atomic_bool destructing_;                        // Whether it already is in the "destructing" mode.
-  T instance_;                                          // The actual instance.
-  std::mutex mutex_;                                    // The mutex to guard per-borrower info.
-  std::condition_variable condition_variable_;          // The variable to notify as all the borrowers are gone.
-  std::map<size_t, std::function<void()>> borrowers_;   // Map of live borrower -> termination signal callback.
-  size_t total_borrowers_spawned_throughout_lifetime_;  // A pre-increment of this value is the key in the above map.
+  std::atomic_bool destructing_;                       // Whether it already is in the "destructing" mode.
+  T instance_;                                         // The actual instance.
+  std::mutex mutex_;                                   // The mutex to guard per-borrower info.
+  std::condition_variable condition_variable_;         // The variable to notify as all the borrowers are gone.
+  std::map<size_t, std::function<void()>> borrowers_;  // Map of live borrower -> termination signal callback.
+  size_t next_borrower_key_ = 0u;                      // A pre-increment of this value is the key in the above map.
+  std::atomic<size_t> references_;                     // The owner, plus one per live borrower without a callback.
+  std::atomic_bool owner_reference_released_;          // Whether the above includes the owner.
+  bool all_references_released_ = false;               // Set, under the mutex, once the above drops to zero.
+  std::atomic<size_t> total_borrowers_spawned_throughout_lifetime_;  // Both with and without callbacks.
 };
 
 }  // namespace current::sync::impl
@@ -181,18 +236,37 @@ class WeakBorrowed {
     key_ = p_actual_instance_->RegisterBorrowerFromLockedSection(destruction_callback);
   }
 
+  // The borrower without a callback, lock-free.
+  WeakBorrowed(impl::ConstructBorrowed, const WeakBorrowed& rhs)
+      : p_actual_instance_(rhs.p_actual_instance_), key_(kReferencingBorrowerKey) {
+    p_actual_instance_->AddReference();
+  }
+
   WeakBorrowed(impl::ConstructBorrowedObjectViaMoveConstructor,
                WeakBorrowed&& rhs,
                std::function<void()> destruction_callback) {
     MoveFrom(std::move(rhs), destruction_callback);
   }
 
+  // The borrower without a callback. Moving a borrower without a callback does not touch the instance at all.
+  WeakBorrowed(impl::ConstructBorrowedObjectViaMoveConstructor, WeakBorrowed&& rhs) { MoveFrom(std::move(rhs)); }
+
   void InitializeMovedOwned(instance_t& actual_instance) {
     p_actual_instance_ = &actual_instance;
     key_ = 0u;
   }
 
   void MoveFrom(WeakBorrowed&& rhs, std::function<void()> destruction_callback) {
+    if (rhs.key_ == kReferencingBorrowerKey) {
+      // Register the callback first, and only then release the reference, for the count not to drop to zero.
+      {
+        std::lock_guard<std::mutex> lock(rhs.p_actual_instance_->mutex_);
+        p_actual_instance_ = rhs.p_actual_instance_;
+        key_ = p_actual_instance_->RegisterBorrowerFromLockedSection(destruction_callback);
+      }
+      rhs.InternalUnRegister();
+      return;
+    }
     std::lock_guard<std::mutex> lock(rhs.p_actual_instance_->mutex_);
     p_actual_instance_ = rhs.p_actual_instance_;
     key_ = rhs.key_;
@@ -201,6 +275,17 @@ class WeakBorrowed {
     rhs.p_actual_instance_ = nullptr;
   }
 
+  void MoveFrom(WeakBorrowed&& rhs) {
+    if (rhs.key_ == kReferencingBorrowerKey) {
+      p_actual_instance_ = rhs.p_actual_instance_;
+      key_ = kReferencingBorrowerKey;
+      rhs.key_ = 0u;
+      rhs.p_actual_instance_ = nullptr;
+    } else {
+      MoveFrom(std::move(rhs), []() {});
+    }
+  }
+
   WeakBorrowed(const WeakBorrowed&) = delete;
   WeakBorrowed(WeakBorrowed&&) = delete;
   WeakBorrowed& operator=(const WeakBorrowed&) = delete;
@@ -250,22 +335,26 @@ class WeakBorrowed {
   // THREAD-SAFE. NEVER THROWS.
   size_t NumberOfActiveBorrowers() const {
     std::lock_guard<std::mutex> lock(p_actual_instance_->mutex_);
-    return p_actual_instance_->borrowers_.size();
+    return p_actual_instance_->borrowers_.size() + p_actual_instance_->NumberOfReferencingBorrowersFromLockedSection();
   }
 
   // Return the total number of registered borrower users registered, with some possibly already out of scope.
   // For unit-testing purposes mostly, but may end up useful. -- D.K.
   // THREAD-SAFE. NEVER THROWS.
   size_t TotalBorrowersSpawnedThroughoutLifetime() const {
-    std::lock_guard<std::mutex> lock(p_actual_instance_->mutex_);
-    return p_actual_instance_->total_borrowers_spawned_throughout_lifetime_;
+    return p_actual_instance_->total_borrowers_spawned_throughout_lifetime_.load();
   }
 
  protected:
   instance_t* p_actual_instance_;  // Is set to `nullptr` externally when moved.
 
   void InternalUnRegister() {
-    if (key_) {
+    if (key_ == kReferencingBorrowerKey) {
+      CURRENT_ASSERT(p_actual_instance_);
+      // Same as below, minus the callback, and lock-free unless this is the last borrower of a destructing object.
+      p_actual_instance_->ReleaseReference();
+      key_ = 0u;
+    } else if (key_) {
       CURRENT_ASSERT(p_actual_instance_);
       // `*this` is a valid (non - std::move()-d - away) borrowed object. As it is being terminated,
       // it should unregister its callback, so that:
@@ -280,7 +369,10 @@ class WeakBorrowed {
   }
 
  private:
-  size_t key_;  // The index of the slave user to mark as left the scope, or `0u` if N/A (master or moved away).
+  // The key of a borrower without a callback, which holds a reference instead of being in the map of borrowers.
+  constexpr static size_t kReferencingBorrowerKey = static_cast<size_t>(-1);
+
+  size_t key_;  // The index of the slave user to mark as left the scope, `kReferencingBorrowerKey`, or `0u` if N/A.
 };
 
 namespace impl {
@@ -391,6 +483,8 @@ class BorrowedWithCallback final : public WeakBorrowed<T> {
 //    (otherwise the `Owned` scope will wait forever in the destructor), and
 // 2) Unlike `BorrowedWithCallback<T>`, instances of `Borrowed<T>` can be safely moved
 //    (which makes them ideal for returning as lightweight values, passing as parameters to threads, etc.)
+// 3) Creating, copying, moving, and destroying `Borrowed<T>` instances takes no locks, as, with no callback to call,
+//    they are tracked by a reference count instead of being registered in the map of borrowers.
 template <typename T>
 class Borrowed final : public WeakBorrowed<T> {
  private:
@@ -399,19 +493,21 @@ class Borrowed final : public WeakBorrowed<T> {
   using base_t = WeakBorrowed<T>;
 
  public:
-  Borrowed(const Borrowed& rhs) : base_t(impl::ConstructBorrowed(), rhs, []() {}) {}
+  Borrowed(const Borrowed& rhs) : base_t(impl::ConstructBorrowed(), rhs) {}
 
-  Borrowed(Borrowed&& rhs) : base_t(impl::ConstructBorrowedObjectViaMoveConstructor(), std::move(rhs), []() {}) {}
+  Borrowed(Borrowed&& rhs) : base_t(impl::ConstructBorrowedObjectViaMoveConstructor(), std::move(rhs)) {}
 
   Borrowed& operator=(Borrowed&& rhs) {
-    base_t::MoveFrom(std::move(rhs), []() {});
+    if (&rhs != this) {
+      base_t::InternalUnRegister();
+      base_t::MoveFrom(std::move(rhs));
+    }
     return *this;
   }
 
-  Borrowed(const WeakBorrowed<T>& rhs) : base_t(impl::ConstructBorrowed(), rhs, []() {}) {}
+  Borrowed(const WeakBorrowed<T>& rhs) : base_t(impl::ConstructBorrowed(), rhs) {}
 
-  Borrowed(WeakBorrowed<T>&& rhs)
-      : base_t(impl::ConstructBorrowedObjectViaMoveConstructor(), std::move(rhs), []() {}) {}
+  Borrowed(WeakBorrowed<T>&& rhs) : base_t(impl::ConstructBorrowedObjectViaMoveConstructor(), std::move(rhs)) {}
 
   void operator=(std::nullptr_t) { base_t::InternalUnRegister(); }
 
@@ -252,6 +252,95 @@ TEST(OwnedBorrowed, UseInternalIsDestructingGetter) {
   thread->join();
 }
 
+// Test `current::Borrowed<>`, which is reference-counted without locking, along with the callback-based borrowers.
+TEST(OwnedBorrowed, BorrowedIsReferenceCounted) {
+  std::string log;
+  {
+    current::Owned<int> x(current::ConstructOwned<int>(), 0);
+    {
+      current::Borrowed<int> a(x);
+      current::Borrowed<int> b(a);
+      EXPECT_EQ(2u, x.NumberOfActiveBorrowers());
+      EXPECT_EQ(2u, x.TotalBorrowersSpawnedThroughoutLifetime());
+
+      current::Borrowed<int> c(std::move(b));
+      EXPECT_FALSE(static_cast<bool>(b));
+      EXPECT_TRUE(static_cast<bool>(c));
+      EXPECT_EQ(2u, x.NumberOfActiveBorrowers());
+      EXPECT_EQ(2u, x.TotalBorrowersSpawnedThroughoutLifetime());
+
+      current::Borrowed<int> d(x);
+      d = std::move(c);
+      EXPECT_EQ(2u, x.NumberOfActiveBorrowers());
+      EXPECT_EQ(3u, x.TotalBorrowersSpawnedThroughoutLifetime());
+
+      // Moving a `Borrowed<>` into a `BorrowedWithCallback<>` registers the callback.
+      current::BorrowedWithCallback<int> e(std::move(d), [&log]() { log += "-e\n"; });
+      EXPECT_FALSE(static_cast<bool>(d));
+      EXPECT_EQ(2u, x.NumberOfActiveBorrowers());
+      EXPECT_EQ(4u, x.TotalBorrowersSpawnedThroughoutLifetime());
+
+      ++*a;
+      ++*e;
+      a = nullptr;
+      EXPECT_EQ(1u, x.NumberOfActiveBorrowers());
+    }
+    EXPECT_EQ(0u, x.NumberOfActiveBorrowers());
+    EXPECT_EQ(2, *x);
+  }
+  EXPECT_EQ("", log);
+
+  // Many threads borrowing, copying, and releasing concurrently, with the owner waiting for them to be done.
+  std::atomic_int total(0);
+  std::vector<std::thread> threads;
+  {
+    current::Owned<std::atomic_int> x(current::ConstructOwned<std::atomic_int>(), 0);
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([&total](current::Borrowed<std::atomic_int> y) {
+        while (y) {
+          current::Borrowed<std::atomic_int> copy(y);
+          current::Borrowed<std::atomic_int> moved(std::move(copy));
+          ++*moved;
+        }
+        total += *y;
+      }, current::Borrowed<std::atomic_int>(x));
+    }
+    while (*x < 10000) {
+      std::this_thread::yield();
+    }
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_GE(total, 4 * 10000);
+}
+
+// A `Borrowed<>` spawned from a `BorrowedWithCallback<>` while the owner is destructing, with no other borrowers
+// without callbacks left, must still be waited for by the owner, even once that `BorrowedWithCallback<>` is gone.
+TEST(OwnedBorrowed, BorrowedSpawnedWhileOwnerIsDestructing) {
+  std::atomic_bool terminating(false);
+  std::atomic_bool borrowed_released(false);
+  std::unique_ptr<std::thread> thread;
+  {
+    current::Owned<int> x(current::ConstructOwned<int>(), 42);
+    thread = std::make_unique<std::thread>(
+        [&terminating, &borrowed_released](std::unique_ptr<current::BorrowedWithCallback<int>> y) {
+          while (!terminating) {
+            std::this_thread::yield();
+          }
+          std::unique_ptr<current::Borrowed<int>> z = std::make_unique<current::Borrowed<int>>(*y);
+          y = nullptr;
+          std::this_thread::sleep_for(std::chrono::milliseconds(50));
+          EXPECT_EQ(42, **z);
+          borrowed_released = true;
+          z = nullptr;
+        },
+        std::make_unique<current::BorrowedWithCallback<int>>(x, [&terminating]() { terminating = true; }));
+  }
+  EXPECT_TRUE(borrowed_released) << "The owner must have waited for the `Borrowed<>` spawned while destructing.";
+  thread->join();
+}
+
 TEST(WaitableAtomic, Smoke) {
   using current::WaitableAtomic;
   using current::IntrusiveClient;
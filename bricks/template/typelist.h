@@ -439,6 +439,33 @@ static_assert(std::is_same<int, TypeListElement<0, TypeListImpl<int>>>::value, "
 static_assert(std::is_same<long, TypeListElement<0, TypeListImpl<long, char>>>::value, "");
 static_assert(std::is_same<char, TypeListElement<1, TypeListImpl<long, char>>>::value, "");
 
+// `TypeListIndex<TypeListImpl<TS...>, T>::value` is the 0-based index of `T` in `TS...`,
+// or `sizeof...(TS)` if `T` is not contained in `TS...`.
+template <typename TYPE_LIST_IMPL, typename TYPE>
+struct TypeListIndex;
+
+template <typename T>
+struct TypeListIndex<TypeListImpl<>, T> {
+  constexpr static size_t value = 0u;
+};
+
+template <typename T, typename... TS>
+struct TypeListIndex<TypeListImpl<T, TS...>, T> {
+  constexpr static size_t value = 0u;
+};
+
+template <typename X, typename... TS, typename T>
+struct TypeListIndex<TypeListImpl<X, TS...>, T> {
+  constexpr static size_t value = 1u + TypeListIndex<TypeListImpl<TS...>, T>::value;
+};
+
+static_assert(TypeListIndex<TypeListImpl<>, int>::value == 0u, "");
+static_assert(TypeListIndex<TypeListImpl<int>, int>::value == 0u, "");
+static_assert(TypeListIndex<TypeListImpl<int>, char>::value == 1u, "");
+static_assert(TypeListIndex<TypeListImpl<long, char>, long>::value == 0u, "");
+static_assert(TypeListIndex<TypeListImpl<long, char>, char>::value == 1u, "");
+static_assert(TypeListIndex<TypeListImpl<long, char>, int>::value == 2u, "");
+
 }  // namespace metaprogramming
 }  // namespace current
 
@@ -449,6 +476,7 @@ using current::metaprogramming::TypeListContains;
 using current::metaprogramming::IsTypeList;
 using current::metaprogramming::TypeListSize;
 using current::metaprogramming::TypeListElement;
+using current::metaprogramming::TypeListIndex;
 
 // Note: For equality and lack of discrimination reasons, the user may still use raw `TypeListImpl`,
 // if she prefers to not have flattening and deduplication take place.
@@ -0,0 +1,208 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2016 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// `LogLinearHistogram` records non-negative integer values, typically latencies, into log-linear buckets,
+// the way HdrHistogram does: the values below 16 get a bucket each, and every further power of two is split
+// into 16 equal sub-buckets. Thus any recorded value, and any percentile reported, is off by at most 1/16th,
+// while the histogram itself is a fixed array of under six hundred counters, and recording a value is a few
+// shifts and an increment.
+//
+// `LogLinearHistogram<>` is for single-threaded use, `LogLinearHistogram<std::atomic<uint64_t>>` can be updated
+// concurrently. The two can be merged into one another.
+
+#ifndef BRICKS_UTIL_HISTOGRAM_H
+#define BRICKS_UTIL_HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace current {
+
+struct LogLinearBuckets {
+  constexpr static size_t kSubBucketBits = 4;
+  constexpr static size_t kSubBuckets = static_cast<size_t>(1) << kSubBucketBits;
+  // The values beyond `2^40`, which is over twelve days in microseconds, are recorded into the last bucket.
+  constexpr static size_t kValueBits = 40;
+  constexpr static uint64_t kMaxValue = (static_cast<uint64_t>(1) << kValueBits) - 1;
+  constexpr static size_t kBuckets = kSubBuckets * (kValueBits - kSubBucketBits + 1);
+
+  static size_t MostSignificantBit(uint64_t value) {
+#ifdef __GNUC__
+    return 63 - __builtin_clzll(value);
+#else
+    size_t result = 0;
+    for (size_t shift = 32; shift; shift >>= 1) {
+      if (value >> shift) {
+        value >>= shift;
+        result += shift;
+      }
+    }
+    return result;
+#endif
+  }
+
+  static size_t BucketIndex(uint64_t value) {
+    if (value < kSubBuckets) {
+      return static_cast<size_t>(value);
+    }
+    if (value > kMaxValue) {
+      value = kMaxValue;
+    }
+    const size_t shift = MostSignificantBit(value) - kSubBucketBits;
+    return ((shift + 1) << kSubBucketBits) + static_cast<size_t>((value >> shift) & (kSubBuckets - 1));
+  }
+
+  // The smallest and the largest values which end up in the bucket with this index.
+  static uint64_t BucketLowerBound(size_t index) {
+    if (index < 2 * kSubBuckets) {
+      return index;
+    }
+    const size_t shift = (index >> kSubBucketBits) - 1;
+    return static_cast<uint64_t>(kSubBuckets + (index & (kSubBuckets - 1))) << shift;
+  }
+  static uint64_t BucketUpperBound(size_t index) {
+    if (index < 2 * kSubBuckets) {
+      return index;
+    }
+    const size_t shift = (index >> kSubBucketBits) - 1;
+    return BucketLowerBound(index) + (static_cast<uint64_t>(1) << shift) - 1;
+  }
+};
+
+namespace impl {
+
+inline void HistogramIncrement(uint64_t& counter, uint64_t delta) { counter += delta; }
+inline void HistogramIncrement(std::atomic<uint64_t>& counter, uint64_t delta) {
+  counter.fetch_add(delta, std::memory_order_relaxed);
+}
+
+inline uint64_t HistogramLoad(const uint64_t& counter) { return counter; }
+inline uint64_t HistogramLoad(const std::atomic<uint64_t>& counter) {
+  return counter.load(std::memory_order_relaxed);
+}
+
+inline void HistogramStore(uint64_t& counter, uint64_t value) { counter = value; }
+inline void HistogramStore(std::atomic<uint64_t>& counter, uint64_t value) {
+  counter.store(value, std::memory_order_relaxed);
+}
+
+}  // namespace current::impl
+
+template <typename COUNTER = uint64_t>
+class LogLinearHistogram final {
+ public:
+  LogLinearHistogram() { Reset(); }
+  LogLinearHistogram(const LogLinearHistogram& rhs) {
+    Reset();
+    Merge(rhs);
+  }
+  template <typename RHS_COUNTER>
+  explicit LogLinearHistogram(const LogLinearHistogram<RHS_COUNTER>& rhs) {
+    Reset();
+    Merge(rhs);
+  }
+  LogLinearHistogram& operator=(const LogLinearHistogram& rhs) {
+    if (this != &rhs) {
+      Reset();
+      Merge(rhs);
+    }
+    return *this;
+  }
+
+  void Record(uint64_t value, uint64_t times = 1) {
+    impl::HistogramIncrement(counts_[LogLinearBuckets::BucketIndex(value)], times);
+    impl::HistogramIncrement(total_count_, times);
+    impl::HistogramIncrement(total_sum_, value * times);
+  }
+
+  template <typename RHS_COUNTER>
+  void Merge(const LogLinearHistogram<RHS_COUNTER>& rhs) {
+    for (size_t i = 0; i < LogLinearBuckets::kBuckets; ++i) {
+      const uint64_t count = rhs.BucketCount(i);
+      if (count) {
+        impl::HistogramIncrement(counts_[i], count);
+      }
+    }
+    impl::HistogramIncrement(total_count_, rhs.Count());
+    impl::HistogramIncrement(total_sum_, rhs.Sum());
+  }
+
+  void Reset() {
+    for (auto& counter : counts_) {
+      impl::HistogramStore(counter, 0);
+    }
+    impl::HistogramStore(total_count_, 0);
+    impl::HistogramStore(total_sum_, 0);
+  }
+
+  uint64_t Count() const { return impl::HistogramLoad(total_count_); }
+  uint64_t Sum() const { return impl::HistogramLoad(total_sum_); }
+  uint64_t BucketCount(size_t index) const { return impl::HistogramLoad(counts_[index]); }
+
+  // The value at or below which `ratio` of the recorded values are, `Percentile(0.99)` being the p99.
+  // Reported as the largest value of the respective bucket, and as zero for an empty histogram.
+  uint64_t Percentile(double ratio) const {
+    const uint64_t total = Count();
+    if (!total) {
+      return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(ratio * total + 0.5);
+    if (rank < 1) {
+      rank = 1;
+    } else if (rank > total) {
+      rank = total;
+    }
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LogLinearBuckets::kBuckets; ++i) {
+      seen += BucketCount(i);
+      if (seen >= rank) {
+        return LogLinearBuckets::BucketUpperBound(i);
+      }
+    }
+    // Only reachable if `Record()`-s were racing with this call.
+    return LogLinearBuckets::BucketUpperBound(LogLinearBuckets::kBuckets - 1);
+  }
+
+  // Calls `f(lower_bound, upper_bound, count)` for each non-empty bucket, in the increasing order of values.
+  template <typename F>
+  void ForEachBucket(F&& f) const {
+    for (size_t i = 0; i < LogLinearBuckets::kBuckets; ++i) {
+      const uint64_t count = BucketCount(i);
+      if (count) {
+        f(LogLinearBuckets::BucketLowerBound(i), LogLinearBuckets::BucketUpperBound(i), count);
+      }
+    }
+  }
+
+ private:
+  std::array<COUNTER, LogLinearBuckets::kBuckets> counts_;
+  COUNTER total_count_;
+  COUNTER total_sum_;
+};
+
+}  // namespace current
+
+#endif  // BRICKS_UTIL_HISTOGRAM_H
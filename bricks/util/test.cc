@@ -28,6 +28,7 @@ SOFTWARE.
 #include "base64.h"
 #include "comparators.h"
 #include "crc32.h"
+#include "histogram.h"
 #include "iterator.h"
 #include "lazy_instantiation.h"
 #include "make_scope_guard.h"
@@ -310,6 +311,69 @@ TEST(Util, ROL64) {
   EXPECT_EQ(1ull, current::ROL64(static_cast<uint64_t>(std::pow(2.0, 63)), 1));
 }
 
+TEST(Util, LogLinearHistogram) {
+  using current::LogLinearBuckets;
+
+  // Exact up to 31, then at most 1/16th off, with no gaps between the buckets.
+  for (uint64_t value = 0; value < 32; ++value) {
+    EXPECT_EQ(value, LogLinearBuckets::BucketIndex(value));
+    EXPECT_EQ(value, LogLinearBuckets::BucketLowerBound(value));
+    EXPECT_EQ(value, LogLinearBuckets::BucketUpperBound(value));
+  }
+  for (size_t index = 1; index < LogLinearBuckets::kBuckets; ++index) {
+    EXPECT_EQ(LogLinearBuckets::BucketUpperBound(index - 1) + 1, LogLinearBuckets::BucketLowerBound(index));
+    EXPECT_EQ(index, LogLinearBuckets::BucketIndex(LogLinearBuckets::BucketLowerBound(index)));
+    EXPECT_EQ(index, LogLinearBuckets::BucketIndex(LogLinearBuckets::BucketUpperBound(index)));
+    EXPECT_LE(LogLinearBuckets::BucketUpperBound(index) - LogLinearBuckets::BucketLowerBound(index),
+              LogLinearBuckets::BucketLowerBound(index) / 16);
+  }
+  EXPECT_EQ(LogLinearBuckets::BucketIndex(1ull << 50), LogLinearBuckets::BucketIndex(1ull << 40));
+
+  current::LogLinearHistogram<> histogram;
+  EXPECT_EQ(0u, histogram.Count());
+  EXPECT_EQ(0u, histogram.Percentile(0.5));
+  for (uint64_t value = 1; value <= 1000; ++value) {
+    histogram.Record(value);
+  }
+  histogram.Record(1000000);
+  EXPECT_EQ(1001u, histogram.Count());
+  EXPECT_EQ(1500500u, histogram.Sum());
+  EXPECT_EQ(1u, histogram.Percentile(0.0));
+  EXPECT_EQ(511u, histogram.Percentile(0.5));
+  EXPECT_EQ(991u, histogram.Percentile(0.99));
+  EXPECT_EQ(1023u, histogram.Percentile(0.999));
+  EXPECT_EQ(1015807u, histogram.Percentile(1.0));
+
+  size_t buckets = 0;
+  uint64_t total = 0;
+  histogram.ForEachBucket([&buckets, &total](uint64_t lower, uint64_t upper, uint64_t count) {
+    EXPECT_LE(lower, upper);
+    ++buckets;
+    total += count;
+  });
+  EXPECT_EQ(1001u, total);
+  EXPECT_GT(buckets, 100u);
+
+  current::LogLinearHistogram<std::atomic<uint64_t>> concurrent;
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < 4; ++i) {
+    threads.emplace_back([&concurrent]() {
+      for (uint64_t value = 0; value < 1000; ++value) {
+        concurrent.Record(value);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(4000u, concurrent.Count());
+  histogram.Merge(concurrent);
+  EXPECT_EQ(5001u, histogram.Count());
+  EXPECT_EQ(1500500u + 4u * 499500u, histogram.Sum());
+  histogram.Reset();
+  EXPECT_EQ(0u, histogram.Count());
+}
+
 #if 0
 // This test is disabled since even being initialized with constant seed,
 // the random number generator returns different values on different platforms. :(
@@ -0,0 +1,389 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2016 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// The benchmark suite for Current Storage. Runs all the scenarios in one go, and writes the results as JSON,
+// so that the numbers for two builds can be compared side by side.
+//
+// Scenarios:
+// * Cold replay: the time to construct the master storage atop a pre-generated stream file, per MB of stream.
+// * Read-write transactions per second, by container type and by payload size.
+// * Read-only transactions per second, by the number of concurrent threads.
+// * Latency percentiles of RESTful `GET`-s and `POST`-s.
+// * Heap memory per entry, by container type.
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+#include "../../../storage/storage.h"
+#include "../../../storage/api.h"
+#include "../../../storage/persister/stream.h"
+
+#include "../../../blocks/http/api.h"
+#include "../../../bricks/dflags/dflags.h"
+#include "../../../bricks/file/file.h"
+#include "../../../bricks/strings/split.h"
+#include "../../../bricks/util/random.h"
+
+DEFINE_string(tmpdir, ".current", "The directory to create the temporary stream files in.");
+DEFINE_string(json, ".current/suite.json", "The name of the file to write the benchmark results as JSON.");
+DEFINE_uint32(replay_entries, 100000u, "The number of entries in the stream for the cold replay benchmark.");
+DEFINE_uint32(transactions, 20000u, "The number of read-write transactions to run per container and payload size.");
+DEFINE_string(payload_sizes, "16,256,4096", "Comma-separated payload sizes, in bytes, for read-write transactions.");
+DEFINE_uint32(max_threads, 8u, "Run read-only transactions from one to this many threads.");
+DEFINE_double(seconds, 1.0, "The duration of each read-only concurrency run, in seconds.");
+DEFINE_uint32(rest_requests, 2000u, "The number of RESTful requests of each kind to time.");
+DEFINE_uint16(port, 8383, "The local port to spawn the RESTful API on.");
+DEFINE_uint32(memory_entries, 200000u, "The number of entries to populate to measure memory per entry.");
+
+namespace storage_benchmark {
+
+CURRENT_STRUCT(Record) {
+  CURRENT_FIELD(key, uint64_t, 0u);
+  CURRENT_FIELD(value, std::string);
+  CURRENT_DEFAULT_CONSTRUCTOR(Record) {}
+  CURRENT_CONSTRUCTOR(Record)(uint64_t key, const std::string& value) : key(key), value(value) {}
+  void InitializeOwnKey() { key = current::random::CSRandomUInt64(0ull, ~0ull); }
+};
+
+CURRENT_STRUCT(Cell) {
+  CURRENT_FIELD(row, uint64_t, 0u);
+  CURRENT_FIELD(col, uint64_t, 0u);
+  CURRENT_FIELD(value, std::string);
+  CURRENT_DEFAULT_CONSTRUCTOR(Cell) {}
+  CURRENT_CONSTRUCTOR(Cell)(uint64_t row, uint64_t col, const std::string& value) : row(row), col(col), value(value) {}
+};
+
+CURRENT_STORAGE_FIELD_ENTRY(UnorderedDictionary, Record, RecordUnorderedDictionary);
+CURRENT_STORAGE_FIELD_ENTRY(OrderedDictionary, Record, RecordOrderedDictionary);
+CURRENT_STORAGE_FIELD_ENTRY(UnorderedManyToUnorderedMany, Cell, CellUnorderedManyToUnorderedMany);
+CURRENT_STORAGE_FIELD_ENTRY(CompactManyToCompactMany, Cell, CellCompactManyToCompactMany);
+
+CURRENT_STORAGE(BenchmarkStorage) {
+  CURRENT_STORAGE_FIELD(unordered, RecordUnorderedDictionary);
+  CURRENT_STORAGE_FIELD(ordered, RecordOrderedDictionary);
+  CURRENT_STORAGE_FIELD(m2m, CellUnorderedManyToUnorderedMany);
+  CURRENT_STORAGE_FIELD(compact_m2m, CellCompactManyToCompactMany);
+};
+
+using storage_t = BenchmarkStorage<StreamStreamPersister>;
+using in_memory_storage_t = BenchmarkStorage<StreamInMemoryStreamPersister>;
+
+CURRENT_STRUCT(ReplayResult) {
+  CURRENT_FIELD(entries, uint64_t);
+  CURRENT_FIELD(stream_mb, double);
+  CURRENT_FIELD(seconds, double);
+  CURRENT_FIELD(mb_per_second, double);
+  CURRENT_FIELD(entries_per_second, double);
+};
+
+CURRENT_STRUCT(TransactionsResult) {
+  CURRENT_FIELD(container, std::string);
+  CURRENT_FIELD(payload_bytes, uint32_t);
+  CURRENT_FIELD(transactions, uint64_t);
+  CURRENT_FIELD(seconds, double);
+  CURRENT_FIELD(transactions_per_second, double);
+};
+
+CURRENT_STRUCT(ConcurrencyResult) {
+  CURRENT_FIELD(threads, uint32_t);
+  CURRENT_FIELD(transactions, uint64_t);
+  CURRENT_FIELD(seconds, double);
+  CURRENT_FIELD(transactions_per_second, double);
+};
+
+CURRENT_STRUCT(LatencyResult) {
+  CURRENT_FIELD(method, std::string);
+  CURRENT_FIELD(requests, uint64_t);
+  CURRENT_FIELD(p50_us, uint64_t);
+  CURRENT_FIELD(p90_us, uint64_t);
+  CURRENT_FIELD(p99_us, uint64_t);
+  CURRENT_FIELD(max_us, uint64_t);
+};
+
+CURRENT_STRUCT(MemoryResult) {
+  CURRENT_FIELD(container, std::string);
+  CURRENT_FIELD(entries, uint64_t);
+  CURRENT_FIELD(bytes_per_entry, double);
+};
+
+CURRENT_STRUCT(Report) {
+  CURRENT_FIELD(arch, std::string, CURRENT_ARCH_UNAME);
+  CURRENT_FIELD(replay, ReplayResult);
+  CURRENT_FIELD(transactions, std::vector<TransactionsResult>);
+  CURRENT_FIELD(concurrency, std::vector<ConcurrencyResult>);
+  CURRENT_FIELD(latency, std::vector<LatencyResult>);
+  CURRENT_FIELD(memory, std::vector<MemoryResult>);
+};
+
+// Don't use `current::time::Now()`, as it's under a mutex, and guaranteed to increase by at least 1 per call.
+inline double NowInSeconds() {
+  return 1e-6 * std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline std::string Payload(size_t size) { return std::string(size, 'x'); }
+
+// The number of bytes currently allocated via the global `operator new`, see the bottom of this file.
+// The resident set size is of no use here, as the memory freed by the previous benchmarks gets reused.
+std::atomic<int64_t> heap_bytes_allocated(0);
+
+inline ReplayResult BenchmarkColdReplay(uint32_t entries) {
+  const std::string file = current::FileSystem::JoinPath(FLAGS_tmpdir, "suite_replay.json");
+  const auto file_remover = current::FileSystem::ScopedRmFile(file);
+  {
+    auto storage = storage_t::CreateMasterStorage(file);
+    for (uint32_t i = 0u; i < entries; ++i) {
+      storage->ReadWriteTransaction([i](MutableFields<storage_t> fields) {
+        fields.unordered.Add(Record(i, current::SHA256(current::ToString(i))));
+      }).Wait();
+    }
+  }
+  ReplayResult result;
+  result.entries = entries;
+  result.stream_mb = 1e-6 * current::FileSystem::GetFileSize(file);
+  const double begin = NowInSeconds();
+  {
+    auto storage = storage_t::CreateMasterStorage(file);
+    const size_t size = Value(storage->ReadOnlyTransaction([](ImmutableFields<storage_t> fields) {
+      return fields.unordered.Size();
+    }).Go());
+    CURRENT_ASSERT(size == entries);
+    result.seconds = NowInSeconds() - begin;
+  }
+  result.mb_per_second = result.stream_mb / result.seconds;
+  result.entries_per_second = entries / result.seconds;
+  return result;
+}
+
+template <typename F>
+TransactionsResult BenchmarkReadWriteTransactions(const std::string& container, uint32_t payload_bytes, F&& add) {
+  auto storage = in_memory_storage_t::CreateMasterStorage();
+  const std::string payload = Payload(payload_bytes);
+  TransactionsResult result;
+  result.container = container;
+  result.payload_bytes = payload_bytes;
+  result.transactions = FLAGS_transactions;
+  const double begin = NowInSeconds();
+  for (uint32_t i = 0u; i < FLAGS_transactions; ++i) {
+    storage->ReadWriteTransaction([&add, &payload, i](MutableFields<in_memory_storage_t> fields) {
+      add(fields, i, payload);
+    }).Wait();
+  }
+  result.seconds = NowInSeconds() - begin;
+  result.transactions_per_second = result.transactions / result.seconds;
+  return result;
+}
+
+inline std::vector<TransactionsResult> BenchmarkReadWriteTransactions() {
+  using fields_t = MutableFields<in_memory_storage_t>;
+  std::vector<TransactionsResult> results;
+  for (const auto& size : current::strings::Split(FLAGS_payload_sizes, ',')) {
+    const uint32_t payload_bytes = current::FromString<uint32_t>(size);
+    results.push_back(BenchmarkReadWriteTransactions(
+        "UnorderedDictionary", payload_bytes, [](fields_t& fields, uint32_t i, const std::string& payload) {
+          fields.unordered.Add(Record(i, payload));
+        }));
+    results.push_back(BenchmarkReadWriteTransactions(
+        "OrderedDictionary", payload_bytes, [](fields_t& fields, uint32_t i, const std::string& payload) {
+          fields.ordered.Add(Record(i, payload));
+        }));
+    results.push_back(BenchmarkReadWriteTransactions(
+        "UnorderedManyToUnorderedMany", payload_bytes, [](fields_t& fields, uint32_t i, const std::string& payload) {
+          fields.m2m.Add(Cell(i % 1000u, i, payload));
+        }));
+    results.push_back(BenchmarkReadWriteTransactions(
+        "CompactManyToCompactMany", payload_bytes, [](fields_t& fields, uint32_t i, const std::string& payload) {
+          fields.compact_m2m.Add(Cell(i % 1000u, i, payload));
+        }));
+  }
+  return results;
+}
+
+inline std::vector<ConcurrencyResult> BenchmarkReadOnlyConcurrency() {
+  const uint32_t size = 10000u;
+  auto storage = in_memory_storage_t::CreateMasterStorage();
+  storage->ReadWriteTransaction([size](MutableFields<in_memory_storage_t> fields) {
+    for (uint32_t i = 0u; i < size; ++i) {
+      fields.unordered.Add(Record(i, Payload(64u)));
+    }
+  }).Wait();
+
+  std::vector<ConcurrencyResult> results;
+  for (uint32_t threads_count = 1u; threads_count <= FLAGS_max_threads; ++threads_count) {
+    std::atomic<uint64_t> transactions(0u);
+    std::vector<std::thread> threads;
+    const double end = NowInSeconds() + FLAGS_seconds;
+    const double begin = NowInSeconds();
+    for (uint32_t t = 0u; t < threads_count; ++t) {
+      threads.emplace_back([&storage, &transactions, end, size, t]() {
+        uint64_t done = 0u;
+        uint32_t key = t;
+        while (NowInSeconds() < end) {
+          key = (key * 17u + 1u) % size;
+          const bool found = Value(storage->ReadOnlyTransaction([key](ImmutableFields<in_memory_storage_t> fields) {
+            return Exists(fields.unordered[key]);
+          }).Go());
+          CURRENT_ASSERT(found);
+          ++done;
+        }
+        transactions += done;
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    ConcurrencyResult result;
+    result.threads = threads_count;
+    result.transactions = transactions;
+    result.seconds = NowInSeconds() - begin;
+    result.transactions_per_second = result.transactions / result.seconds;
+    results.push_back(result);
+  }
+  return results;
+}
+
+inline LatencyResult LatencyPercentiles(const std::string& method, std::vector<uint64_t>& latencies_us) {
+  CURRENT_ASSERT(!latencies_us.empty());
+  std::sort(latencies_us.begin(), latencies_us.end());
+  const auto percentile = [&latencies_us](double p) {
+    return latencies_us[std::min(latencies_us.size() - 1u, static_cast<size_t>(p * latencies_us.size()))];
+  };
+  LatencyResult result;
+  result.method = method;
+  result.requests = latencies_us.size();
+  result.p50_us = percentile(0.50);
+  result.p90_us = percentile(0.90);
+  result.p99_us = percentile(0.99);
+  result.max_us = latencies_us.back();
+  return result;
+}
+
+inline std::vector<LatencyResult> BenchmarkRESTLatency() {
+  auto storage = in_memory_storage_t::CreateMasterStorage();
+  const auto rest = RESTfulStorage<in_memory_storage_t>(*storage, FLAGS_port, "/api", "");
+  const std::string base_url = current::strings::Printf("http://localhost:%d/api/data/unordered", FLAGS_port);
+
+  std::vector<std::string> keys;
+  std::vector<uint64_t> post_latencies_us;
+  for (uint32_t i = 0u; i < FLAGS_rest_requests; ++i) {
+    const double begin = NowInSeconds();
+    const auto response = HTTP(POST(base_url, Record(0u, Payload(64u))));
+    post_latencies_us.push_back(static_cast<uint64_t>(1e6 * (NowInSeconds() - begin)));
+    CURRENT_ASSERT(static_cast<int>(response.code) == 201);
+    keys.push_back(response.body);
+  }
+
+  std::vector<uint64_t> get_latencies_us;
+  for (uint32_t i = 0u; i < FLAGS_rest_requests; ++i) {
+    const double begin = NowInSeconds();
+    const auto response = HTTP(GET(base_url + '/' + keys[i]));
+    get_latencies_us.push_back(static_cast<uint64_t>(1e6 * (NowInSeconds() - begin)));
+    CURRENT_ASSERT(static_cast<int>(response.code) == 200);
+  }
+
+  return {LatencyPercentiles("POST", post_latencies_us), LatencyPercentiles("GET", get_latencies_us)};
+}
+
+template <typename F>
+MemoryResult BenchmarkMemory(const std::string& container, F&& add) {
+  MemoryResult result;
+  result.container = container;
+  result.entries = FLAGS_memory_entries;
+  // Populate the field in a single transaction, and then measure the heap taken by the storage replayed from it.
+  // The file persister only keeps the offset of each transaction in memory, so the field itself is what's measured.
+  const std::string file = current::FileSystem::JoinPath(FLAGS_tmpdir, "suite_memory.json");
+  const auto file_remover = current::FileSystem::ScopedRmFile(file);
+  {
+    auto storage = storage_t::CreateMasterStorage(file);
+    storage->ReadWriteTransaction([&add](MutableFields<storage_t> fields) {
+      for (uint32_t i = 0u; i < FLAGS_memory_entries; ++i) {
+        add(fields, i);
+      }
+    }).Wait();
+  }
+  const int64_t before = heap_bytes_allocated;
+  {
+    const auto storage = storage_t::CreateMasterStorage(file);
+    result.bytes_per_entry = static_cast<double>(heap_bytes_allocated - before) / FLAGS_memory_entries;
+  }
+  return result;
+}
+
+inline std::vector<MemoryResult> BenchmarkMemory() {
+  using fields_t = MutableFields<storage_t>;
+  return {BenchmarkMemory("UnorderedDictionary",
+                          [](fields_t& fields, uint32_t i) { fields.unordered.Add(Record(i, "")); }),
+          BenchmarkMemory("OrderedDictionary", [](fields_t& fields, uint32_t i) { fields.ordered.Add(Record(i, "")); }),
+          BenchmarkMemory("UnorderedManyToUnorderedMany",
+                          [](fields_t& fields, uint32_t i) { fields.m2m.Add(Cell(i % 1000u, i, "")); }),
+          BenchmarkMemory("CompactManyToCompactMany",
+                          [](fields_t& fields, uint32_t i) { fields.compact_m2m.Add(Cell(i % 1000u, i, "")); })};
+}
+
+}  // namespace storage_benchmark
+
+int main(int argc, char** argv) {
+  ParseDFlags(&argc, &argv);
+
+  using namespace storage_benchmark;
+  Report report;
+
+  std::cerr << "Cold replay ..." << std::endl;
+  report.replay = BenchmarkColdReplay(FLAGS_replay_entries);
+  std::cerr << "Read-write transactions ..." << std::endl;
+  report.transactions = BenchmarkReadWriteTransactions();
+  std::cerr << "Read-only concurrency ..." << std::endl;
+  report.concurrency = BenchmarkReadOnlyConcurrency();
+  std::cerr << "RESTful latency ..." << std::endl;
+  report.latency = BenchmarkRESTLatency();
+  std::cerr << "Memory per entry ..." << std::endl;
+  report.memory = BenchmarkMemory();
+
+  const std::string json = JSON(report);
+  std::cout << json << std::endl;
+  if (!FLAGS_json.empty()) {
+    current::FileSystem::WriteStringToFile(json, FLAGS_json.c_str());
+  }
+}
+
+// Keep the size of each block in front of it, to maintain `storage_benchmark::heap_bytes_allocated`.
+void* operator new(size_t size) {
+  void* block = std::malloc(size + sizeof(std::max_align_t));
+  if (!block) {
+    throw std::bad_alloc();
+  }
+  *static_cast<size_t*>(block) = size;
+  storage_benchmark::heap_bytes_allocated.fetch_add(size, std::memory_order_relaxed);
+  return static_cast<char*>(block) + sizeof(std::max_align_t);
+}
+
+void operator delete(void* ptr) noexcept {
+  if (ptr) {
+    void* block = static_cast<char*>(ptr) - sizeof(std::max_align_t);
+    storage_benchmark::heap_bytes_allocated.fetch_sub(*static_cast<size_t*>(block), std::memory_order_relaxed);
+    std::free(block);
+  }
+}
@@ -36,6 +36,7 @@ SOFTWARE.
 #endif
 
 #include <atomic>
+#include <map>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -91,6 +92,28 @@ class DummyClaireNotifiable : public IClaireNotifiable {
   void OnKarlLocatorChanged(const Locator&) override {}
 };
 
+// The JSON of each top-level field of a keepalive, including the fields of its supers, for the keepalives
+// to be delta-encoded field by field.
+template <typename T>
+struct KeepaliveFieldsAsJSON {
+  struct Collector {
+    std::map<std::string, std::string>& output;
+    template <typename U>
+    void operator()(const char* name, const U& value) const {
+      output[name] = JSON(value);
+    }
+  };
+  static void Collect(const T& keepalive, std::map<std::string, std::string>& output) {
+    KeepaliveFieldsAsJSON<reflection::SuperType<T>>::Collect(keepalive, output);
+    reflection::VisitAllFields<T, reflection::FieldNameAndImmutableValue>::WithObject(keepalive, Collector{output});
+  }
+};
+
+template <>
+struct KeepaliveFieldsAsJSON<CurrentStruct> {
+  static void Collect(const CurrentStruct&, std::map<std::string, std::string>&) {}
+};
+
 template <class T>
 class GenericClaire final : private DummyClaireNotifiable {
  public:
@@ -238,6 +261,7 @@ class GenericClaire final : private DummyClaireNotifiable {
       std::lock_guard<std::mutex> lock(keepalive_mutex_);
       karl_ = new_karl_locator;
       karl_keepalive_route_ = KarlKeepaliveRoute(karl_, codename_, port_);
+      acknowledged_keepalive_fields_.clear();  // The new Karl has no keepalives to apply the deltas to.
       notifiable_ref_.OnKarlLocatorChanged(new_karl_locator);
     }
     ForceSendKeepalive(wait_for_keepalive);
@@ -358,9 +382,21 @@ class GenericClaire final : private DummyClaireNotifiable {
   // Sends a keepalive message to Karl.
   // Blocking, and can throw.
   // Possibly via a custom `route`: adding "&confirm", for example, would require Karl to crawl Claire back.
+  //
+  // Via the regular route, the keepalives are delta-encoded. Each keepalive carries its sequence number, `&seq`.
+  // Once Karl has acknowledged a keepalive, with the `kKeepaliveDeltasAcceptedHeader` header, which older Karl-s do
+  // not send, the next one only carries the top-level fields that have changed since, along with the sequence
+  // number of the acknowledged keepalive it is the delta against, `&base`. Should Karl not accept the delta, be it
+  // "409 Conflict" as Karl does not have that keepalive, for instance, having restarted, or any other error,
+  // the full keepalive is sent right away.
   void SendKeepaliveToKarl(std::unique_lock<std::mutex>&, const std::string& route) {
     // Basically, throw in case of any error, and throw only one type: `ClaireRegistrationException`.
-    const auto keepalive_body = GenerateKeepaliveStatus();
+    const auto keepalive_status = GenerateKeepaliveStatus();
+    const bool delta_encoded = (route == karl_keepalive_route_);
+    std::map<std::string, std::string> keepalive_fields;
+    if (delta_encoded) {
+      KeepaliveFieldsAsJSON<specific_status_t>::Collect(keepalive_status, keepalive_fields);
+    }
 
     std::string error_message = "";
 
@@ -372,7 +408,46 @@ class GenericClaire final : private DummyClaireNotifiable {
         last_keepalive_attempt_result_.http_code = static_cast<uint16_t>(net::HTTPResponseCodeValue::InvalidCode);
       }
 
-      const auto code = HTTP(POST(route, keepalive_body)).code;
+      const uint64_t sequence_number = ++keepalive_sequence_number_;
+      const auto send_keepalive = [&](bool as_delta) {
+        if (!delta_encoded) {
+          return HTTP(POST(route, keepalive_status));
+        } else if (!as_delta) {
+          return HTTP(POST(route + "&seq=" + current::ToString(sequence_number), keepalive_status));
+        } else {
+          std::string delta = "{";
+          for (const auto& field : keepalive_fields) {
+            const auto cit = acknowledged_keepalive_fields_.find(field.first);
+            if (cit == acknowledged_keepalive_fields_.end() || cit->second != field.second) {
+              if (delta.length() > 1u) {
+                delta += ',';
+              }
+              delta += '"' + field.first + "\":" + field.second;
+            }
+          }
+          delta += '}';
+          return HTTP(POST(route + "&seq=" + current::ToString(sequence_number) + "&base=" +
+                               current::ToString(acknowledged_keepalive_sequence_number_) + "&delta",
+                           delta,
+                           net::constants::kDefaultJSONContentType));
+        }
+      };
+
+      const bool as_delta = delta_encoded && !acknowledged_keepalive_fields_.empty();
+      auto response = send_keepalive(as_delta);
+      if (as_delta && !(static_cast<int>(response.code) >= 200 && static_cast<int>(response.code) <= 299)) {
+        // Karl has not accepted the delta, resync.
+        acknowledged_keepalive_fields_.clear();
+        response = send_keepalive(false);
+      }
+      const auto code = response.code;
+      if (delta_encoded && static_cast<int>(code) >= 200 && static_cast<int>(code) <= 299 &&
+          response.headers.Has(constants::kKeepaliveDeltasAcceptedHeader)) {
+        acknowledged_keepalive_fields_ = std::move(keepalive_fields);
+        acknowledged_keepalive_sequence_number_ = sequence_number;
+      } else {
+        acknowledged_keepalive_fields_.clear();
+      }
 
       {
         std::lock_guard<std::mutex> lock(status_mutex_);
@@ -380,7 +455,12 @@ class GenericClaire final : private DummyClaireNotifiable {
           // Success. And anything else is failure.
           last_keepalive_attempt_result_.status = KeepaliveAttemptStatus::Success;
           last_successful_keepalive_timestamp_ = last_keepalive_attempt_result_.timestamp;
-          last_successful_keepalive_ping_ = current::time::Now() - last_keepalive_attempt_result_.timestamp;
+          // Karl persists keepalives in batches. Exclude the time this one has been waiting for its batch,
+          // so that the ping, and the time skew Karl derives from it, reflect the network round trip.
+          const std::chrono::microseconds queued_for(
+              current::FromString<int64_t>(response.headers.GetOrDefault(constants::kKeepaliveQueuedForHeader, "0")));
+          const auto round_trip = current::time::Now() - last_keepalive_attempt_result_.timestamp;
+          last_successful_keepalive_ping_ = std::max(std::chrono::microseconds(0), round_trip - queued_for);
           return;
         } else {
           last_keepalive_attempt_result_.status = KeepaliveAttemptStatus::ErrorCodeReturned;
@@ -388,6 +468,7 @@ class GenericClaire final : private DummyClaireNotifiable {
         }
       }
     } catch (const current::Exception& e) {
+      acknowledged_keepalive_fields_.clear();  // Whether Karl has received the keepalive is unknown.
       last_keepalive_attempt_result_.status = KeepaliveAttemptStatus::CouldNotConnect;
       error_message = e.DetailedDescription();
     }
@@ -549,6 +630,11 @@ class GenericClaire final : private DummyClaireNotifiable {
   std::thread keepalive_thread_;
 
   bool keepalive_sent_ = false;  // For `ForceSendKeepalive(wait == ForceSendKeepaliveWaitRequest::Wait)`. -- D.K.
+
+  // The state of the delta-encoded keepalives, see `SendKeepaliveToKarl()`. Guarded by `keepalive_mutex_`.
+  uint64_t keepalive_sequence_number_ = 0u;
+  uint64_t acknowledged_keepalive_sequence_number_ = 0u;
+  std::map<std::string, std::string> acknowledged_keepalive_fields_;  // Empty if the next keepalive is a full one.
 };
 
 using Claire = GenericClaire<Variant<default_user_status::status>>;
@@ -34,6 +34,12 @@ namespace constants {
 constexpr static uint16_t kDefaultKarlPort = 7576;           // ASCII { 'K', 'L' }.
 constexpr static uint16_t kDefaultKarlFleetViewPort = 7577;  // ASCII { 'K', 'M' }.
 
+// The HTTP header in which Karl reports how long, in microseconds, has a keepalive been waiting to be persisted.
+constexpr static const char* kKeepaliveQueuedForHeader = "X-Current-Karl-Keepalive-Queued-For-Us";
+
+// The HTTP header with which Karl acknowledges a keepalive carrying `&seq`, for Claire to send the deltas against it.
+constexpr static const char* kKeepaliveDeltasAcceptedHeader = "X-Current-Karl-Keepalive-Deltas-Accepted";
+
 }  // namespace current::karl::constants
 }  // namespace current::karl
 }  // namespace current
@@ -27,8 +27,10 @@ SOFTWARE.
 // Karl's storage model contains of the following pieces:
 //
 // 1) The Stream `Stream` of all keepalives received. Persisted on disk, not stored in memory.
-//    Each "visualize production" request (be it JSON or SVG response) replays that stream over the desired
-//    period of time. Most commonly it's the past five minutes.
+//    Karl keeps the most recent keepalives from each service, over the past `fleet_view_window`, in memory,
+//    so that "visualize production" requests (be it JSON or SVG response) up to the present moment are served
+//    from there. Most commonly it's the past five minutes. Requests reaching further into the past, or ending
+//    before the present moment, replay the stream over the desired period of time.
 //
 // 2) The `Storage`, over a separate stream, to retain the information which may be required outside the
 //    "visualized" time window. Includes Karl's launch history, and per-service codename -> build::BuildInfo.
@@ -81,6 +83,119 @@ CURRENT_STRUCT_T(KarlPersistedKeepalive) {
   CURRENT_FIELD(keepalive, T);
 };
 
+// The most recent keepalive per codename, and the most recent codename per location, over a sliding time window.
+// Kept up to date by Karl's own subscription to its stream of keepalives, so that the fleet view is built
+// in O(services), instead of replaying the persisted stream on each request.
+// The view is exact for the `[from, now]` range as long as `from` is within the window, see `TrySnapshot()`.
+template <typename PERSISTED_KEEPALIVE>
+class KarlFleetViewAggregate {
+ public:
+  struct Snapshot {
+    // The most recent keepalive from each codename, along with its timestamp.
+    std::vector<std::pair<std::chrono::microseconds, std::shared_ptr<const PERSISTED_KEEPALIVE>>> keepalives;
+    // The codename of the most recent keepalive from each location.
+    std::map<ClaireServiceKey, std::string> codename_per_location;
+  };
+
+  // Starts from the keepalives received within `window` from now, as the older ones would be evicted anyway.
+  template <typename PERSISTER>
+  KarlFleetViewAggregate(std::chrono::microseconds window, const PERSISTER& persister)
+      : window_(window),
+        since_(current::time::Now() - window),
+        next_index_(std::min(persister.IndexRangeByTimestampRange(since_, std::chrono::microseconds(0)).first,
+                             persister.Size())) {}
+
+  uint64_t BeginIndex() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return next_index_;
+  }
+
+  // Waits, for up to `timeout`, until the keepalives up to `stream_size` have been applied, and, if `from` is
+  // within the window, returns the state of the fleet as the replay of the stream over `[from, to]` would see it.
+  // Returns false if the view is not exact, in which case the caller should replay the stream instead.
+  // This includes the case of keepalives after `to` having been applied already, as the view only keeps
+  // the most recent keepalive from each codename, and not the one before `to`.
+  bool TrySnapshot(std::chrono::microseconds from,
+                   std::chrono::microseconds to,
+                   uint64_t stream_size,
+                   Snapshot& output,
+                   std::chrono::milliseconds timeout = std::chrono::milliseconds(1000)) const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (from < since_) {
+      return false;
+    }
+    if (!caught_up_.wait_for(lock, timeout, [this, stream_size]() { return next_index_ >= stream_size; })) {
+      return false;
+    }
+    if (last_applied_ > to) {
+      return false;
+    }
+    output.keepalives.clear();
+    output.codename_per_location.clear();
+    for (const auto& codename_and_keepalive : latest_per_codename_) {
+      if (codename_and_keepalive.second.first >= from) {
+        output.keepalives.push_back(codename_and_keepalive.second);
+      }
+    }
+    for (const auto& location_and_codename : latest_per_location_) {
+      if (location_and_codename.second.first >= from) {
+        output.codename_per_location[location_and_codename.first] = location_and_codename.second.second;
+      }
+    }
+    return true;
+  }
+
+  ss::EntryResponse operator()(const PERSISTED_KEEPALIVE& e, idxts_t current, idxts_t) {
+    auto keepalive = std::make_shared<const PERSISTED_KEEPALIVE>(e);
+    std::lock_guard<std::mutex> lock(mutex_);
+    latest_per_codename_[e.keepalive.codename] = std::make_pair(current.us, std::move(keepalive));
+    latest_per_location_[e.location] = std::make_pair(current.us, e.keepalive.codename);
+    // Evict the codenames and locations not heard from within the window, amortized over 1/8th of it.
+    const auto cutoff = current.us - window_;
+    if (cutoff - since_ >= window_ / 8) {
+      EvictOlderThan(cutoff);
+    }
+    next_index_ = current.index + 1u;
+    last_applied_ = current.us;
+    caught_up_.notify_all();
+    return ss::EntryResponse::More;
+  }
+
+  ss::EntryResponse operator()(std::chrono::microseconds) const { return ss::EntryResponse::More; }
+  static ss::EntryResponse EntryResponseIfNoMorePassTypeFilter() { return ss::EntryResponse::More; }
+  static ss::TerminationResponse Terminate() { return ss::TerminationResponse::Terminate; }
+
+ private:
+  // Must be called with `mutex_` locked.
+  void EvictOlderThan(std::chrono::microseconds cutoff) {
+    for (auto it = latest_per_codename_.begin(); it != latest_per_codename_.end();) {
+      if (it->second.first < cutoff) {
+        it = latest_per_codename_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    for (auto it = latest_per_location_.begin(); it != latest_per_location_.end();) {
+      if (it->second.first < cutoff) {
+        it = latest_per_location_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    since_ = cutoff;
+  }
+
+  const std::chrono::microseconds window_;
+  mutable std::mutex mutex_;
+  mutable std::condition_variable caught_up_;
+  std::chrono::microseconds since_;  // Nothing from before this moment is reflected in the view.
+  uint64_t next_index_;              // The index of the next keepalive in the stream to apply.
+  std::chrono::microseconds last_applied_ = std::chrono::microseconds(-1);  // The timestamp of the previous one.
+  std::unordered_map<std::string, std::pair<std::chrono::microseconds, std::shared_ptr<const PERSISTED_KEEPALIVE>>>
+      latest_per_codename_;
+  std::map<ClaireServiceKey, std::pair<std::chrono::microseconds, std::string>> latest_per_location_;
+};
+
 template <class STORAGE>
 class KarlNginxManager {
  protected:
@@ -218,6 +333,8 @@ class GenericKarl final : private KarlStorage<STORAGE_TYPE>,
   using karl_status_t = GenericKarlStatus<runtime_status_variant_t>;
   using persisted_keepalive_t = KarlPersistedKeepalive<claire_status_t>;
   using stream_t = stream::Stream<persisted_keepalive_t, current::persistence::File>;
+  using fleet_view_aggregate_t =
+      ss::StreamSubscriber<KarlFleetViewAggregate<persisted_keepalive_t>, persisted_keepalive_t>;
   using storage_t = typename KarlStorage<STORAGE_TYPE>::storage_t;
   using karl_notifiable_t = IKarlNotifiable<runtime_status_variant_t>;
   using fleet_view_renderer_t = IKarlFleetViewRenderer<runtime_status_variant_t>;
@@ -272,13 +389,19 @@ class GenericKarl final : private KarlStorage<STORAGE_TYPE>,
                                : parameters_.public_url),
         notifiable_ref_(notifiable),
         fleet_view_renderer_ref_(renderer),
+        keepalives_ingestion_thread_running_(true),
         keepalives_stream_(stream_t::CreateStream(parameters_.stream_persistence_file)),
+        fleet_view_aggregate_(parameters_.fleet_view_window, *keepalives_stream_->Data()),
+        fleet_view_aggregate_scope_(
+            keepalives_stream_->template Subscribe<persisted_keepalive_t>(fleet_view_aggregate_,
+                                                                          fleet_view_aggregate_.BeginIndex())),
         state_update_thread_running_(false),
         state_update_thread_force_wakeup_(false),
         state_update_thread_([this]() {
           state_update_thread_running_ = true;
           StateUpdateThread();
         }),
+        keepalives_ingestion_thread_([this]() { KeepalivesIngestionThread(); }),
         http_scope_(HTTP(parameters_.keepalives_port)
                         .Register(parameters_.keepalives_url,
                                   URLPathArgs::CountMask::None | URLPathArgs::CountMask::One,
@@ -335,7 +458,13 @@ class GenericKarl final : private KarlStorage<STORAGE_TYPE>,
 
  public:
   ~GenericKarl() {
-    destructing_ = true;
+    {
+      std::lock_guard<std::mutex> lock(pending_keepalives_mutex_);
+      destructing_ = true;
+      pending_keepalives_condition_variable_.notify_one();
+    }
+    // Persist and acknowledge the keepalives accepted so far before reporting this Karl as down.
+    keepalives_ingestion_thread_.join();
     storage_->ReadWriteTransaction([this](MutableFields<storage_t> fields) {
       KarlInfo self_info;
       self_info.up = false;
@@ -367,6 +496,22 @@ class GenericKarl final : private KarlStorage<STORAGE_TYPE>,
   Borrowed<storage_t> BorrowStorage() const { return storage_; }
 
  private:
+  // A keepalive accepted from a Claire, to be persisted and responded to with its batch.
+  struct PendingKeepalive {
+    Request request;
+    std::chrono::steady_clock::time_point received;
+    std::chrono::microseconds now;
+    ClaireServiceKey location;
+    ClaireStatus parsed_status;
+    claire_status_t detailed_parsed_status;
+    Optional<std::chrono::microseconds> optional_behind_this_by;
+    bool accepts_deltas = false;  // Whether this keepalive can be the base for the next, delta-encoded one.
+
+    explicit PendingKeepalive(Request&& request)
+        : request(std::move(request)), received(std::chrono::steady_clock::now()) {}
+    PendingKeepalive(PendingKeepalive&&) = default;
+  };
+
   void StateUpdateThread() {
     while (!destructing_) {
       const auto now = current::time::Now();
@@ -385,6 +530,12 @@ class GenericKarl final : private KarlStorage<STORAGE_TYPE>,
         }
       }
       if (!timeouted_codenames.empty()) {
+        {
+          std::lock_guard<std::mutex> lock(keepalive_delta_bases_mutex_);
+          for (const auto& codename : timeouted_codenames) {
+            keepalive_delta_bases_.erase(codename);
+          }
+        }
         auto& notifiable_ref = notifiable_ref_;
         storage_->ReadWriteTransaction([&timeouted_codenames, now, &notifiable_ref](MutableFields<storage_t> fields)
                                            -> void {
@@ -474,6 +625,10 @@ class GenericKarl final : private KarlStorage<STORAGE_TYPE>,
           state_update_thread_force_wakeup_ = true;
           update_thread_condition_variable_.notify_one();
         }
+        {
+          std::lock_guard<std::mutex> lock(keepalive_delta_bases_mutex_);
+          keepalive_delta_bases_.erase(codename);
+        }
       } else {
         // Respond with "200 OK" in any case.
         r("NOP\n");
@@ -494,170 +649,42 @@ class GenericKarl final : private KarlStorage<STORAGE_TYPE>,
           }
         }();
 
-        const auto parsed_status = ParseJSON<ClaireStatus>(json);
+        // A delta-encoded keepalive is applied to the previous one from the same Claire, see `GenericClaire`.
+        const bool delta_encoded = qs.has("delta");
+        ClaireStatus parsed_status;
+        claire_status_t detailed_parsed_status;
+        if (delta_encoded) {
+          if (!ApplyKeepaliveDelta(r.url, json, parsed_status, detailed_parsed_status)) {
+            r("Keepalive resync required.\n", HTTPResponseCode.Conflict);
+            return;
+          }
+        } else {
+          parsed_status = ParseJSON<ClaireStatus>(json);
+          detailed_parsed_status = ParseDetailedKeepalive(json, parsed_status);
+        }
         if ((!qs.has("codename") || parsed_status.codename == qs["codename"]) &&
             (!qs.has("port") || parsed_status.local_port == current::FromString<uint16_t>(qs["port"]))) {
+          if (!delta_encoded) {
+            RememberKeepaliveAsDeltaBase(r.url, parsed_status, detailed_parsed_status);
+          }
+          const bool accepts_deltas = qs.has("seq");
+
           ClaireServiceKey location;
           location.ip = remote_ip;
           location.port = parsed_status.local_port;
           location.prefix = "/";  // TODO(dkorolev) + TODO(mzhurovich): Add support for `qs["prefix"]`.
 
-          // If the received status can be parsed in detail, including the "runtime" variant, persist it.
-          // If no, no big deal, keep the top-level one regardless.
-          const auto detailed_parsed_status = [&]() -> claire_status_t {
-            Optional<claire_status_t> parsed_opt = TryParseJSON<claire_status_t>(json);
-            if (!Exists(parsed_opt)) {  // Can't parse in Current format. Trying `Minimalistic`.
-              parsed_opt = TryParseJSON<claire_status_t, JSONFormat::Minimalistic>(json);
-            }
-            if (Exists(parsed_opt)) {
-              return Value(parsed_opt);
-            } else {
-
-#ifdef EXTRA_KARL_LOGGING
-              std::cerr << "Could not parse: " << json << '\n';
-              reflection::StructSchema struct_schema;
-              struct_schema.AddType<claire_status_t>();
-              std::cerr << "As:\n" << struct_schema.GetSchemaInfo().Describe<reflection::Language::Current>() << '\n';
-#endif
-
-              claire_status_t status;
-              // Initialize `ClaireStatus` from `ClaireServiceStatus`, keep the `Variant<...> runtime` empty.
-              static_cast<ClaireStatus&>(status) = parsed_status;
-              return status;
-            }
-          }();
-
-          const auto now = current::time::Now();
-
-          {
-            persisted_keepalive_t record;
-            record.location = location;
-            record.keepalive = detailed_parsed_status;
-            {
-              std::lock_guard<std::mutex> lock(latest_keepalive_index_mutex_);
-              latest_keepalive_index_plus_one_[parsed_status.codename] =
-                  keepalives_stream_->Publisher()->Publish(std::move(record)).index;
-            }
-          }
-
-          Optional<std::chrono::microseconds> optional_behind_this_by;
+          PendingKeepalive keepalive(std::move(r));
+          keepalive.now = current::time::Now();
+          keepalive.location = location;
+          keepalive.parsed_status = parsed_status;
+          keepalive.detailed_parsed_status = detailed_parsed_status;
+          keepalive.accepts_deltas = accepts_deltas;
           if (Exists(parsed_status.last_successful_keepalive_ping_us)) {
-            optional_behind_this_by =
-                now - parsed_status.now - Value(parsed_status.last_successful_keepalive_ping_us) / 2;
-          }
-
-          auto& notifiable_ref = notifiable_ref_;
-          storage_->ReadWriteTransaction(
-                        [this,
-                         now,
-                         location,
-                         &parsed_status,
-                         &detailed_parsed_status,
-                         optional_behind_this_by,
-                         &notifiable_ref](MutableFields<storage_t> fields) -> Response {
-                          // OK to call from within a transaction.
-                          // The call is fast, and `storage_`'s transaction guarantees thread safety. -- D.K.
-                          notifiable_ref.OnKeepalive(now, location, parsed_status.codename, detailed_parsed_status);
-
-                          const auto& service = parsed_status.service;
-                          const auto& codename = parsed_status.codename;
-                          const auto& optional_build = parsed_status.build;
-                          const auto& optional_instance = parsed_status.cloud_instance_name;
-                          const auto& optional_av_group = parsed_status.cloud_availability_group;
-
-                          // Update per-server information in the `DB`.
-                          ServerInfo server;
-                          server.ip = location.ip;
-                          bool need_to_update_server_info = false;
-                          const ImmutableOptional<ServerInfo> current_server_info = fields.servers[location.ip];
-                          if (Exists(current_server_info)) {
-                            server = Value(current_server_info);
-                          }
-                          // Check the instance name.
-                          if (Exists(optional_instance)) {
-                            if (!Exists(server.cloud_instance_name) ||
-                                Value(server.cloud_instance_name) != Value(optional_instance)) {
-                              server.cloud_instance_name = Value(optional_instance);
-                              need_to_update_server_info = true;
-                            }
-                          }
-                          // Check the availability group.
-                          if (Exists(optional_av_group)) {
-                            if (!Exists(server.cloud_availability_group) ||
-                                Value(server.cloud_availability_group) != Value(optional_av_group)) {
-                              server.cloud_availability_group = Value(optional_av_group);
-                              need_to_update_server_info = true;
-                            }
-                          }
-                          // Check the time skew.
-                          if (Exists(optional_behind_this_by)) {
-                            const std::chrono::microseconds behind_this_by = Value(optional_behind_this_by);
-                            const auto time_skew_difference = server.behind_this_by - behind_this_by;
-                            if (static_cast<uint64_t>(std::abs(time_skew_difference.count())) >=
-                                kUpdateServerInfoThresholdByTimeSkewDifference) {
-                              server.behind_this_by = behind_this_by;
-                              need_to_update_server_info = true;
-                            }
-                          }
-                          if (need_to_update_server_info) {
-                            fields.servers.Add(server);
-                          }
-
-                          // Update the `DB` if the build information was not stored there yet.
-                          const ImmutableOptional<ClaireBuildInfo> current_claire_build_info = fields.builds[codename];
-                          if (Exists(optional_build) &&
-                              (!Exists(current_claire_build_info) ||
-                               Value(current_claire_build_info).build != Value(optional_build))) {
-                            ClaireBuildInfo build;
-                            build.codename = codename;
-                            build.build = Value(optional_build);
-                            fields.builds.Add(build);
-                          }
-
-                          // Update the `DB` if "codename", "location", or "dependencies" differ.
-                          const ImmutableOptional<ClaireInfo> current_claire_info = fields.claires[codename];
-                          if ([&]() {
-                                if (!Exists(current_claire_info)) {
-                                  return true;
-                                } else if (Value(current_claire_info).location != location) {
-                                  return true;
-                                } else if (Value(current_claire_info).registered_state !=
-                                           ClaireRegisteredState::Active) {
-                                  return true;
-                                } else {
-                                  return false;
-                                }
-                              }()) {
-                            ClaireInfo claire;
-                            if (Exists(current_claire_info)) {
-                              // Do not overwrite `build` with `null`.
-                              claire = Value(current_claire_info);
-                            }
-
-                            claire.codename = codename;
-                            claire.service = service;
-                            claire.location = location;
-                            claire.reported_timestamp = now;
-                            claire.url_status_page_direct = location.StatusPageURL();
-                            claire.registered_state = ClaireRegisteredState::Active;
-
-                            fields.claires.Add(claire);
-                          }
-                          return Response("OK\n");
-                        },
-                        std::move(r)).Wait();
-          {
-            std::lock_guard<std::mutex> lock(services_keepalive_cache_mutex_);
-            auto& placeholder = services_keepalive_time_cache_[parsed_status.codename];
-            if (placeholder.count() == 0) {
-              placeholder = now;
-              // Wake up state update thread only if the new codename has appeared in the cache.
-              state_update_thread_force_wakeup_ = true;
-              update_thread_condition_variable_.notify_one();
-            } else {
-              placeholder = now;
-            }
+            keepalive.optional_behind_this_by =
+                keepalive.now - parsed_status.now - Value(parsed_status.last_successful_keepalive_ping_us) / 2;
           }
+          EnqueueKeepalive(std::move(keepalive));
         } else {
           r("Inconsistent URL/body parameters.\n", HTTPResponseCode.BadRequest);
         }
@@ -671,6 +698,283 @@ class GenericKarl final : private KarlStorage<STORAGE_TYPE>,
     }
   }
 
+  // If the received status can be parsed in detail, including the "runtime" variant, persist it.
+  // If no, no big deal, keep the top-level one regardless.
+  claire_status_t ParseDetailedKeepalive(const std::string& json, const ClaireStatus& parsed_status) const {
+    Optional<claire_status_t> parsed_opt = TryParseJSON<claire_status_t>(json);
+    if (!Exists(parsed_opt)) {  // Can't parse in Current format. Trying `Minimalistic`.
+      parsed_opt = TryParseJSON<claire_status_t, JSONFormat::Minimalistic>(json);
+    }
+    if (Exists(parsed_opt)) {
+      return Value(parsed_opt);
+    } else {
+
+#ifdef EXTRA_KARL_LOGGING
+      std::cerr << "Could not parse: " << json << '\n';
+      reflection::StructSchema struct_schema;
+      struct_schema.AddType<claire_status_t>();
+      std::cerr << "As:\n" << struct_schema.GetSchemaInfo().Describe<reflection::Language::Current>() << '\n';
+#endif
+
+      claire_status_t status;
+      // Initialize `ClaireStatus` from `ClaireServiceStatus`, keep the `Variant<...> runtime` empty.
+      static_cast<ClaireStatus&>(status) = parsed_status;
+      return status;
+    }
+  }
+
+  // Keeps the most recent full keepalive, along with its sequence number, for the next delta to be applied to.
+  // The full keepalives without `&seq` are not followed by deltas.
+  void RememberKeepaliveAsDeltaBase(const url::URL& url,
+                                    const ClaireStatus& parsed_status,
+                                    const claire_status_t& detailed_parsed_status) {
+    const auto& qs = url.query;
+    std::lock_guard<std::mutex> lock(keepalive_delta_bases_mutex_);
+    if (qs.has("seq")) {
+      auto& base = keepalive_delta_bases_[parsed_status.codename];
+      base.sequence_number = current::FromString<uint64_t>(qs["seq"]);
+      base.parsed_status = parsed_status;
+      base.detailed_parsed_status = detailed_parsed_status;
+    } else {
+      keepalive_delta_bases_.erase(parsed_status.codename);
+    }
+  }
+
+  // Reconstructs the full keepalive from the delta, which only carries the changed top-level fields,
+  // and the keepalive it is the delta against. Only the delta itself is parsed.
+  // Returns `false` if Karl does not have that keepalive, for the Claire to send the full one.
+  bool ApplyKeepaliveDelta(const url::URL& url,
+                           const std::string& delta,
+                           ClaireStatus& parsed_status,
+                           claire_status_t& detailed_parsed_status) {
+    const auto& qs = url.query;
+    if (!qs.has("codename") || !qs.has("seq") || !qs.has("base")) {
+      return false;
+    }
+    std::lock_guard<std::mutex> lock(keepalive_delta_bases_mutex_);
+    const auto it = keepalive_delta_bases_.find(qs["codename"]);
+    if (it == keepalive_delta_bases_.end() ||
+        it->second.sequence_number != current::FromString<uint64_t>(qs["base"])) {
+      return false;
+    }
+    auto& base = it->second;
+    parsed_status = base.parsed_status;
+    detailed_parsed_status = base.detailed_parsed_status;
+    try {
+      PatchObjectWithJSON(parsed_status, delta);
+    } catch (const TypeSystemParseJSONException&) {
+      keepalive_delta_bases_.erase(it);
+      return false;
+    }
+    try {
+      PatchObjectWithJSON(detailed_parsed_status, delta);
+    } catch (const TypeSystemParseJSONException&) {
+      detailed_parsed_status = claire_status_t(parsed_status);
+    }
+    base.sequence_number = current::FromString<uint64_t>(qs["seq"]);
+    base.parsed_status = parsed_status;
+    base.detailed_parsed_status = detailed_parsed_status;
+    return true;
+  }
+
+  // Keepalives are persisted in batches, one stream publish run and one storage transaction per batch,
+  // flushed every `keepalives_batch_interval`, or once `keepalives_batch_size` of them have been accepted.
+  // Each keepalive is responded to once its batch is persisted, so Claire-s get the very same acknowledgement.
+  // The time spent waiting for the batch is reported back in a header, for Claire to exclude from the ping.
+  void EnqueueKeepalive(PendingKeepalive&& keepalive) {
+    std::lock_guard<std::mutex> lock(pending_keepalives_mutex_);
+    if (!keepalives_ingestion_thread_running_) {
+      keepalive.request("Karl is shutting down.\n", HTTPResponseCode.ServiceUnavailable);
+      return;
+    }
+    if (pending_keepalives_.empty()) {
+      pending_keepalives_deadline_ = keepalive.received + parameters_.keepalives_batch_interval;
+    }
+    pending_keepalives_.push_back(std::move(keepalive));
+    if (pending_keepalives_.size() == 1u || pending_keepalives_.size() >= parameters_.keepalives_batch_size) {
+      pending_keepalives_condition_variable_.notify_one();
+    }
+  }
+
+  void KeepalivesIngestionThread() {
+    std::unique_lock<std::mutex> lock(pending_keepalives_mutex_);
+    while (true) {
+      if (pending_keepalives_.empty()) {
+        if (destructing_) {
+          break;
+        }
+        pending_keepalives_condition_variable_.wait(lock);
+      } else if (!destructing_ && pending_keepalives_.size() < parameters_.keepalives_batch_size &&
+                 std::chrono::steady_clock::now() < pending_keepalives_deadline_) {
+        pending_keepalives_condition_variable_.wait_until(lock, pending_keepalives_deadline_);
+      } else {
+        std::vector<PendingKeepalive> batch;
+        batch.swap(pending_keepalives_);
+        lock.unlock();
+        PersistKeepalives(batch);
+        lock.lock();
+      }
+    }
+    keepalives_ingestion_thread_running_ = false;
+  }
+
+  // The keepalives are published into the stream only once the storage transaction has been committed, so that
+  // the stream, and the fleet view built from it, never has what the storage does not. The opposite may still
+  // happen, if publishing fails after the commit, in which case the keepalives are responded to with an error,
+  // for the Claire-s to resend them.
+  void PersistKeepalives(std::vector<PendingKeepalive>& batch) {
+    bool persisted = false;
+    try {
+      if (WasCommitted(storage_->ReadWriteTransaction([this, &batch](MutableFields<storage_t> fields) {
+            for (const auto& keepalive : batch) {
+              PersistKeepalive(fields, keepalive);
+            }
+          }).Go())) {
+        std::lock_guard<std::mutex> lock(latest_keepalive_index_mutex_);
+        for (const auto& keepalive : batch) {
+          persisted_keepalive_t record;
+          record.location = keepalive.location;
+          record.keepalive = keepalive.detailed_parsed_status;
+          // Timestamp the keepalive with the time it was received, not the time its batch is persisted.
+          const auto us =
+              std::max(keepalive.now, keepalives_stream_->Data()->CurrentHead() + std::chrono::microseconds(1));
+          latest_keepalive_index_plus_one_[keepalive.parsed_status.codename] =
+              keepalives_stream_->Publisher()->Publish(std::move(record), us).index;
+        }
+        persisted = true;
+      } else {
+        std::cerr << "Karl could not persist a batch of " << batch.size() << " keepalive(s): rolled back.\n";
+      }
+    } catch (const Exception& e) {
+      std::cerr << "Karl could not persist a batch of " << batch.size() << " keepalive(s): " << e.DetailedDescription()
+                << '\n';
+    }
+
+    // Update the cache before responding, so that whoever has been acknowledged sees their service as active.
+    if (persisted) {
+      std::lock_guard<std::mutex> lock(services_keepalive_cache_mutex_);
+      for (const auto& keepalive : batch) {
+        auto& placeholder = services_keepalive_time_cache_[keepalive.parsed_status.codename];
+        if (placeholder.count() == 0) {
+          placeholder = keepalive.now;
+          // Wake up state update thread only if the new codename has appeared in the cache.
+          state_update_thread_force_wakeup_ = true;
+          update_thread_condition_variable_.notify_one();
+        } else {
+          placeholder = keepalive.now;
+        }
+      }
+    }
+
+    for (auto& keepalive : batch) {
+      if (persisted) {
+        const auto queued_for = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - keepalive.received);
+        Response response("OK\n");
+        response.SetHeader(constants::kKeepaliveQueuedForHeader, current::ToString(queued_for.count()));
+        if (keepalive.accepts_deltas) {
+          response.SetHeader(constants::kKeepaliveDeltasAcceptedHeader, "1");
+        }
+        keepalive.request(std::move(response));
+      } else {
+        keepalive.request("Karl registration error.\n", HTTPResponseCode.InternalServerError);
+      }
+    }
+  }
+
+  void PersistKeepalive(MutableFields<storage_t>& fields, const PendingKeepalive& keepalive) {
+    const auto now = keepalive.now;
+    const auto& location = keepalive.location;
+    const auto& parsed_status = keepalive.parsed_status;
+    const auto& optional_behind_this_by = keepalive.optional_behind_this_by;
+
+    // OK to call from within a transaction.
+    // The call is fast, and `storage_`'s transaction guarantees thread safety. -- D.K.
+    notifiable_ref_.OnKeepalive(now, location, parsed_status.codename, keepalive.detailed_parsed_status);
+
+    const auto& service = parsed_status.service;
+    const auto& codename = parsed_status.codename;
+    const auto& optional_build = parsed_status.build;
+    const auto& optional_instance = parsed_status.cloud_instance_name;
+    const auto& optional_av_group = parsed_status.cloud_availability_group;
+
+    // Update per-server information in the `DB`.
+    ServerInfo server;
+    server.ip = location.ip;
+    bool need_to_update_server_info = false;
+    const ImmutableOptional<ServerInfo> current_server_info = fields.servers[location.ip];
+    if (Exists(current_server_info)) {
+      server = Value(current_server_info);
+    }
+    // Check the instance name.
+    if (Exists(optional_instance)) {
+      if (!Exists(server.cloud_instance_name) || Value(server.cloud_instance_name) != Value(optional_instance)) {
+        server.cloud_instance_name = Value(optional_instance);
+        need_to_update_server_info = true;
+      }
+    }
+    // Check the availability group.
+    if (Exists(optional_av_group)) {
+      if (!Exists(server.cloud_availability_group) ||
+          Value(server.cloud_availability_group) != Value(optional_av_group)) {
+        server.cloud_availability_group = Value(optional_av_group);
+        need_to_update_server_info = true;
+      }
+    }
+    // Check the time skew.
+    if (Exists(optional_behind_this_by)) {
+      const std::chrono::microseconds behind_this_by = Value(optional_behind_this_by);
+      const auto time_skew_difference = server.behind_this_by - behind_this_by;
+      if (static_cast<uint64_t>(std::abs(time_skew_difference.count())) >=
+          kUpdateServerInfoThresholdByTimeSkewDifference) {
+        server.behind_this_by = behind_this_by;
+        need_to_update_server_info = true;
+      }
+    }
+    if (need_to_update_server_info) {
+      fields.servers.Add(server);
+    }
+
+    // Update the `DB` if the build information was not stored there yet.
+    const ImmutableOptional<ClaireBuildInfo> current_claire_build_info = fields.builds[codename];
+    if (Exists(optional_build) &&
+        (!Exists(current_claire_build_info) || Value(current_claire_build_info).build != Value(optional_build))) {
+      ClaireBuildInfo build;
+      build.codename = codename;
+      build.build = Value(optional_build);
+      fields.builds.Add(build);
+    }
+
+    // Update the `DB` if "codename", "location", or "dependencies" differ.
+    const ImmutableOptional<ClaireInfo> current_claire_info = fields.claires[codename];
+    if ([&]() {
+          if (!Exists(current_claire_info)) {
+            return true;
+          } else if (Value(current_claire_info).location != location) {
+            return true;
+          } else if (Value(current_claire_info).registered_state != ClaireRegisteredState::Active) {
+            return true;
+          } else {
+            return false;
+          }
+        }()) {
+      ClaireInfo claire;
+      if (Exists(current_claire_info)) {
+        // Do not overwrite `build` with `null`.
+        claire = Value(current_claire_info);
+      }
+
+      claire.codename = codename;
+      claire.service = service;
+      claire.location = location;
+      claire.reported_timestamp = now;
+      claire.url_status_page_direct = location.StatusPageURL();
+      claire.registered_state = ClaireRegisteredState::Active;
+
+      fields.claires.Add(claire);
+    }
+  }
+
   void ServeFleetStatus(Request r) {
     const auto& qs = r.url.query;
     if (qs.has("schema")) {
@@ -808,37 +1112,53 @@ class GenericKarl final : private KarlStorage<STORAGE_TYPE>,
     std::map<std::string, std::set<std::string>> codenames_per_service;
     std::map<ClaireServiceKey, std::string> service_key_into_codename;
 
-    CURRENT_ASSERT(to >= from);
-    const auto& keepalives_data(keepalives_stream_->Data());
-    for (const auto& e : keepalives_data->Iterate(from, to)) {
-      const claire_status_t& keepalive = e.entry.keepalive;
+    const auto add_keepalive = [&](const persisted_keepalive_t& entry, std::chrono::microseconds us) {
+      const claire_status_t& keepalive = entry.keepalive;
 
       codenames_to_resolve.insert(keepalive.codename);
-      service_key_into_codename[e.entry.location] = keepalive.codename;
+      service_key_into_codename[entry.location] = keepalive.codename;
 
       codenames_per_service[keepalive.service].insert(keepalive.codename);
       // DIMA: More per-codename reporting fields go here; tailored to specific type, `.Call(populator)`, etc.
       ProtoReport report;
       const std::string last_keepalive =
-          current::strings::TimeIntervalAsHumanReadableString(now - e.idx_ts.us) + " ago";
-      if ((now - e.idx_ts.us) < parameters_.service_timeout_interval) {
+          current::strings::TimeIntervalAsHumanReadableString(now - us) + " ago";
+      if ((now - us) < parameters_.service_timeout_interval) {
         // Service is up.
         const auto projected_uptime_us =
-            (keepalive.now - keepalive.start_time_epoch_microseconds) + (now - e.idx_ts.us);
+            (keepalive.now - keepalive.start_time_epoch_microseconds) + (now - us);
         report.currently =
             current_service_state::up(keepalive.start_time_epoch_microseconds,
                                       last_keepalive,
-                                      e.idx_ts.us,
+                                      us,
                                       current::strings::TimeIntervalAsHumanReadableString(projected_uptime_us));
       } else {
         // Service is down.
         // TODO(dkorolev): Graceful shutdown case for `done`.
         report.currently = current_service_state::down(
-            keepalive.start_time_epoch_microseconds, last_keepalive, e.idx_ts.us, keepalive.uptime);
+            keepalive.start_time_epoch_microseconds, last_keepalive, us, keepalive.uptime);
       }
       report.dependencies = keepalive.dependencies;
       report.runtime = keepalive.runtime;
       report_for_codename[keepalive.codename] = report;
+    };
+
+    CURRENT_ASSERT(to >= from);
+    // Up to the present moment, serve the in-memory view of the fleet. Replay the stream for the past periods.
+    const auto& keepalives_data(keepalives_stream_->Data());
+    typename fleet_view_aggregate_t::Snapshot snapshot;
+    if (!r.url.query.has("to") && !r.url.query.has("interval_us") &&
+        fleet_view_aggregate_.TrySnapshot(from, to, keepalives_data->Size(), snapshot)) {
+      for (const auto& e : snapshot.keepalives) {
+        add_keepalive(*e.second, e.first);
+      }
+      for (const auto& e : snapshot.codename_per_location) {
+        service_key_into_codename[e.first] = e.second;
+      }
+    } else {
+      for (const auto& e : keepalives_data->Iterate(from, to)) {
+        add_keepalive(e.entry, e.idx_ts.us);
+      }
     }
 
     // To list only the services that are currently in `Active` state.
@@ -984,11 +1304,32 @@ class GenericKarl final : private KarlStorage<STORAGE_TYPE>,
   // Plus one to have `0` == "no keepalives", and avoid the corner case of record at index 0 being the one.
   std::unordered_map<std::string, uint64_t> latest_keepalive_index_plus_one_;
 
+  // The most recent keepalive from each Claire, to apply the next delta-encoded keepalive to.
+  struct KeepaliveDeltaBase {
+    uint64_t sequence_number = 0u;
+    ClaireStatus parsed_status;
+    claire_status_t detailed_parsed_status;
+  };
+  std::unordered_map<std::string, KeepaliveDeltaBase> keepalive_delta_bases_;
+  std::mutex keepalive_delta_bases_mutex_;
+
+  // Keepalives accepted, but not persisted yet, see `EnqueueKeepalive()`.
+  std::vector<PendingKeepalive> pending_keepalives_;
+  std::chrono::steady_clock::time_point pending_keepalives_deadline_;
+  std::mutex pending_keepalives_mutex_;
+  std::condition_variable pending_keepalives_condition_variable_;
+  bool keepalives_ingestion_thread_running_;
+
   current::Owned<stream_t> keepalives_stream_;
+  fleet_view_aggregate_t fleet_view_aggregate_;
+  using fleet_view_aggregate_scope_t =
+      typename stream_t::template SubscriberScope<fleet_view_aggregate_t, persisted_keepalive_t>;
+  fleet_view_aggregate_scope_t fleet_view_aggregate_scope_;
   std::atomic_bool state_update_thread_running_;
   std::atomic_bool state_update_thread_force_wakeup_;
   std::condition_variable update_thread_condition_variable_;
   std::thread state_update_thread_;
+  std::thread keepalives_ingestion_thread_;
   const HTTPRoutesScope http_scope_;
 };
 
@@ -25,6 +25,10 @@ SOFTWARE.
 #ifndef KARL_RENDER_H
 #define KARL_RENDER_H
 
+#include <future>
+#include <map>
+#include <mutex>
+
 #include "schema_karl.h"
 
 #include "../bricks/dot/graphviz.h"
@@ -88,7 +92,7 @@ class DefaultFleetViewRenderer : public IKarlFleetViewRenderer<INNER_STATUSES_VA
       return Response(
           "<!doctype html>"
           "<head><link rel='icon' HREF='./favicon.png'></head>"
-          "<body>" + RenderFleetGraph(status, karl_parameters).AsSVG() + "</body>",
+          "<body>" + CachedFleetGraphAsSVG(status, karl_parameters) + "</body>",
           HTTPResponseCode.OK,
           net::constants::kDefaultHTMLContentType);
       // clang-format on
@@ -97,6 +101,80 @@ class DefaultFleetViewRenderer : public IKarlFleetViewRenderer<INNER_STATUSES_VA
     }
   }
 
+  // Rendering the SVG runs GraphViz's `dot`, so the rendered SVG is reused for as long as the fingerprint
+  // of the fleet view stays the same, and the concurrent requests for the same fleet view share one render.
+  std::string CachedFleetGraphAsSVG(const karl_status_t& status, const KarlParameters& karl_parameters) {
+    const std::chrono::microseconds interval = karl_parameters.fleet_view_svg_refresh_interval;
+    if (interval.count() <= 0) {
+      return RenderFleetGraphAsSVG(status, karl_parameters);
+    }
+    const std::string fingerprint = FleetGraphFingerprint(status, karl_parameters);
+    const std::chrono::microseconds now_bucket(status.now.count() - status.now.count() % interval.count());
+    std::promise<std::string> promise;
+    std::shared_future<std::string> svg;
+    bool render = false;
+    {
+      std::lock_guard<std::mutex> lock(rendered_svgs_mutex_);
+      if (now_bucket != rendered_svgs_now_bucket_) {
+        // The relative times on all the rendered SVGs are stale now.
+        rendered_svgs_.clear();
+        rendered_svgs_now_bucket_ = now_bucket;
+      }
+      auto& cached = rendered_svgs_[fingerprint];
+      if (!cached.valid()) {
+        cached = promise.get_future().share();
+        render = true;
+      }
+      svg = cached;
+    }
+    if (render) {
+      try {
+        promise.set_value(RenderFleetGraphAsSVG(status, karl_parameters));
+      } catch (...) {
+        {
+          std::lock_guard<std::mutex> lock(rendered_svgs_mutex_);
+          rendered_svgs_.erase(fingerprint);
+        }
+        promise.set_exception(std::current_exception());
+      }
+    }
+    return svg.get();
+  }
+
+  // The fleet view renders into the same SVG as long as its fingerprint is the same. The times are rounded down
+  // to `fleet_view_svg_refresh_interval`, and the details of the most recent keepalives, which only affect
+  // the relative times on the SVG, are dropped; everything else on the fleet view is kept as is.
+  virtual std::string FleetGraphFingerprint(const karl_status_t& status, const KarlParameters& karl_parameters) {
+    const int64_t interval = karl_parameters.fleet_view_svg_refresh_interval.count();
+    const auto bucket = [interval](std::chrono::microseconds t) {
+      return std::chrono::microseconds(t.count() - t.count() % interval);
+    };
+    karl_status_t normalized = status;
+    normalized.now = bucket(status.now);
+    normalized.from = bucket(status.from);
+    normalized.to = bucket(status.to);
+    normalized.generation_time = std::chrono::microseconds(0);
+    for (auto& machine : normalized.machines) {
+      for (auto& service : machine.second.services) {
+        auto& currently = service.second.currently;
+        if (Exists<current_service_state::up>(currently)) {
+          auto& up = Value<current_service_state::up>(currently);
+          up.last_keepalive_received.clear();
+          up.last_keepalive_received_epoch_microseconds = std::chrono::microseconds(0);
+          up.uptime.clear();
+        } else if (Exists<current_service_state::down>(currently)) {
+          Value<current_service_state::down>(currently).last_keepalive_received.clear();
+        }
+      }
+    }
+    return JSON(normalized) + '\n' + JSON(karl_parameters);
+  }
+
+  // Render Karl's status page as an SVG image.
+  virtual std::string RenderFleetGraphAsSVG(const karl_status_t& status, const KarlParameters& karl_parameters) {
+    return RenderFleetGraph(status, karl_parameters).AsSVG();
+  }
+
   // Render Karl's status page as a GraphViz directed graph.
   virtual graphviz::DiGraph RenderFleetGraph(const karl_status_t& status, const KarlParameters& karl_parameters) {
     std::chrono::microseconds now = status.now;
@@ -287,6 +365,13 @@ class DefaultFleetViewRenderer : public IKarlFleetViewRenderer<INNER_STATUSES_VA
       graph.Add(group);
     }
   }
+
+ private:
+  // Fingerprint -> the SVG, rendered or being rendered, for the fleet views generated within the same
+  // `fleet_view_svg_refresh_interval`.
+  std::map<std::string, std::shared_future<std::string>> rendered_svgs_;
+  std::chrono::microseconds rendered_svgs_now_bucket_ = std::chrono::microseconds(-1);
+  std::mutex rendered_svgs_mutex_;
 };
 
 }  // namespace current::karl
@@ -52,6 +52,9 @@ CURRENT_STRUCT(KarlNginxParameters) {
 // Karl's startup parameters.
 constexpr static const char* kDefaultFleetViewURL = "http://localhost:%d";  // Defaults to the nginx port.
 constexpr static std::chrono::microseconds k45Seconds = std::chrono::microseconds(1000ll * 1000ll * 45);
+constexpr static std::chrono::microseconds k10Seconds = std::chrono::microseconds(1000ll * 1000ll * 10);
+constexpr static std::chrono::microseconds k10Milliseconds = std::chrono::microseconds(1000ll * 10);
+constexpr static std::chrono::microseconds kOneHour = std::chrono::microseconds(1000ll * 1000ll * 60 * 60);
 CURRENT_STRUCT(KarlParameters) {
   CURRENT_FIELD(keepalives_port, uint16_t);
   CURRENT_FIELD_DESCRIPTION(keepalives_port, "The port on which keepalives are listened to.");
@@ -81,6 +84,20 @@ CURRENT_STRUCT(KarlParameters) {
   CURRENT_FIELD_DESCRIPTION(service_timeout_interval,
                             "The default period of keepalive-free inactivity, after which a service is "
                             "considered down for fleet browsability purposes.");
+  CURRENT_FIELD(keepalives_batch_interval, std::chrono::microseconds, k10Milliseconds);
+  CURRENT_FIELD_DESCRIPTION(keepalives_batch_interval,
+                            "The longest time a received keepalive waits to be persisted along with the others.");
+  CURRENT_FIELD(keepalives_batch_size, uint32_t, 1000u);
+  CURRENT_FIELD_DESCRIPTION(keepalives_batch_size,
+                            "The number of received keepalives which are persisted right away, in one transaction.");
+  CURRENT_FIELD(fleet_view_window, std::chrono::microseconds, kOneHour);
+  CURRENT_FIELD_DESCRIPTION(fleet_view_window,
+                            "The period over which the state of the fleet is kept in memory. The fleet view "
+                            "requests reaching further into the past replay the persisted stream of keepalives.");
+  CURRENT_FIELD(fleet_view_svg_refresh_interval, std::chrono::microseconds, k10Seconds);
+  CURRENT_FIELD_DESCRIPTION(fleet_view_svg_refresh_interval,
+                            "The rendered SVG fleet view is reused until something visible on it changes, with "
+                            "the relative times on it up to this stale. Zero to render it for every request.");
 
   KarlParameters& SetKeepalivesPort(uint16_t port) {
     keepalives_port = port;
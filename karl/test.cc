@@ -1222,6 +1222,247 @@ TEST(Karl, CustomStorage) {
   }
 }
 
+TEST(Karl, KeepalivesAreBatched) {
+  current::time::ResetToZero();
+
+  auto params = UnittestKarlParameters();
+  params.keepalives_batch_interval = std::chrono::milliseconds(50);
+  params.keepalives_batch_size = 3u;
+  const auto stream_file_remover = current::FileSystem::ScopedRmFile(params.stream_persistence_file);
+  const auto storage_file_remover = current::FileSystem::ScopedRmFile(params.storage_persistence_file);
+  const unittest_karl_t karl(params);
+
+  // Each keepalive is acknowledged once it is persisted, along with how long it has been waiting for its batch.
+  std::vector<std::string> responses(4u);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < responses.size(); ++i) {
+    threads.emplace_back([i, &responses]() {
+      current::karl::ClaireStatus status;
+      status.service = "batched";
+      status.codename = "batched" + current::ToString(i);
+      status.local_port = static_cast<uint16_t>(10000 + i);
+      const auto response = HTTP(POST(Printf("http://localhost:%d/", FLAGS_karl_test_keepalives_port), JSON(status)));
+      responses[i] = current::ToString(static_cast<int>(response.code)) + ' ' + response.body +
+                     current::ToString(response.headers.Has(current::karl::constants::kKeepaliveQueuedForHeader));
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& response : responses) {
+    EXPECT_EQ("200 OK\ntrue", response);
+  }
+
+  const auto result = karl.BorrowStorage()->ReadOnlyTransaction([](ImmutableFields<unittest_karl_t::storage_t> fields) {
+    for (int i = 0; i < 4; ++i) {
+      const auto claire = fields.claires["batched" + current::ToString(i)];
+      ASSERT_TRUE(Exists(claire));
+      EXPECT_EQ(current::karl::ClaireRegisteredState::Active, Value(claire).registered_state);
+    }
+  }).Go();
+  EXPECT_TRUE(WasCommitted(result));
+  EXPECT_EQ(4u, karl.ActiveServicesCount());
+}
+
+TEST(Karl, DeltaEncodedKeepalives) {
+  current::time::ResetToZero();
+
+  const auto params = UnittestKarlParameters();
+  const auto stream_file_remover = current::FileSystem::ScopedRmFile(params.stream_persistence_file);
+  const auto storage_file_remover = current::FileSystem::ScopedRmFile(params.storage_persistence_file);
+  const unittest_karl_t karl(params);
+
+  const std::string route = Printf("http://localhost:%d/?codename=delta&port=10000", FLAGS_karl_test_keepalives_port);
+
+  current::karl::ClaireStatus status;
+  status.service = "deltas";
+  status.codename = "delta";
+  status.local_port = 10000u;
+  status.now = std::chrono::microseconds(1);
+  // Only the keepalives carrying `&seq` are acknowledged as the base for the deltas.
+  {
+    const auto response = HTTP(POST(route, JSON(status)));
+    EXPECT_EQ(200, static_cast<int>(response.code));
+    EXPECT_FALSE(response.headers.Has(current::karl::constants::kKeepaliveDeltasAcceptedHeader));
+  }
+  {
+    const auto response = HTTP(POST(route + "&seq=1", JSON(status)));
+    EXPECT_EQ(200, static_cast<int>(response.code));
+    EXPECT_TRUE(response.headers.Has(current::karl::constants::kKeepaliveDeltasAcceptedHeader));
+  }
+
+  // The delta only carries the fields that have changed, and is applied to the keepalive with the sequence number
+  // of its `base`.
+  {
+    const auto response =
+        HTTP(POST(route + "&seq=2&base=1&delta", "{\"cloud_instance_name\":\"i-delta\",\"now\":2}"));
+    EXPECT_EQ(200, static_cast<int>(response.code));
+    EXPECT_TRUE(response.headers.Has(current::karl::constants::kKeepaliveDeltasAcceptedHeader));
+  }
+
+  // Once the base is not the most recent keepalive, the full one is requested.
+  {
+    const auto response = HTTP(POST(route + "&seq=3&base=1&delta", "{\"now\":3}"));
+    EXPECT_EQ(409, static_cast<int>(response.code));
+    EXPECT_EQ("Keepalive resync required.\n", response.body);
+  }
+  EXPECT_EQ(409, static_cast<int>(HTTP(POST(route + "&seq=3&base=2&delta", "{\"now\":\"bad\"}")).code));
+  EXPECT_EQ(409, static_cast<int>(HTTP(POST(route + "&seq=4&base=2&delta", "{\"now\":4}")).code));
+
+  unittest_karl_status_t fleet;
+  ASSERT_NO_THROW(fleet = ParseJSON<unittest_karl_status_t>(
+                      HTTP(GET(Printf("http://localhost:%d?from=0&full", FLAGS_karl_test_fleet_view_port))).body));
+  ASSERT_TRUE(fleet.machines.count("127.0.0.1")) << JSON(fleet);
+  const auto& machine = fleet.machines["127.0.0.1"];
+  ASSERT_TRUE(Exists(machine.cloud_instance_name)) << JSON(fleet);
+  EXPECT_EQ("i-delta", Value(machine.cloud_instance_name));
+  ASSERT_TRUE(machine.services.count("delta")) << JSON(fleet);
+  EXPECT_EQ("deltas", machine.services.at("delta").service);
+}
+
+TEST(Karl, FleetViewSVGIsCached) {
+  struct CountingRenderer final : current::karl::DefaultFleetViewRenderer<unittest_karl_t::runtime_status_variant_t> {
+    std::atomic_size_t renders{0u};
+    std::string RenderFleetGraphAsSVG(const karl_status_t& status, const current::karl::KarlParameters&) override {
+      ++renders;
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      return "<svg>" + current::ToString(status.machines.size()) + "</svg>";
+    }
+  };
+  CountingRenderer renderer;
+
+  current::karl::KarlParameters params;
+  params.fleet_view_svg_refresh_interval = std::chrono::seconds(10);
+
+  unittest_karl_status_t status;
+  status.now = std::chrono::seconds(1000);
+  status.from = status.now - std::chrono::minutes(5);
+  status.to = status.now;
+  auto& service = status.machines["127.0.0.1"].services["foo"];
+  service.service = "foo";
+  service.codename = "foo";
+  service.currently = current::karl::current_service_state::up(
+      std::chrono::seconds(1), "1s ago", status.now - std::chrono::seconds(1), "");
+
+  const auto html = [&renderer, &params](unittest_karl_status_t status) {
+    return renderer.RenderResponse(current::karl::FleetViewResponseFormat::HTML, params, std::move(status)).body;
+  };
+
+  EXPECT_EQ(0u, renderer.renders);
+  const std::string svg = html(status);
+  EXPECT_NE(std::string::npos, svg.find("<svg>1</svg>"));
+  EXPECT_EQ(1u, renderer.renders);
+
+  // Newer keepalives within the same refresh interval are not re-rendered.
+  status.now += std::chrono::seconds(5);
+  status.to = status.now;
+  status.from = status.now - std::chrono::minutes(5);
+  Value<current::karl::current_service_state::up>(service.currently).last_keepalive_received = "0s ago";
+  EXPECT_EQ(svg, html(status));
+  EXPECT_EQ(1u, renderer.renders);
+
+  // Concurrent requests share the one render.
+  status.machines["127.0.0.2"].services["bar"] = service;
+  {
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+      threads.emplace_back([&]() { EXPECT_NE(std::string::npos, html(status).find("<svg>2</svg>")); });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+  EXPECT_EQ(2u, renderer.renders);
+
+  // A service going down is re-rendered right away.
+  status.machines["127.0.0.2"].services["bar"].currently =
+      current::karl::current_service_state::down(std::chrono::seconds(1), "1s ago", status.now, "");
+  html(status);
+  EXPECT_EQ(3u, renderer.renders);
+  html(status);
+  EXPECT_EQ(3u, renderer.renders);
+
+  // Once the refresh interval is over, the relative times are re-rendered.
+  status.now += std::chrono::seconds(10);
+  html(status);
+  EXPECT_EQ(4u, renderer.renders);
+
+  // No caching with the zero refresh interval.
+  params.fleet_view_svg_refresh_interval = std::chrono::microseconds(0);
+  html(status);
+  html(status);
+  EXPECT_EQ(6u, renderer.renders);
+}
+
+TEST(Karl, FleetViewAggregate) {
+  current::time::ResetToZero();
+
+  using persisted_keepalive_t = typename unittest_karl_t::persisted_keepalive_t;
+  using aggregate_t = current::ss::StreamSubscriber<current::karl::KarlFleetViewAggregate<persisted_keepalive_t>,
+                                                    persisted_keepalive_t>;
+
+  auto stream = current::stream::Stream<persisted_keepalive_t>::CreateStream();
+  const auto keepalive = [&stream](const std::string& codename, uint16_t port, std::chrono::microseconds t) {
+    persisted_keepalive_t record;
+    record.location.ip = "127.0.0.1";
+    record.location.port = port;
+    record.keepalive.codename = codename;
+    stream->Publisher()->Publish(std::move(record), t);
+  };
+
+  // The keepalives which are already out of the window are skipped.
+  current::time::SetNow(std::chrono::microseconds(1000000));
+  keepalive("old", 8000, std::chrono::microseconds(100));
+  current::time::SetNow(std::chrono::microseconds(2000000));
+
+  aggregate_t aggregate(std::chrono::microseconds(1000000), *stream->Data());
+  EXPECT_EQ(1u, aggregate.BeginIndex());
+  const auto scope = stream->template Subscribe<persisted_keepalive_t>(aggregate, aggregate.BeginIndex());
+
+  keepalive("foo", 8001, std::chrono::microseconds(2000001));
+  keepalive("bar", 8002, std::chrono::microseconds(2000002));
+  keepalive("foo", 8003, std::chrono::microseconds(2000003));
+
+  typename aggregate_t::Snapshot snapshot;
+  const std::chrono::microseconds to(5000000);
+  EXPECT_FALSE(aggregate.TrySnapshot(std::chrono::microseconds(0), to, stream->Data()->Size(), snapshot));
+
+  ASSERT_TRUE(aggregate.TrySnapshot(std::chrono::microseconds(1500000), to, stream->Data()->Size(), snapshot));
+  std::map<std::string, std::pair<int64_t, uint16_t>> latest;
+  for (const auto& e : snapshot.keepalives) {
+    latest[e.second->keepalive.codename] = std::make_pair(e.first.count(), e.second->location.port);
+  }
+  EXPECT_EQ("{\"bar\":[2000002,8002],\"foo\":[2000003,8003]}", JSON(latest));
+  std::map<uint16_t, std::string> codename_per_port;
+  for (const auto& e : snapshot.codename_per_location) {
+    codename_per_port[e.first.port] = e.second;
+  }
+  EXPECT_EQ("[[8001,\"foo\"],[8002,\"bar\"],[8003,\"foo\"]]", JSON(codename_per_port));
+
+  // Only what has been reported since `from` makes it into the snapshot.
+  ASSERT_TRUE(aggregate.TrySnapshot(std::chrono::microseconds(2000003), to, stream->Data()->Size(), snapshot));
+  ASSERT_EQ(1u, snapshot.keepalives.size());
+  EXPECT_EQ("foo", snapshot.keepalives.front().second->keepalive.codename);
+  EXPECT_EQ(1u, snapshot.codename_per_location.size());
+
+  // The services not heard from within the window are evicted.
+  keepalive("bar", 8002, std::chrono::microseconds(3500000));
+  ASSERT_TRUE(aggregate.TrySnapshot(std::chrono::microseconds(2500000), to, stream->Data()->Size(), snapshot));
+  ASSERT_EQ(1u, snapshot.keepalives.size());
+  EXPECT_EQ("bar", snapshot.keepalives.front().second->keepalive.codename);
+  EXPECT_FALSE(aggregate.TrySnapshot(std::chrono::microseconds(2000003), to, stream->Data()->Size(), snapshot));
+
+  // Should the view fall behind the stream, the caller is told to replay the stream, instead of waiting forever.
+  EXPECT_FALSE(aggregate.TrySnapshot(
+      std::chrono::microseconds(2500000), to, stream->Data()->Size() + 1u, snapshot, std::chrono::milliseconds(10)));
+
+  // Nor is the view exact if the keepalives after `to` have been applied already.
+  EXPECT_FALSE(aggregate.TrySnapshot(
+      std::chrono::microseconds(2500000), std::chrono::microseconds(3499999), stream->Data()->Size(), snapshot));
+  EXPECT_TRUE(aggregate.TrySnapshot(
+      std::chrono::microseconds(2500000), std::chrono::microseconds(3500000), stream->Data()->Size(), snapshot));
+}
+
 #if 0
 // TODO(dkorolev): This test is incomplete; revisit it some day soon. Thanks for understanding.
 TEST(Karl, Visualization) {
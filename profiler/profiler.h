@@ -26,6 +26,22 @@ SOFTWARE.
 // a `CURRENT_PROFILER_HTTP_ROUTE(http_scopes_variable, port, "/route")` macro to define an HTTP endpoint
 // exposing a full snapshot of how much time did each thread spend in each scope.
 // Scopes are hierarchical, represented in the output as a full call stack tree.
+//
+// Each thread keeps its own call stack tree, guarded by its own lock, which only the reporting code ever contends
+// for. Time is taken from `std::chrono::steady_clock`, not from `current::time::Now()`, which is shared across
+// threads and moves forward by at least a microsecond per call. Thus entering and leaving a scope costs a clock read
+// and a few uncontended atomic operations, and the profiler can stay on in production.
+// Apart from the totals, each scope keeps a log-linear histogram of how long did its entries take, reported
+// as the 50th, 99th, and 99.9th percentiles. The per-thread trees are merged into one, `all_threads`,
+// only when the report is requested. As a thread terminates, its tree is merged into the one of all the terminated
+// threads, reported as a single entry, so that the memory used does not grow with the number of threads ever started.
+//
+// Apart from the JSON report, the route serves `?format=folded`: one line per call stack, merged across threads,
+// with the number of microseconds spent in it and not in its sub-scopes, to be fed into `flamegraph.pl`.
+// Also, each thread keeps a ring of its last `CURRENT_PROFILER_TRACE_EVENTS_PER_THREAD` scope enter and leave events,
+// served by `?format=trace` as the Chrome trace-event JSON, to see individual slow entries on `chrome://tracing`.
+// The events of the terminated threads are not kept.
+// Define `CURRENT_PROFILER_TRACE_EVENTS_PER_THREAD` to zero to not record the events.
 
 #ifndef CURRENT_PROFILER_H
 #define CURRENT_PROFILER_H
@@ -41,16 +57,24 @@ SOFTWARE.
 #error "No `CURRENT_PROFILER` in `CURRENT_COVERAGE_REPORT_MODE` please."
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <thread>
 
 #include "../blocks/http/api.h"
 #include "../bricks/time/chrono.h"
+#include "../bricks/util/histogram.h"
 #include "../bricks/util/singleton.h"
 
 #ifdef CURRENT_MOCK_TIME
 #error "No `CURRENT_PROFILER` in `CURRENT_MOCK_TIME` please."
 #endif
 
+#ifndef CURRENT_PROFILER_TRACE_EVENTS_PER_THREAD
+#define CURRENT_PROFILER_TRACE_EVENTS_PER_THREAD 4096
+#endif
+
 namespace current {
 namespace profiler {
 
@@ -59,6 +83,9 @@ CURRENT_STRUCT(PerThreadReporting) {
   CURRENT_FIELD(entries, uint64_t);
   CURRENT_FIELD(us, std::chrono::microseconds);
   CURRENT_FIELD(us_per_entry, double);
+  CURRENT_FIELD(us_p50, double);
+  CURRENT_FIELD(us_p99, double);
+  CURRENT_FIELD(us_p999, double);
   CURRENT_FIELD(absolute_best_possible_qps, double);
   CURRENT_FIELD(ratio_of_parent, double);
   CURRENT_FIELD(subscope, std::vector<PerThreadReporting>);
@@ -70,184 +97,446 @@ CURRENT_STRUCT(PerThreadReporting) {
 
 CURRENT_STRUCT(ProfilingReport) {
   CURRENT_FIELD(thread, std::vector<PerThreadReporting>);
+  CURRENT_FIELD(all_threads, PerThreadReporting);
+  // Estimated as the number of scopes entered and left times the measured cost of doing so.
   CURRENT_FIELD(profiling_overhead, std::chrono::microseconds);
+  // The time spent waiting on per-thread locks, which only happens while the report is being generated.
   CURRENT_FIELD(profiling_mutex_overhead, std::chrono::microseconds);
   CURRENT_FIELD(reporting_overhead, std::chrono::microseconds);
 };
 
+// The "Duration Events" of the Chrome trace-event format: `ph` is "B" for entering a scope and "E" for leaving it,
+// `ts` is in microseconds, and `tid` is the index of the thread in the order threads entered their first scopes.
+CURRENT_STRUCT(ChromeTraceEvent) {
+  CURRENT_FIELD(name, std::string);
+  CURRENT_FIELD(ph, std::string);
+  CURRENT_FIELD(ts, double);
+  CURRENT_FIELD(pid, uint32_t, 1u);
+  CURRENT_FIELD(tid, uint32_t);
+};
+
+CURRENT_STRUCT(ChromeTrace) {
+  CURRENT_FIELD(traceEvents, std::vector<ChromeTraceEvent>);
+  CURRENT_FIELD(displayTimeUnit, std::string, "ns");
+};
+
 struct Profiler {
   class StateMaintainer {
    private:
-    struct State {
-      struct PerThread {
-        struct Trie {
-          // `Now()` if within it, `0` if currently not there.
-          std::chrono::microseconds us_entered = std::chrono::microseconds(0);
-          // Total across all the times this scope was entered.
-          std::chrono::microseconds us_total = std::chrono::microseconds(0);
-          // The number of times this scope was entered.
-          uint64_t entries = 0;
-          // Sub-scopes within this scope, if any.
-          std::map<const char*, Trie> children;
-
-          std::chrono::microseconds ComputeTotalMicroseconds(std::chrono::microseconds now) const {
-            if (us_entered.count()) {
-              CURRENT_ASSERT(now >= us_entered);
-              return std::chrono::microseconds(us_total.count() + (now - us_entered).count());
-            } else {
-              return us_total;
+    static std::chrono::nanoseconds SteadyNow() {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch());
+    }
+
+    struct PerThread {
+      struct Trie {
+        // `SteadyNow()` if within it, `0` if currently not there.
+        std::chrono::nanoseconds ns_entered = std::chrono::nanoseconds(0);
+        // Total across all the times this scope was entered.
+        std::chrono::nanoseconds ns_total = std::chrono::nanoseconds(0);
+        // The number of times this scope was entered.
+        uint64_t entries = 0;
+        // The durations of the completed entries into this scope, in nanoseconds.
+        LogLinearHistogram<> ns_histogram;
+        // Sub-scopes within this scope, if any. There are few of them, and they are keyed by the pointers
+        // to string literals, so a linear search beats a map.
+        std::vector<std::pair<const char*, std::unique_ptr<Trie>>> children;
+
+        Trie& Child(const char* scope) {
+          for (auto& child : children) {
+            if (child.first == scope) {
+              return *child.second;
             }
           }
-          void RecursiveReset(std::chrono::microseconds now) {
-            us_total = std::chrono::microseconds(0);
-            if (us_entered.count()) {
-              us_entered = now;
-            }
-            entries = 1;
-            for (auto& e : children) {
-              e.second.RecursiveReset(now);
-            }
+          children.emplace_back(scope, std::make_unique<Trie>());
+          return *children.back().second;
+        }
+
+        std::chrono::nanoseconds ComputeTotalNanoseconds(std::chrono::nanoseconds now) const {
+          if (ns_entered.count()) {
+            CURRENT_ASSERT(now >= ns_entered);
+            return ns_total + (now - ns_entered);
+          } else {
+            return ns_total;
+          }
+        }
+        void RecursiveReset(std::chrono::nanoseconds now) {
+          ns_total = std::chrono::nanoseconds(0);
+          if (ns_entered.count()) {
+            ns_entered = now;
+          }
+          entries = 1;
+          ns_histogram.Reset();
+          for (auto& e : children) {
+            e.second->RecursiveReset(now);
+          }
+        }
+        void RecursiveMerge(const Trie& rhs, std::chrono::nanoseconds now) {
+          ns_total += rhs.ComputeTotalNanoseconds(now);
+          entries += rhs.entries;
+          ns_histogram.Merge(rhs.ns_histogram);
+          for (const auto& e : rhs.children) {
+            Child(e.first).RecursiveMerge(*e.second, now);
           }
-        };
-        Trie trie;
-        std::stack<std::pair<const char*, Trie*> > stack;
-        PerThread() {
-          trie.us_entered = current::time::Now();
-          trie.entries = 1;
-          stack.push(std::make_pair("", &trie));
         }
       };
-      std::unordered_map<std::thread::id, PerThread> per_thread;
-      std::chrono::microseconds total_spent_in_profiling = std::chrono::microseconds(0);
-      std::chrono::microseconds spent_in_reporting = std::chrono::microseconds(0);
-      std::chrono::microseconds spent_in_mutex_locking = std::chrono::microseconds(0);
-      void Reset() {
-        total_spent_in_profiling = std::chrono::microseconds(0);
-        spent_in_reporting = std::chrono::microseconds(0);
-        spent_in_mutex_locking = std::chrono::microseconds(0);
-        for (auto& e : per_thread) {
-          e.second.trie.RecursiveReset(current::time::Now());
+
+      struct TraceEvent {
+        const char* scope;
+        std::chrono::nanoseconds timestamp;
+        bool enter;
+      };
+
+      const std::thread::id thread_id;
+      const uint32_t index;
+      Trie trie;
+      std::vector<std::pair<const char*, Trie*>> stack;
+      // The number of `EnterScope()`-s and `LeaveScope()`-s, to estimate the profiling overhead.
+      uint64_t events = 0;
+      std::chrono::nanoseconds spent_waiting_for_lock = std::chrono::nanoseconds(0);
+      // The last `CURRENT_PROFILER_TRACE_EVENTS_PER_THREAD` events, the next one to go at `events % size`.
+      std::vector<TraceEvent> trace_ring;
+
+      explicit PerThread(uint32_t thread_index = 0) : thread_id(std::this_thread::get_id()), index(thread_index) {
+        trie.ns_entered = SteadyNow();
+        trie.entries = 1;
+        stack.emplace_back("", &trie);
+        trace_ring.reserve(CURRENT_PROFILER_TRACE_EVENTS_PER_THREAD);
+      }
+
+      void EnterScope(const char* scope) {
+        const std::chrono::nanoseconds now = SteadyNow();
+        Locked([this, scope, now]() {
+          CURRENT_ASSERT(now.count());
+          CURRENT_ASSERT(!stack.empty());
+          Trie& node = stack.back().second->Child(scope);
+          node.ns_entered = now;
+          ++node.entries;
+          stack.emplace_back(scope, &node);
+          RecordTraceEvent(scope, now, true);
+        });
+      }
+
+      void LeaveScope(const char* scope) {
+        const std::chrono::nanoseconds now = SteadyNow();
+        Locked([this, scope, now]() {
+          CURRENT_ASSERT(now.count());
+          CURRENT_ASSERT(!stack.empty());
+          CURRENT_ASSERT(scope == stack.back().first);
+          Trie& node = *stack.back().second;
+          CURRENT_ASSERT(node.ns_entered <= now);
+          const std::chrono::nanoseconds ns = now - node.ns_entered;
+          node.ns_total += ns;
+          node.ns_histogram.Record(static_cast<uint64_t>(ns.count()));
+          node.ns_entered = std::chrono::nanoseconds(0);
+          stack.pop_back();
+          CURRENT_ASSERT(!stack.empty());  // Should have at least the root trie node left in the stack.
+          RecordTraceEvent(scope, now, false);
+        });
+      }
+
+      void RecordTraceEvent(const char* scope, std::chrono::nanoseconds now, bool enter) {
+#if CURRENT_PROFILER_TRACE_EVENTS_PER_THREAD
+        const TraceEvent event{scope, now, enter};
+        if (trace_ring.size() < CURRENT_PROFILER_TRACE_EVENTS_PER_THREAD) {
+          trace_ring.push_back(event);
+        } else {
+          trace_ring[events % CURRENT_PROFILER_TRACE_EVENTS_PER_THREAD] = event;
         }
+#else
+        static_cast<void>(scope);
+        static_cast<void>(now);
+        static_cast<void>(enter);
+#endif
+        ++events;
       }
-      ProfilingReport GenerateReport() const {
-        const std::chrono::microseconds now = current::time::Now();
-        ProfilingReport report;
-        report.profiling_overhead = total_spent_in_profiling - spent_in_reporting;
-        report.reporting_overhead = spent_in_reporting;
-        report.profiling_mutex_overhead = spent_in_mutex_locking;
-        std::vector<PerThreadReporting> thread;
-        thread.reserve(per_thread.size());
-        for (const auto& per_thread_element : per_thread) {
-          std::function<void(const PerThread::Trie& input,
-                             std::chrono::microseconds total_us,
-                             PerThreadReporting& output,
-                             const char* stack)>
-              recursive_fill;
-          recursive_fill = [now, &recursive_fill](const PerThread::Trie& input,
-                                                  std::chrono::microseconds total_us,
-                                                  PerThreadReporting& output,
-                                                  const char* stack) {
-            output.scope = stack;
-            output.entries = input.entries;
-            CURRENT_ASSERT(output.entries);
-            output.us = input.ComputeTotalMicroseconds(now);
-            output.us_per_entry = 1.0 * output.us.count() / output.entries;
-            output.absolute_best_possible_qps = output.us.count() ? (1e6 / output.us_per_entry) : 1e6;
-            output.ratio_of_parent = total_us.count() ? (1.0 * output.us.count() / total_us.count()) : 1.0;
-            output.subscope.reserve(input.children.size());
-            for (const auto& scope : input.children) {
-              output.subscope.resize(output.subscope.size() + 1);
-              recursive_fill(scope.second, output.us, output.subscope.back(), scope.first);
-            }
-            CURRENT_ASSERT(output.subscope.size() == input.children.size());
-            std::chrono::microseconds subscope_total = std::chrono::microseconds(0);
-            for (const auto& subscope : output.subscope) {
-              subscope_total += subscope.us;
-            }
-            CURRENT_ASSERT(subscope_total <= output.us);
-            output.subscope_total_ratio_of_parent =
-                output.us.count() ? (1.0 * subscope_total.count() / output.us.count()) : 1.0;
-            std::sort(output.subscope.begin(), output.subscope.end());
-          };
-          thread.resize(thread.size() + 1);
-          std::ostringstream thread_id_as_string;
-          thread_id_as_string << "C++ thread with internal ID " << per_thread_element.first;
-          recursive_fill(per_thread_element.second.trie,
-                         per_thread_element.second.trie.ComputeTotalMicroseconds(now),
-                         thread.back(),
-                         thread_id_as_string.str().c_str());
+
+      // The leave events of the scopes entered before the oldest event in the ring are skipped.
+      void ExportTraceEvents(std::vector<ChromeTraceEvent>& output) const {
+        const size_t size = trace_ring.size();
+        if (!size) {
+          return;
+        }
+        // Until the ring is full, `events == size`, and the oldest event is the first one.
+        const size_t oldest = static_cast<size_t>(events % size);
+        size_t depth = 0;
+        for (size_t i = 0; i < size; ++i) {
+          const TraceEvent& event = trace_ring[(oldest + i) % size];
+          if (event.enter) {
+            ++depth;
+          } else if (depth) {
+            --depth;
+          } else {
+            continue;
+          }
+          output.resize(output.size() + 1);
+          ChromeTraceEvent& exported = output.back();
+          exported.name = event.scope;
+          exported.ph = event.enter ? "B" : "E";
+          exported.ts = 1e-3 * event.timestamp.count();
+          exported.tid = index;
+        }
+      }
+
+      // Called as the thread terminates, for its total time to stop growing.
+      void Terminate() {
+        const std::chrono::nanoseconds now = SteadyNow();
+        Locked([this, now]() {
+          for (auto& e : stack) {
+            e.second->ns_total = e.second->ComputeTotalNanoseconds(now);
+            e.second->ns_entered = std::chrono::nanoseconds(0);
+          }
+        });
+      }
+
+      template <typename F>
+      void Locked(F&& f) {
+        if (locked_.exchange(true, std::memory_order_acquire)) {
+          const std::chrono::nanoseconds pre_lock = SteadyNow();
+          while (locked_.exchange(true, std::memory_order_acquire)) {
+            std::this_thread::yield();
+          }
+          spent_waiting_for_lock += (SteadyNow() - pre_lock);
+        }
+        f();
+        locked_.store(false, std::memory_order_release);
+      }
+
+     private:
+      std::atomic_bool locked_{false};
+    };
+
+    // The thread-local pointer to the state of this thread, which the maintainer has another pointer to.
+    struct ThisThread {
+      std::shared_ptr<PerThread> state;
+      StateMaintainer* maintainer = nullptr;
+      ~ThisThread() {
+        if (state) {
+          state->Terminate();
+          maintainer->RetireThread(state);
         }
-        CURRENT_ASSERT(thread.size() == per_thread.size());
-        report.thread = thread;
-        return report;
       }
     };
 
    public:
+    StateMaintainer() {
+      // Enter and leave a scope on a scratch per-thread state enough times to learn what doing so costs.
+      PerThread calibration;
+      const char* calibration_scope = "calibration";
+      const std::chrono::nanoseconds begin = SteadyNow();
+      for (size_t i = 0; i < kCalibrationIterations; ++i) {
+        calibration.EnterScope(calibration_scope);
+        calibration.LeaveScope(calibration_scope);
+      }
+      ns_per_event_ = 0.5 * (SteadyNow() - begin).count() / kCalibrationIterations;
+    }
+
     void EnterScope(const char* scope) {
       CURRENT_ASSERT(scope);
       CURRENT_ASSERT(*scope);
-      Guarded([scope](std::chrono::microseconds now, State::PerThread& per_thread) {
-        CURRENT_ASSERT(now.count());
-        CURRENT_ASSERT(!per_thread.stack.empty());
-        State::PerThread::Trie& node = (*per_thread.stack.top().second).children[scope];
-        node.us_entered = now;
-        ++node.entries;
-        per_thread.stack.push(std::make_pair(scope, &node));
-      });
+      PerThreadState().EnterScope(scope);
     }
 
     void LeaveScope(const char* scope) {
       CURRENT_ASSERT(scope);
       CURRENT_ASSERT(*scope);
-      Guarded([scope](std::chrono::microseconds now, State::PerThread& per_thread) {
-        CURRENT_ASSERT(now.count());
-        CURRENT_ASSERT(!per_thread.stack.empty());
-        CURRENT_ASSERT(scope == per_thread.stack.top().first);
-        State::PerThread::Trie& node = (*per_thread.stack.top().second);
-        CURRENT_ASSERT(node.us_entered <= now);
-        node.us_total += (now - node.us_entered);
-        node.us_entered = std::chrono::microseconds(0);
-        per_thread.stack.pop();
-        CURRENT_ASSERT(!per_thread.stack.empty());  // Should have at least the root trie node left in the stack.
-      });
+      PerThreadState().LeaveScope(scope);
     }
 
     void Report(Request request) {
-      Guarded([this, &request](std::chrono::microseconds unused_now, const State::PerThread& unused_per_thread_state) {
-        static_cast<void>(unused_now);
-        static_cast<void>(unused_per_thread_state);
-        if (request.url.query.has("reset")) {
-          state_.Reset();
-          request("The profiler has been reset.\n");
+      std::lock_guard<std::mutex> lock(reporting_mutex_);
+      const std::chrono::nanoseconds pre_report = SteadyNow();
+      if (request.url.query.has("reset")) {
+        for (const auto& per_thread : AllThreads()) {
+          per_thread->Locked([&per_thread]() {
+            per_thread->trie.RecursiveReset(SteadyNow());
+            per_thread->events = 0;
+            per_thread->spent_waiting_for_lock = std::chrono::nanoseconds(0);
+            per_thread->trace_ring.clear();
+          });
+        }
+        retired_trie_ = PerThread::Trie();
+        retired_threads_ = 0u;
+        retired_events_ = 0u;
+        retired_spent_waiting_for_lock_ = std::chrono::nanoseconds(0);
+        spent_in_reporting_ = std::chrono::nanoseconds(0);
+        request("The profiler has been reset.\n");
+      } else {
+        const std::string& format = request.url.query.get("format", "");
+        if (format == "folded") {
+          request(GenerateFoldedStacks());
+        } else if (format == "trace") {
+          request(GenerateChromeTrace());
         } else {
-          const std::chrono::microseconds pre_report = current::time::Now();
-          request(state_.GenerateReport());
-          const std::chrono::microseconds post_report = current::time::Now();
-          state_.spent_in_reporting += (post_report - pre_report);
+          request(GenerateReport());
         }
-      });
+        spent_in_reporting_ += (SteadyNow() - pre_report);
+      }
     }
 
    private:
-    template <typename F>
-    void Guarded(F&& f) {
-      const std::chrono::microseconds pre_mutex_lock = current::time::Now();
-      std::lock_guard<std::mutex> lock(mutex_);
-      const std::chrono::microseconds post_mutex_lock = current::time::Now();
-      f(post_mutex_lock, state_.per_thread[std::this_thread::get_id()]);
-      const std::chrono::microseconds post_guarded_code = current::time::Now();
-      state_.total_spent_in_profiling += (post_guarded_code - pre_mutex_lock);
-      state_.spent_in_mutex_locking += (post_mutex_lock - pre_mutex_lock);
+    PerThread& PerThreadState() {
+      ThisThread& this_thread = current::ThreadLocalSingleton<ThisThread>();
+      if (!this_thread.state) {
+        std::lock_guard<std::mutex> lock(threads_mutex_);
+        this_thread.state = std::make_shared<PerThread>(++last_thread_index_);
+        this_thread.maintainer = this;
+        threads_.push_back(this_thread.state);
+      }
+      return *this_thread.state;
     }
 
-    struct Scope {
-      Scope(const char*) {}
-      const char* scope;
-    };
+    // Folds the counters of the terminated thread into `retired_trie_`, and forgets the thread.
+    // Under `reporting_mutex_`, so that no report counts the thread twice, or not at all.
+    void RetireThread(const std::shared_ptr<PerThread>& per_thread) {
+      std::lock_guard<std::mutex> lock(reporting_mutex_);
+      {
+        std::lock_guard<std::mutex> threads_lock(threads_mutex_);
+        threads_.erase(std::remove(threads_.begin(), threads_.end(), per_thread), threads_.end());
+      }
+      const std::chrono::nanoseconds now = SteadyNow();
+      per_thread->Locked([&]() {
+        retired_trie_.RecursiveMerge(per_thread->trie, now);
+        retired_events_ += per_thread->events;
+        retired_spent_waiting_for_lock_ += per_thread->spent_waiting_for_lock;
+      });
+      ++retired_threads_;
+    }
+
+    std::vector<std::shared_ptr<PerThread>> AllThreads() {
+      std::lock_guard<std::mutex> lock(threads_mutex_);
+      return threads_;
+    }
+
+    static std::chrono::microseconds AsMicroseconds(std::chrono::nanoseconds ns) {
+      return std::chrono::duration_cast<std::chrono::microseconds>(ns);
+    }
+
+    static void FillReport(const PerThread::Trie& input,
+                           std::chrono::nanoseconds now,
+                           std::chrono::nanoseconds parent_total,
+                           PerThreadReporting& output,
+                           const char* scope) {
+      const std::chrono::nanoseconds total = input.ComputeTotalNanoseconds(now);
+      output.scope = scope;
+      output.entries = input.entries;
+      CURRENT_ASSERT(output.entries);
+      output.us = AsMicroseconds(total);
+      output.us_per_entry = 1e-3 * total.count() / output.entries;
+      output.us_p50 = 1e-3 * input.ns_histogram.Percentile(0.5);
+      output.us_p99 = 1e-3 * input.ns_histogram.Percentile(0.99);
+      output.us_p999 = 1e-3 * input.ns_histogram.Percentile(0.999);
+      output.absolute_best_possible_qps = total.count() ? (1e6 / output.us_per_entry) : 1e6;
+      output.ratio_of_parent = parent_total.count() ? (1.0 * total.count() / parent_total.count()) : 1.0;
+      output.subscope.resize(input.children.size());
+      std::chrono::nanoseconds subscope_total = std::chrono::nanoseconds(0);
+      for (size_t i = 0; i < input.children.size(); ++i) {
+        const PerThread::Trie& child = *input.children[i].second;
+        FillReport(child, now, total, output.subscope[i], input.children[i].first);
+        subscope_total += child.ComputeTotalNanoseconds(now);
+      }
+      CURRENT_ASSERT(subscope_total <= total);
+      output.subscope_total_ratio_of_parent = total.count() ? (1.0 * subscope_total.count() / total.count()) : 1.0;
+      std::sort(output.subscope.begin(), output.subscope.end());
+    }
+
+    ProfilingReport GenerateReport() {
+      const std::chrono::nanoseconds now = SteadyNow();
+      const std::vector<std::shared_ptr<PerThread>> all_threads = AllThreads();
+      ProfilingReport report;
+      PerThread::Trie merged;
+      uint64_t events = 0;
+      std::chrono::nanoseconds spent_waiting_for_lock = std::chrono::nanoseconds(0);
+      report.thread.resize(all_threads.size() + (retired_threads_ ? 1u : 0u));
+      for (size_t i = 0; i < all_threads.size(); ++i) {
+        PerThread& per_thread = *all_threads[i];
+        std::ostringstream thread_id_as_string;
+        thread_id_as_string << "C++ thread with internal ID " << per_thread.thread_id;
+        per_thread.Locked([&]() {
+          FillReport(per_thread.trie,
+                     now,
+                     per_thread.trie.ComputeTotalNanoseconds(now),
+                     report.thread[i],
+                     thread_id_as_string.str().c_str());
+          merged.RecursiveMerge(per_thread.trie, now);
+          events += per_thread.events;
+          spent_waiting_for_lock += per_thread.spent_waiting_for_lock;
+        });
+      }
+      if (retired_threads_) {
+        FillReport(retired_trie_,
+                   now,
+                   retired_trie_.ns_total,
+                   report.thread.back(),
+                   (current::ToString(retired_threads_) + " terminated thread(s)").c_str());
+        merged.RecursiveMerge(retired_trie_, now);
+        events += retired_events_;
+        spent_waiting_for_lock += retired_spent_waiting_for_lock_;
+      }
+      if (merged.entries) {
+        FillReport(merged, now, merged.ns_total, report.all_threads, "All threads");
+      }
+      report.profiling_overhead =
+          AsMicroseconds(std::chrono::nanoseconds(static_cast<int64_t>(events * ns_per_event_)));
+      report.profiling_mutex_overhead = AsMicroseconds(spent_waiting_for_lock);
+      report.reporting_overhead = AsMicroseconds(spent_in_reporting_);
+      return report;
+    }
+
+    // Self time is the time spent in the scope itself and not in any of its sub-scopes.
+    static void FoldStacks(const PerThread::Trie& input,
+                           std::chrono::nanoseconds now,
+                           const std::string& stack,
+                           std::string& output) {
+      std::chrono::nanoseconds self = input.ComputeTotalNanoseconds(now);
+      for (const auto& child : input.children) {
+        self -= child.second->ComputeTotalNanoseconds(now);
+        std::string scope(child.first);
+        // Semicolons separate the frames, and the last space separates the value.
+        std::replace(scope.begin(), scope.end(), ';', ':');
+        std::replace(scope.begin(), scope.end(), '\n', ' ');
+        FoldStacks(*child.second, now, stack.empty() ? scope : stack + ';' + scope, output);
+      }
+      const int64_t self_us = AsMicroseconds(self).count();
+      if (!stack.empty() && self_us > 0) {
+        output += stack + ' ' + current::ToString(self_us) + '\n';
+      }
+    }
+
+    std::string GenerateFoldedStacks() {
+      const std::chrono::nanoseconds now = SteadyNow();
+      PerThread::Trie merged;
+      for (const auto& per_thread : AllThreads()) {
+        per_thread->Locked([&]() { merged.RecursiveMerge(per_thread->trie, now); });
+      }
+      merged.RecursiveMerge(retired_trie_, now);
+      std::string output;
+      FoldStacks(merged, now, "", output);
+      return output;
+    }
+
+    ChromeTrace GenerateChromeTrace() {
+      ChromeTrace trace;
+      for (const auto& per_thread : AllThreads()) {
+        per_thread->Locked([&]() { per_thread->ExportTraceEvents(trace.traceEvents); });
+      }
+      return trace;
+    }
+
+    constexpr static size_t kCalibrationIterations = 10000;
+    double ns_per_event_;
+
+    std::mutex threads_mutex_;
+    std::vector<std::shared_ptr<PerThread>> threads_;
+    uint32_t last_thread_index_ = 0u;
 
-    std::mutex mutex_;
-    State state_;
+    // Guards the reports, the reset, and the data of the terminated threads below.
+    std::mutex reporting_mutex_;
+    std::chrono::nanoseconds spent_in_reporting_ = std::chrono::nanoseconds(0);
+    PerThread::Trie retired_trie_;
+    uint64_t retired_threads_ = 0u;
+    uint64_t retired_events_ = 0u;
+    std::chrono::nanoseconds retired_spent_waiting_for_lock_ = std::chrono::nanoseconds(0);
   };
 
   class ScopedStateMaintainer {
@@ -0,0 +1,170 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2015 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#define CURRENT_PROFILER
+#define CURRENT_PROFILER_TRACE_EVENTS_PER_THREAD 8  // Small enough for the unit test to wrap the ring around.
+
+#include "profiler.h"
+
+#include "../typesystem/serialization/json.h"
+
+#include "../bricks/dflags/dflags.h"
+#include "../bricks/strings/split.h"
+
+#include "../3rdparty/gtest/gtest-main-with-dflags.h"
+
+DEFINE_uint16(profiler_http_test_port, PickPortForUnitTest(), "Local port to use for the profiler unit test.");
+
+namespace profiler_unittest {
+
+// The profiler is a singleton, so all the tests share one route, and start by resetting it.
+struct ProfilerRoute {
+  HTTPRoutesScope scope;
+  ProfilerRoute() {
+    scope += HTTP(FLAGS_profiler_http_test_port).Register("/profiler", ::current::profiler::Profiler::HTTPRoute);
+  }
+  std::string Get(const std::string& query) const {
+    return HTTP(GET(Printf("http://localhost:%d/profiler%s", FLAGS_profiler_http_test_port, query.c_str()))).body;
+  }
+  void Reset() const { EXPECT_EQ("The profiler has been reset.\n", Get("?reset")); }
+};
+
+inline const ProfilerRoute& Route() {
+  static ProfilerRoute route;
+  return route;
+}
+
+inline void SleepInScope(const char* scope) {
+  CURRENT_PROFILER_SCOPE(scope);
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+}
+
+}  // namespace profiler_unittest
+
+TEST(Profiler, FoldedStacks) {
+  using namespace profiler_unittest;
+  Route().Reset();
+
+  {
+    CURRENT_PROFILER_SCOPE("folded_outer");
+    SleepInScope("folded;inner");
+    SleepInScope("folded;inner");
+  }
+
+  std::map<std::string, int64_t> self_us;
+  for (const auto& line : current::strings::Split<current::strings::ByLines>(Route().Get("?format=folded"))) {
+    const size_t space = line.rfind(' ');
+    ASSERT_NE(std::string::npos, space) << line;
+    self_us[line.substr(0, space)] = current::FromString<int64_t>(line.substr(space + 1));
+  }
+  // The semicolons within the scope names are not to be confused with the frame separators.
+  ASSERT_TRUE(self_us.count("folded_outer;folded:inner"));
+  EXPECT_GE(self_us["folded_outer;folded:inner"], 4000);
+  if (self_us.count("folded_outer")) {
+    EXPECT_LT(self_us["folded_outer"], self_us["folded_outer;folded:inner"]);
+  }
+}
+
+TEST(Profiler, ChromeTrace) {
+  using namespace profiler_unittest;
+  Route().Reset();
+
+  {
+    CURRENT_PROFILER_SCOPE("trace_outer");
+    SleepInScope("trace_inner");
+  }
+
+  const auto trace = ParseJSON<current::profiler::ChromeTrace>(Route().Get("?format=trace"));
+  std::string events;
+  double ts = 0.0;
+  for (const auto& event : trace.traceEvents) {
+    events += event.ph + ':' + event.name + ' ';
+    EXPECT_GE(event.ts, ts);
+    ts = event.ts;
+  }
+  EXPECT_EQ("B:trace_outer B:trace_inner E:trace_inner E:trace_outer ", events);
+  ASSERT_EQ(4u, trace.traceEvents.size());
+  EXPECT_GE(trace.traceEvents[2].ts - trace.traceEvents[1].ts, 2000.0);
+}
+
+TEST(Profiler, ChromeTraceRingWrapsAround) {
+  using namespace profiler_unittest;
+  Route().Reset();
+
+  // Twelve events, of which the ring keeps the last eight. The leave events of the scopes entered before the oldest
+  // event in the ring are skipped, so that the trace remains well-formed.
+  {
+    CURRENT_PROFILER_SCOPE("ring_outer");
+    for (int i = 0; i < 5; ++i) {
+      CURRENT_PROFILER_SCOPE("ring_inner");
+    }
+  }
+
+  const auto trace = ParseJSON<current::profiler::ChromeTrace>(Route().Get("?format=trace"));
+  std::string events;
+  for (const auto& event : trace.traceEvents) {
+    events += event.ph + ':' + event.name + ' ';
+  }
+  EXPECT_EQ("B:ring_inner E:ring_inner B:ring_inner E:ring_inner B:ring_inner E:ring_inner ", events);
+}
+
+TEST(Profiler, Reset) {
+  using namespace profiler_unittest;
+  Route().Reset();
+
+  SleepInScope("reset_scope");
+  EXPECT_NE(std::string::npos, Route().Get("?format=folded").find("reset_scope "));
+  EXPECT_FALSE(ParseJSON<current::profiler::ChromeTrace>(Route().Get("?format=trace")).traceEvents.empty());
+
+  Route().Reset();
+  EXPECT_EQ("", Route().Get("?format=folded"));
+  EXPECT_TRUE(ParseJSON<current::profiler::ChromeTrace>(Route().Get("?format=trace")).traceEvents.empty());
+  const auto report = ParseJSON<current::profiler::ProfilingReport>(Route().Get(""));
+  EXPECT_EQ(0, report.profiling_overhead.count());
+}
+
+TEST(Profiler, TerminatedThreadsAreMerged) {
+  using namespace profiler_unittest;
+  Route().Reset();
+
+  for (int i = 0; i < 10; ++i) {
+    std::thread([]() { SleepInScope("terminated_thread"); }).join();
+  }
+
+  const auto report = ParseJSON<current::profiler::ProfilingReport>(Route().Get(""));
+  // The terminated threads are reported as one entry.
+  ASSERT_FALSE(report.thread.empty());
+  EXPECT_LE(report.thread.size(), 2u);
+  const auto& terminated = report.thread.back();
+  EXPECT_EQ("10 terminated thread(s)", terminated.scope);
+  ASSERT_EQ(1u, terminated.subscope.size());
+  EXPECT_EQ("terminated_thread", terminated.subscope[0].scope);
+  EXPECT_EQ(10u, terminated.subscope[0].entries);
+  EXPECT_GE(terminated.subscope[0].us.count(), 20000);
+
+  EXPECT_NE(std::string::npos, Route().Get("?format=folded").find("terminated_thread "));
+
+  Route().Reset();
+  EXPECT_EQ("", Route().Get("?format=folded"));
+}
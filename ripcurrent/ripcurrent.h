@@ -49,12 +49,17 @@ SOFTWARE.
 
 #include "types.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <vector>
 
@@ -81,6 +86,7 @@ struct Definition {
 
   struct Pipe final {};  // A helper to describe a composite block built with '|'.
   struct Plus final {};  // A helper to describe a composite block built with '+'.
+  struct Wrap final {};  // A helper to describe a block wrapped into a combinator, such as `Parallel<N>(...)`.
 
   static std::vector<std::pair<std::string, FileLine>> CombineSources(const Definition& a, const Definition& b) {
     std::vector<std::pair<std::string, FileLine>> sources;
@@ -100,6 +106,8 @@ struct Definition {
       : statement(from.statement + " | " + into.statement), sources(CombineSources(from, into)) {}
   Definition(Plus, const Definition& a, const Definition& b)
       : statement(a.statement + " + " + b.statement), sources(CombineSources(a, b)) {}
+  Definition(Wrap, const std::string& wrapper, const Definition& block)
+      : statement(wrapper + '(' + block.statement + ')'), sources(block.sources) {}
   virtual ~Definition() = default;
 };
 
@@ -226,6 +234,8 @@ class GenericBlockOutgoingInterface {
   virtual void OnThreadUnsafeEmitted(movable_message_t&&, std::chrono::microseconds) = 0;
   virtual void OnThreadUnsafeScheduled(movable_message_t&&, std::chrono::microseconds) = 0;
   virtual void OnThreadUnsafeHeadUpdated(std::chrono::microseconds) = 0;
+  // `emit<>` goes here, so that the timestamp is only taken if it is needed.
+  virtual void OnThreadUnsafeEmittedNow(movable_message_t&& x) { OnThreadUnsafeEmitted(std::move(x), time::Now()); }
 };
 
 template <class>
@@ -354,6 +364,33 @@ class RipCurrentScope final {
   std::string description_as_text_;
 };
 
+// How the messages are handed over to a block via the `|` in front of it. By default, each message is handed over
+// on its own, for the lowest latency. With `Batched(block, policy)`, the messages are buffered on the sending side,
+// and handed over in batches, so that one lock acquisition and one wakeup of the receiving thread cover many of them.
+// * `FlushOnIdle()`: Buffer only while the receiving block is busy with the messages handed over before,
+//   and hand the buffer over as soon as it is done with them, or once the buffer is full.
+// * `FlushAfter(max_latency)`: Buffer for up to `max_latency` since the first buffered message, or until it is full.
+struct BatchingPolicy final {
+  size_t max_batch_size = 1u;
+  std::chrono::microseconds max_latency = std::chrono::microseconds(0);
+
+  bool IsBatching() const { return max_batch_size > 1u; }
+  bool FlushesOnIdle() const { return IsBatching() && max_latency.count() == 0; }
+
+  static BatchingPolicy PerMessage() { return BatchingPolicy(); }
+  static BatchingPolicy FlushOnIdle(size_t max_batch_size = 256u) {
+    BatchingPolicy policy;
+    policy.max_batch_size = max_batch_size;
+    return policy;
+  }
+  static BatchingPolicy FlushAfter(std::chrono::microseconds max_latency, size_t max_batch_size = 256u) {
+    BatchingPolicy policy;
+    policy.max_batch_size = max_batch_size;
+    policy.max_latency = max_latency;
+    return policy;
+  }
+};
+
 // Template logic to wrap runnable RipCurrent flows into abstract classes of templated types,
 // keeping track of the inbound and outgoing types of the simple or compound block being described.
 // Runnable RipCurrent flows would generally be `shared_ptr<AbstractCurrent<LHS, RHS>>`-s, containing references
@@ -373,6 +410,13 @@ class AbstractCurrent<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>>
   virtual std::shared_ptr<SubCurrentScope<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>>> Run(
       std::shared_ptr<BlockOutgoingInterface<ThreadUnsafeOutgoingTypes<RHS_TYPES...>>>) const = 0;
 
+  // How the messages should be handed over to this block by the `|` in front of it.
+  virtual BatchingPolicy IncomingBatchingPolicy() const { return BatchingPolicy::PerMessage(); }
+
+  // Whether this is a single user block, which only emits from its own constructor and `f()`, as opposed to
+  // a composite one, which may emit from the threads of the MMPQs within it.
+  virtual bool IsSingleBlock() const { return false; }
+
   struct Traits final {
     using input_t = LHSTypes<LHS_TYPES...>;
     using output_t = RHSTypes<RHS_TYPES...>;
@@ -400,6 +444,9 @@ class SharedCurrent<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>>
     return super_->Run(next);
   }
 
+  BatchingPolicy IncomingBatchingPolicy() const override { return super_->IncomingBatchingPolicy(); }
+  bool IsSingleBlock() const override { return super_->IsSingleBlock(); }
+
   // User-facing `RipCurrent()` method, only for "closed", end-to-end flows.
   template <int IN_N = sizeof...(LHS_TYPES), int OUT_N = sizeof...(RHS_TYPES)>
   std::enable_if_t<IN_N == 0 && OUT_N == 0, RipCurrentScope> RipCurrent() const {
@@ -488,23 +535,19 @@ class CallsGeneratingBlock<EmittableTypes<EMITTED_TYPES...>> : public GenericCal
  protected:
   template <typename T, typename... ARGS>
   std::enable_if_t<TypeListContains<TypeListImpl<EMITTED_TYPES...>, T>::value> emit(ARGS&&... args) const {
-    // A seemingly unnecessary `release()` is due to `std::make_unique()` not supporting a custom deleter. -- D.K
-    handler_->OnThreadUnsafeEmitted(movable_message_t(std::make_unique<T>(std::forward<ARGS>(args)...).release()),
-                                    time::Now());
+    handler_->OnThreadUnsafeEmittedNow(MakeMessage<T>(std::forward<ARGS>(args)...));
   }
 
   template <typename T, typename... ARGS>
   std::enable_if_t<TypeListContains<TypeListImpl<EMITTED_TYPES...>, T>::value> post(std::chrono::microseconds t,
                                                                                     ARGS&&... args) const {
-    // A seemingly unnecessary `release()` is due to `std::make_unique()` not supporting a custom deleter. -- D.K
-    handler_->OnThreadUnsafeEmitted(movable_message_t(std::make_unique<T>(std::forward<ARGS>(args)...).release()), t);
+    handler_->OnThreadUnsafeEmitted(MakeMessage<T>(std::forward<ARGS>(args)...), t);
   }
 
   template <typename T, typename... ARGS>
   std::enable_if_t<TypeListContains<TypeListImpl<EMITTED_TYPES...>, T>::value> schedule(std::chrono::microseconds t,
                                                                                         ARGS&&... args) const {
-    // A seemingly unnecessary `release()` is due to `std::make_unique()` not supporting a custom deleter. -- D.K
-    handler_->OnThreadUnsafeScheduled(movable_message_t(std::make_unique<T>(std::forward<ARGS>(args)...).release()), t);
+    handler_->OnThreadUnsafeScheduled(MakeMessage<T>(std::forward<ARGS>(args)...), t);
   }
 
   void head(std::chrono::microseconds t) const { handler_->OnThreadUnsafeHeadUpdated(t); }
@@ -513,6 +556,25 @@ class CallsGeneratingBlock<EmittableTypes<EMITTED_TYPES...>> : public GenericCal
   outgoing_interface_t* handler_;
 };
 
+// Whether the current thread is running the `f()` of some block. Whatever such a block emits from its `f()` can be
+// passed on to the next block right away, on the same thread, instead of being handed over via the MMPQ of the `|`.
+// Thus, a chain of blocks that only `emit<>` from their `f()`-s runs as a sequence of direct calls.
+class SynchronousDispatchScope final {
+ public:
+  SynchronousDispatchScope() { ++Depth(); }
+  ~SynchronousDispatchScope() { --Depth(); }
+  static bool InProgress() { return Depth() != 0u; }
+
+ private:
+  struct DepthHolder {
+    size_t depth = 0u;
+  };
+  static size_t& Depth() { return ThreadLocalSingleton<DepthHolder>().depth; }
+
+  SynchronousDispatchScope(const SynchronousDispatchScope&) = delete;
+  SynchronousDispatchScope& operator=(const SynchronousDispatchScope&) = delete;
+};
+
 // `UserClassInstantiator` instantiates the user class passed in as `USER_CLASS`.
 // It serves two purposes:
 // 1) Itself, it inherits from `BlockIncomingInterface<ThreadSafeIncomingTypes<LHS_TYPES...>>`, and can accept entries.
@@ -534,6 +596,7 @@ class UserClassInstantiator<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>, USER
       : scope_(&impl_, next.get()), impl_(std::forward<ARGS>(args)...) {}
 
   void OnThreadSafeMessage(movable_message_t&& x) override {
+    const SynchronousDispatchScope synchronous_dispatch_scope;
     RTTIDynamicCall<TypeListImpl<LHS_TYPES...>, CurrentSuper>(std::move(*x), *this);
   }
 
@@ -619,6 +682,8 @@ class UserCodeInstantiator<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>, USER_
     return std::make_shared<Scope>(lazy_instance_, next);
   }
 
+  bool IsSingleBlock() const override { return true; }
+
  private:
   current::LazilyInstantiated<UserClassInstantiator<instantiator_input_t, instantiator_output_t, USER_CLASS>,
                               std::shared_ptr<BlockOutgoingInterface<ThreadUnsafeOutgoingTypes<RHS_TYPES...>>>>
@@ -691,7 +756,7 @@ class SharedSequenceImpl<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>, VIAType
           std::shared_ptr<BlockOutgoingInterface<ThreadUnsafeOutgoingTypes<RHS_TYPES...>>> next)
         : next_(next),
           into_(self->Into().Run(next_)),
-          into_mmpq_(std::make_shared<MMPQWrapper>(into_)),
+          into_mmpq_(std::make_shared<MMPQWrapper>(into_, self->Into().IncomingBatchingPolicy())),
           from_(self->From().Run(into_mmpq_)) {
       self->MarkAs(BlockUsageBit::HasBeenRun);
     }
@@ -699,41 +764,75 @@ class SharedSequenceImpl<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>, VIAType
     void OnThreadSafeMessage(movable_message_t&& x) override { from_->OnThreadSafeMessage(std::move(x)); }
 
    private:
+    // Hands the messages over from `from` to `into`.
+    //
+    // A message emitted from within the `f()` of a block, as indicated by `SynchronousDispatchScope`, goes to `into`
+    // right away, on the very same thread, as long as nothing is waiting in the MMPQ. The messages emitted from other
+    // threads, such as from the source blocks, and the `schedule<>`-d ones, go through the MMPQ, and reach `into` from
+    // its thread. Either way, `into` is only called from one thread at a time, and in the order of the timestamps.
+    //
+    // With a batching policy, the messages that would go through the MMPQ are buffered first, see `BatchingPolicy`.
     class MMPQWrapper final : public BlockOutgoingInterface<ThreadUnsafeOutgoingTypes<VIA_X, VIA_XS...>> {
      public:
-      explicit MMPQWrapper(
-          std::shared_ptr<BlockIncomingInterface<ThreadSafeIncomingTypes<VIA_X, VIA_XS...>>> destination)
-          : single_threaded_processor_(waitable_counters_, destination), mmpq_(single_threaded_processor_) {}
+      MMPQWrapper(std::shared_ptr<BlockIncomingInterface<ThreadSafeIncomingTypes<VIA_X, VIA_XS...>>> destination,
+                  BatchingPolicy policy)
+          : destination_(destination),
+            policy_(policy),
+            single_threaded_processor_(this),
+            mmpq_(single_threaded_processor_) {
+        if (policy_.IsBatching() && !policy_.FlushesOnIdle()) {
+          flusher_thread_ = std::thread([this]() { FlusherThread(); });
+        }
+      }
 
       ~MMPQWrapper() {
-        waitable_counters_.Wait([](const ThreadMessageCounters& counters) { return counters.ProcessedEverything(); });
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          Flush();
+          everything_processed_.wait(lock, [this]() { return !queued_ && buffer_.empty(); });
+          destructing_ = true;
+        }
+        if (flusher_thread_.joinable()) {
+          flush_condition_.notify_one();
+          flusher_thread_.join();
+        }
+      }
+
+      void OnThreadUnsafeEmittedNow(movable_message_t&& x) override {
+        // Whatever is passed on directly needs no timestamp, as there is nothing in the MMPQ to order it against.
+        if (!TryPassOnDirectly(x, nullptr)) {
+          Publish(std::move(x), time::Now());
+        }
       }
 
       void OnThreadUnsafeEmitted(movable_message_t&& x, std::chrono::microseconds t) override {
-        waitable_counters_.MutableUse([](ThreadMessageCounters& p) { p.ReportPublishCalled(); });
-        try {
-          mmpq_.UpdateHead(t);  // Run `UpdateHead` before `Publish`, as the latter does not validate monotocinity.
-          mmpq_.Publish(std::move(x), t);
-          waitable_counters_.MutableUse([](ThreadMessageCounters& p) { p.ReportMessagePublished(); });
-        } catch (const ss::InconsistentTimestampException& e) {
-          current::Singleton<RipCurrentMockableErrorHandler>().HandleError(e.DetailedDescription());
-          waitable_counters_.MutableUse([](ThreadMessageCounters& p) { p.ReportMessageNotPublished(); });
+        if (!TryPassOnDirectly(x, &t)) {
+          Publish(std::move(x), t);
         }
       }
 
       void OnThreadUnsafeScheduled(movable_message_t&& x, std::chrono::microseconds t) override {
-        waitable_counters_.MutableUse([](ThreadMessageCounters& p) { p.ReportPublishCalled(); });
         try {
+          std::lock_guard<std::mutex> lock(mutex_);
+          Flush();
+          // The MMPQ has not seen the messages that were passed on directly, so let it catch up first.
+          if (mmpq_head_ < head_) {
+            mmpq_head_ = head_;
+            mmpq_.UpdateHead(head_);
+          }
           mmpq_.Publish(std::move(x), t);
-          waitable_counters_.MutableUse([](ThreadMessageCounters& p) { p.ReportMessagePublished(); });
+          ++queued_;
         } catch (const ss::InconsistentTimestampException& e) {
           current::Singleton<RipCurrentMockableErrorHandler>().HandleError(e.DetailedDescription());
-          waitable_counters_.MutableUse([](ThreadMessageCounters& p) { p.ReportMessageNotPublished(); });
         }
       }
 
       void OnThreadUnsafeHeadUpdated(std::chrono::microseconds t) override {
         try {
+          std::lock_guard<std::mutex> lock(mutex_);
+          AdvanceHead(t);
+          Flush();
+          mmpq_head_ = t;
           mmpq_.UpdateHead(t);
         } catch (const ss::InconsistentTimestampException& e) {
           current::Singleton<RipCurrentMockableErrorHandler>().HandleError(e.DetailedDescription());
@@ -741,40 +840,140 @@ class SharedSequenceImpl<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>, VIAType
       }
 
      private:
-      class ThreadMessageCounters {
-       public:
-        void ReportPublishCalled() { ++publish_called_count_; }
-        void ReportMessagePublished() { ++published_count_; }
-        void ReportMessageNotPublished() { ++not_published_count_; }
-        void ReportMessageProcessed() { ++processed_count_; }
-        bool ProcessedEverything() const { return publish_called_count_ == processed_count_ + not_published_count_; }
-
-       private:
-        size_t publish_called_count_ = 0u;
-        size_t published_count_ = 0u;
-        size_t not_published_count_ = 0u;
-        size_t processed_count_ = 0u;
-      };
+      // Passes the message on to `into` right away if it was emitted from within the `f()` of some block, and if
+      // nothing is waiting in the MMPQ. The timestamp, if provided, should still be greater than all the previous ones.
+      bool TryPassOnDirectly(movable_message_t& x, const std::chrono::microseconds* t) {
+        if (!SynchronousDispatchScope::InProgress()) {
+          return false;
+        }
+        std::lock_guard<std::mutex> dispatch_lock(dispatch_mutex_);
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          if (queued_ || !buffer_.empty() || (t && !(*t > head_))) {
+            return false;
+          }
+          if (t) {
+            head_ = *t;
+          }
+        }
+        destination_->OnThreadSafeMessage(std::move(x));
+        return true;
+      }
+
+      void Publish(movable_message_t&& x, std::chrono::microseconds t) {
+        try {
+          std::lock_guard<std::mutex> lock(mutex_);
+          AdvanceHead(t);
+          if (policy_.IsBatching() && (queued_ || !policy_.FlushesOnIdle())) {
+            if (buffer_.empty() && !policy_.FlushesOnIdle()) {
+              flush_deadline_ = std::chrono::steady_clock::now() + policy_.max_latency;
+              flush_condition_.notify_one();
+            }
+            buffer_.emplace_back(std::move(x), t);
+            if (buffer_.size() >= policy_.max_batch_size) {
+              Flush();
+            }
+          } else {
+            // Run `UpdateHead` before `Publish`, as the latter does not validate monotocinity.
+            mmpq_head_ = t;
+            mmpq_.UpdateHead(t);
+            mmpq_.Publish(std::move(x), t);
+            ++queued_;
+          }
+        } catch (const ss::InconsistentTimestampException& e) {
+          current::Singleton<RipCurrentMockableErrorHandler>().HandleError(e.DetailedDescription());
+        }
+      }
+
+      // Must be called with `mutex_` locked.
+      void AdvanceHead(std::chrono::microseconds t) {
+        if (!(t > head_)) {
+          CURRENT_THROW(ss::InconsistentTimestampException(head_ + std::chrono::microseconds(1), t));
+        }
+        head_ = t;
+      }
+
+      // Must be called with `mutex_` locked. A batch the MMPQ rejects as a whole is dropped and reported,
+      // the same way a single message is, so that neither `queued_` nor the destructor waits for it.
+      void Flush() {
+        if (!buffer_.empty()) {
+          const size_t size = buffer_.size();
+          const std::chrono::microseconds last = buffer_.back().second;
+          try {
+            mmpq_.PublishBatchAndUpdateHead(buffer_);
+          } catch (const ss::InconsistentTimestampException& e) {
+            buffer_.clear();
+            if (!queued_) {
+              everything_processed_.notify_all();
+            }
+            current::Singleton<RipCurrentMockableErrorHandler>().HandleError(e.DetailedDescription());
+            return;
+          }
+          queued_ += size;
+          mmpq_head_ = last;
+        }
+      }
+
+      void FlusherThread() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!destructing_) {
+          if (buffer_.empty()) {
+            flush_condition_.wait(lock);
+          } else if (std::chrono::steady_clock::now() < flush_deadline_) {
+            flush_condition_.wait_until(lock, flush_deadline_);
+          } else {
+            Flush();
+          }
+        }
+      }
+
+      void PassOnFromMMPQ(movable_message_t&& x) {
+        {
+          std::lock_guard<std::mutex> dispatch_lock(dispatch_mutex_);
+          destination_->OnThreadSafeMessage(std::move(x));
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!--queued_) {
+          if (policy_.FlushesOnIdle()) {
+            Flush();
+          }
+          if (!queued_ && buffer_.empty()) {
+            everything_processed_.notify_all();
+          }
+        }
+      }
 
       struct SingleThreadedProcessorImpl {
-        SingleThreadedProcessorImpl(
-            WaitableAtomic<ThreadMessageCounters>& waitable_counters,
-            std::shared_ptr<BlockIncomingInterface<ThreadSafeIncomingTypes<VIA_X, VIA_XS...>>> next)
-            : waitable_counters_(waitable_counters), next_(next) {}
+        explicit SingleThreadedProcessorImpl(MMPQWrapper* self) : self_(self) {}
 
         ss::EntryResponse operator()(movable_message_t&& e, idxts_t, idxts_t) {
-          next_->OnThreadSafeMessage(std::move(e));
-          waitable_counters_.MutableUse([](ThreadMessageCounters& p) { p.ReportMessageProcessed(); });
+          self_->PassOnFromMMPQ(std::move(e));
           return ss::EntryResponse::More;
         }
 
-        WaitableAtomic<ThreadMessageCounters>& waitable_counters_;
-        std::shared_ptr<BlockIncomingInterface<ThreadSafeIncomingTypes<VIA_X, VIA_XS...>>> next_;
+        MMPQWrapper* self_;
       };
 
-      WaitableAtomic<ThreadMessageCounters> waitable_counters_;
+      std::shared_ptr<BlockIncomingInterface<ThreadSafeIncomingTypes<VIA_X, VIA_XS...>>> destination_;
+      const BatchingPolicy policy_;
+
+      // Held while `destination_` is being called, whether directly or from the thread of the MMPQ.
+      std::mutex dispatch_mutex_;
+
+      // Guards the fields below, and keeps the order of the messages in the MMPQ consistent with `head_`.
+      std::mutex mutex_;
+      size_t queued_ = 0u;  // The number of messages in the MMPQ that have not been passed on yet.
+      std::chrono::microseconds head_ = std::chrono::microseconds(-1);
+      std::chrono::microseconds mmpq_head_ = std::chrono::microseconds(-1);
+      std::vector<std::pair<movable_message_t, std::chrono::microseconds>> buffer_;
+      std::chrono::steady_clock::time_point flush_deadline_;
+      std::condition_variable flush_condition_;
+      std::condition_variable everything_processed_;
+      bool destructing_ = false;
+
       current::ss::EntrySubscriber<SingleThreadedProcessorImpl, movable_message_t> single_threaded_processor_;
       mmq::MMPQ<movable_message_t, current::ss::EntrySubscriber<SingleThreadedProcessorImpl, movable_message_t>> mmpq_;
+      std::thread flusher_thread_;
     };
 
     // Construction / destruction order matters: { next, into, from }.
@@ -789,6 +988,8 @@ class SharedSequenceImpl<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>, VIAType
     return std::make_shared<Scope>(this, next);
   }
 
+  BatchingPolicy IncomingBatchingPolicy() const override { return from_.IncomingBatchingPolicy(); }
+
  protected:
   const SharedCurrent<LHSTypes<LHS_TYPES...>, RHSTypes<VIA_X, VIA_XS...>>& From() const { return from_; }
   const SharedCurrent<LHSTypes<VIA_X, VIA_XS...>, RHSTypes<RHS_TYPES...>>& Into() const { return into_; }
@@ -856,36 +1057,37 @@ class SharedParallelImpl<LHSTypes<AB_LHS...>,
       self->MarkAs(BlockUsageBit::HasBeenRun);
     }
 
+    // Only looks at the type of the message, so that the message itself is passed on as is, with no copies.
     class Router {
      public:
-      explicit Router(Scope* self) : self_(self) {}
+      explicit Router(bool& route_to_a) : route_to_a_(route_to_a) {}
 
       template <typename X>
-      void operator()(X&& x) {
+      void operator()(const X&) {
         constexpr bool a = metaprogramming::TypeListContains<TypeListImpl<A_LHS...>, X>::value;
         constexpr bool b = metaprogramming::TypeListContains<TypeListImpl<B_LHS...>, X>::value;
         static_assert(a != b, "Type X should be either in A's input, or in B's input, but not both.");
-        // This is to be cleaned up. -- D.K., TODO(dkorolev), FIXME DIMA.
-        auto y = movable_message_t(std::make_unique<X>(std::move(x)).release());
-        if (a) {
-          self_->a_->OnThreadSafeMessage(std::move(y));
-        } else {
-          self_->b_->OnThreadSafeMessage(std::move(y));
-        }
+        route_to_a_ = a;
       }
 
-      void operator()(CurrentSuper&&) {
+      void operator()(const CurrentSuper&) {
         // Should define this method to make sure the RTTI call compiles.
         CURRENT_ASSERT(false);
       }
 
      private:
-      Scope* self_;
+      bool& route_to_a_;
     };
 
     void OnThreadSafeMessage(movable_message_t&& x) override {
-      RTTIDynamicCall<metaprogramming::TypeListUnion<TypeListImpl<A_LHS...>, TypeListImpl<B_LHS...>>, CurrentSuper>(
-          std::move(*x), Router(this));
+      bool route_to_a = false;
+      RTTIDynamicCall<metaprogramming::TypeListUnion<TypeListImpl<A_LHS...>, TypeListImpl<B_LHS...>>>(
+          static_cast<const CurrentSuper&>(*x), Router(route_to_a));
+      if (route_to_a) {
+        a_->OnThreadSafeMessage(std::move(x));
+      } else {
+        b_->OnThreadSafeMessage(std::move(x));
+      }
     }
 
    private:
@@ -896,6 +1098,7 @@ class SharedParallelImpl<LHSTypes<AB_LHS...>,
       void OnThreadUnsafeEmitted(movable_message_t&& x, std::chrono::microseconds t) override {
         next->OnThreadUnsafeEmitted(std::move(x), t);
       }
+      void OnThreadUnsafeEmittedNow(movable_message_t&& x) override { next->OnThreadUnsafeEmittedNow(std::move(x)); }
       void OnThreadUnsafeScheduled(movable_message_t&& x, std::chrono::microseconds t) override {
         next->OnThreadUnsafeScheduled(std::move(x), t);
       }
@@ -907,6 +1110,7 @@ class SharedParallelImpl<LHSTypes<AB_LHS...>,
       void OnThreadUnsafeEmitted(movable_message_t&& x, std::chrono::microseconds t) override {
         next->OnThreadUnsafeEmitted(std::move(x), t);
       }
+      void OnThreadUnsafeEmittedNow(movable_message_t&& x) override { next->OnThreadUnsafeEmittedNow(std::move(x)); }
       void OnThreadUnsafeScheduled(movable_message_t&& x, std::chrono::microseconds t) override {
         next->OnThreadUnsafeScheduled(std::move(x), t);
       }
@@ -926,6 +1130,12 @@ class SharedParallelImpl<LHSTypes<AB_LHS...>,
     return std::make_shared<Scope>(this, next);
   }
 
+  // Both `A` and `B` are fed by the same `|`, so the policy of `A` takes precedence, if it has one.
+  BatchingPolicy IncomingBatchingPolicy() const override {
+    const BatchingPolicy a = a_.IncomingBatchingPolicy();
+    return a.IsBatching() ? a : b_.IncomingBatchingPolicy();
+  }
+
  protected:
   const SharedCurrent<LHSTypes<A_LHS...>, RHSTypes<A_RHS...>>& A() const { return a_; }
   const SharedCurrent<LHSTypes<B_LHS...>, RHSTypes<B_RHS...>>& B() const { return b_; }
@@ -956,6 +1166,377 @@ operator+(SharedCurrent<LHSTypes<A_LHS...>, RHSTypes<A_RHS...>> a,
       a, b);
 }
 
+// The implementation of the `Parallel<N>(block)` and `ParallelByKey<N>(block, key)` building blocks.
+//
+// Runs `N` instances of `block`, each on a worker thread of its own. Each worker has its own queue of pending
+// messages. Without a key, the messages are spread round-robin, and a worker that runs out of messages steals them
+// from the back of the queues of its busy peers, so the block should be stateless, or at least not care which of
+// the `N` instances sees which message. With a key, each message is routed to the instance `hash(key(message)) % N`,
+// and never stolen, so that each instance owns the state for its share of the keys, as in a histogram maintainer.
+//
+// With `ParallelOrdering::Preserved`, which is the default, whatever an instance emits while processing a message
+// is held back until everything emitted for the preceding input messages has been passed on, so the block behaves
+// exactly as its single-threaded version does, just faster. With `ParallelOrdering::Relaxed`, the output is passed on
+// as soon as it is emitted. The timestamps of the emitted messages are bumped where necessary to keep them strictly
+// increasing, as the next MMPQ expects.
+//
+// Only single blocks can be wrapped. What a composite block, such as `A | B`, emits may come from the thread of
+// an MMPQ within it, after its worker is done with the message, so it could not be attributed to that message.
+enum class ParallelOrdering : bool { Relaxed = false, Preserved = true };
+
+struct ParallelNoKey final {};
+
+template <size_t N, class LHS_TYPELIST, class RHS_TYPELIST, class KEY>
+class SharedParallelizedImpl;
+
+template <size_t N, class... LHS_TYPES, class... RHS_TYPES, class KEY>
+class SharedParallelizedImpl<N, LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>, KEY>
+    : public AbstractCurrent<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>> {
+ public:
+  static_assert(N > 0, "`Parallel<N>()` requires at least one instance.");
+  static_assert(sizeof...(LHS_TYPES) > 0, "`Parallel<N>()` requires a block that accepts messages.");
+
+  using block_t = SharedCurrent<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>>;
+  using next_t = std::shared_ptr<BlockOutgoingInterface<ThreadUnsafeOutgoingTypes<RHS_TYPES...>>>;
+
+  SharedParallelizedImpl(const std::string& wrapper, block_t block, KEY key, ParallelOrdering ordering)
+      : AbstractCurrent<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>>(
+            Definition(Definition::Wrap(), wrapper + '<' + std::to_string(N) + '>', block.GetDefinition())),
+        block_(block),
+        key_(key),
+        ordering_(ordering) {
+    block.MarkAs(BlockUsageBit::UsedInLargerBlock);
+    if (!block.IsSingleBlock()) {
+      std::ostringstream os;
+      os << '`' << wrapper << "<N>()` only wraps single blocks.\n";
+      block.GetDefinition().FullDescription(os);
+      current::Singleton<RipCurrentMockableErrorHandler>().HandleError(os.str());
+    }
+  }
+
+  class Scope final : public SubCurrentScope<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>> {
+   public:
+    Scope(const SharedParallelizedImpl* self, next_t next)
+        : next_(next), key_(self->key_), ordered_(self->ordering_ == ParallelOrdering::Preserved) {
+      for (size_t i = 0; i < N; ++i) {
+        workers_[i].collector = std::make_shared<Collector>(this, &workers_[i]);
+        workers_[i].instance = self->block_.Run(workers_[i].collector);
+      }
+      for (size_t i = 0; i < N; ++i) {
+        workers_[i].thread = std::thread([this, i]() { WorkerThread(i); });
+      }
+      self->MarkAs(BlockUsageBit::HasBeenRun);
+    }
+
+    ~Scope() {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this]() { return processed_ == dispatched_; });
+      }
+      terminating_ = true;
+      for (Worker& worker : workers_) {
+        worker.Wake();
+      }
+      for (Worker& worker : workers_) {
+        worker.thread.join();
+      }
+    }
+
+    void OnThreadSafeMessage(movable_message_t&& x) override {
+      const size_t index = WorkerIndex(key_, *x);
+      Worker& worker = workers_[index];
+      {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queue.push_back(Task(dispatched_++, std::move(x)));
+      }
+      worker.condition_variable.notify_one();
+      if (std::is_same<KEY, ParallelNoKey>::value && worker.busy) {
+        // Wake up an idle worker, if any, so that it steals the message that has just been queued.
+        for (size_t i = 1; i < N; ++i) {
+          Worker& thief = workers_[(index + i) % N];
+          if (!thief.busy) {
+            thief.Wake();
+            break;
+          }
+        }
+      }
+    }
+
+   private:
+    struct Task final {
+      uint64_t sequence_number = 0u;
+      movable_message_t message;
+      Task() = default;
+      Task(uint64_t sequence_number, movable_message_t&& message)
+          : sequence_number(sequence_number), message(std::move(message)) {}
+    };
+
+    enum class OutputKind { Emitted, Scheduled, HeadUpdated };
+    struct Output final {
+      OutputKind kind;
+      movable_message_t message;
+      std::chrono::microseconds t;
+      Output(OutputKind kind, movable_message_t&& message, std::chrono::microseconds t)
+          : kind(kind), message(std::move(message)), t(t) {}
+    };
+
+    struct Collector;
+
+    struct Worker final {
+      std::mutex mutex;
+      std::condition_variable condition_variable;
+      std::deque<Task> queue;
+      bool woken = false;
+      std::atomic_bool busy{false};
+
+      // Only touched from the thread of this worker, or by the constructor and the destructor of the scope.
+      // As the wrapped block is a single one, whatever it emits while `processing` comes from this very thread.
+      bool processing = false;
+      std::vector<Output> outputs;
+      std::shared_ptr<Collector> collector;
+      std::shared_ptr<SubCurrentScope<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>>> instance;
+      std::thread thread;
+
+      void Wake() {
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          woken = true;
+        }
+        condition_variable.notify_one();
+      }
+    };
+
+    // The `next` handler for the instance run by a particular worker.
+    struct Collector final : BlockOutgoingInterface<ThreadUnsafeOutgoingTypes<RHS_TYPES...>> {
+      Scope* const scope;
+      Worker* const worker;
+      Collector(Scope* scope, Worker* worker) : scope(scope), worker(worker) {}
+      void OnThreadUnsafeEmitted(movable_message_t&& x, std::chrono::microseconds t) override {
+        scope->OnOutput(*worker, OutputKind::Emitted, std::move(x), t);
+      }
+      void OnThreadUnsafeScheduled(movable_message_t&& x, std::chrono::microseconds t) override {
+        scope->OnOutput(*worker, OutputKind::Scheduled, std::move(x), t);
+      }
+      void OnThreadUnsafeHeadUpdated(std::chrono::microseconds t) override {
+        scope->OnOutput(*worker, OutputKind::HeadUpdated, nullptr, t);
+      }
+    };
+
+    size_t WorkerIndex(const ParallelNoKey&, const CurrentSuper&) { return round_robin_++ % N; }
+
+    template <typename K>
+    size_t WorkerIndex(const K& key, const CurrentSuper& x) {
+      size_t hash = 0u;
+      RTTIDynamicCall<TypeListImpl<LHS_TYPES...>>(x, KeyHasher<K>(key, hash));
+      return hash % N;
+    }
+
+    template <typename K>
+    struct KeyHasher final {
+      const K& key;
+      size_t& hash;
+      KeyHasher(const K& key, size_t& hash) : key(key), hash(hash) {}
+      template <typename X>
+      void operator()(const X& x) {
+        using key_t = current::decay<decltype(key(x))>;
+        hash = std::hash<key_t>()(key(x));
+      }
+    };
+
+    bool PopOwnTask(Worker& worker, Task& task) {
+      std::lock_guard<std::mutex> lock(worker.mutex);
+      if (worker.queue.empty()) {
+        return false;
+      }
+      task = std::move(worker.queue.front());
+      worker.queue.pop_front();
+      return true;
+    }
+
+    bool StealTask(size_t index, Task& task) {
+      if (std::is_same<KEY, ParallelNoKey>::value) {
+        for (size_t i = 1; i < N; ++i) {
+          Worker& victim = workers_[(index + i) % N];
+          std::lock_guard<std::mutex> lock(victim.mutex);
+          if (!victim.queue.empty()) {
+            task = std::move(victim.queue.back());
+            victim.queue.pop_back();
+            return true;
+          }
+        }
+      }
+      return false;
+    }
+
+    void WorkerThread(size_t index) {
+      Worker& worker = workers_[index];
+      Task task;
+      while (true) {
+        if (PopOwnTask(worker, task) || StealTask(index, task)) {
+          worker.busy = true;
+          worker.processing = true;
+          worker.instance->OnThreadSafeMessage(std::move(task.message));
+          worker.processing = false;
+          OnTaskProcessed(task.sequence_number, worker.outputs);
+          worker.busy = false;
+        } else {
+          std::unique_lock<std::mutex> lock(worker.mutex);
+          worker.condition_variable.wait(
+              lock, [&worker, this]() { return !worker.queue.empty() || worker.woken || terminating_; });
+          if (worker.queue.empty() && terminating_) {
+            return;
+          }
+          worker.woken = false;
+        }
+      }
+    }
+
+    void OnOutput(Worker& worker, OutputKind kind, movable_message_t&& x, std::chrono::microseconds t) {
+      if (ordered_ && worker.processing) {
+        worker.outputs.emplace_back(kind, std::move(x), t);
+      } else {
+        std::lock_guard<std::mutex> lock(mutex_);
+        PassOn(Output(kind, std::move(x), t));
+      }
+    }
+
+    void OnTaskProcessed(uint64_t sequence_number, std::vector<Output>& outputs) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (ordered_) {
+        if (sequence_number == next_to_pass_on_) {
+          PassOnAll(outputs);
+          ++next_to_pass_on_;
+          auto it = held_back_.begin();
+          while (it != held_back_.end() && it->first == next_to_pass_on_) {
+            PassOnAll(it->second);
+            it = held_back_.erase(it);
+            ++next_to_pass_on_;
+          }
+        } else {
+          held_back_[sequence_number] = std::move(outputs);
+        }
+        outputs.clear();
+      }
+      if (++processed_ == dispatched_) {
+        done_.notify_all();
+      }
+    }
+
+    // Must be called with `mutex_` locked.
+    void PassOnAll(std::vector<Output>& outputs) {
+      for (Output& output : outputs) {
+        PassOn(std::move(output));
+      }
+    }
+
+    // Must be called with `mutex_` locked.
+    void PassOn(Output&& output) {
+      if (output.kind == OutputKind::Emitted) {
+        last_t_ = std::max(output.t, last_t_ + std::chrono::microseconds(1));
+        next_->OnThreadUnsafeEmitted(std::move(output.message), last_t_);
+      } else if (output.kind == OutputKind::Scheduled) {
+        next_->OnThreadUnsafeScheduled(std::move(output.message), output.t);
+      } else if (output.t > last_t_) {
+        last_t_ = output.t;
+        next_->OnThreadUnsafeHeadUpdated(last_t_);
+      }
+    }
+
+    // Construction / destruction order matters: `next_` should outlive the instances run by the workers.
+    next_t next_;
+    const KEY key_;
+    const bool ordered_;
+
+    std::mutex mutex_;
+    std::condition_variable done_;
+    std::atomic<uint64_t> dispatched_{0u};
+    uint64_t processed_ = 0u;
+    uint64_t next_to_pass_on_ = 0u;
+    std::map<uint64_t, std::vector<Output>> held_back_;
+    std::chrono::microseconds last_t_ = std::chrono::microseconds(-1);
+
+    size_t round_robin_ = 0u;
+    std::atomic_bool terminating_{false};
+    Worker workers_[N];
+  };
+
+  std::shared_ptr<SubCurrentScope<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>>> Run(next_t next) const override {
+    return std::make_shared<Scope>(this, next);
+  }
+
+  BatchingPolicy IncomingBatchingPolicy() const override { return block_.IncomingBatchingPolicy(); }
+
+ private:
+  block_t block_;
+  const KEY key_;
+  const ParallelOrdering ordering_;
+};
+
+// `Parallel<N>(block)`, for stateless blocks.
+template <size_t N, class... LHS_TYPES, class... RHS_TYPES>
+SharedCurrent<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>> Parallel(
+    SharedCurrent<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>> block,
+    ParallelOrdering ordering = ParallelOrdering::Preserved) {
+  return SharedCurrent<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>>(
+      std::make_shared<SharedParallelizedImpl<N, LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>, ParallelNoKey>>(
+          "Parallel", block, ParallelNoKey(), ordering));
+}
+
+// `ParallelByKey<N>(block, key)`, for blocks that keep per-key state. The `key` should be callable with each
+// of the input types of the block, and return something `std::hash<>`-able.
+template <size_t N, class... LHS_TYPES, class... RHS_TYPES, class KEY>
+SharedCurrent<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>> ParallelByKey(
+    SharedCurrent<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>> block,
+    KEY key,
+    ParallelOrdering ordering = ParallelOrdering::Preserved) {
+  return SharedCurrent<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>>(
+      std::make_shared<SharedParallelizedImpl<N, LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>, KEY>>(
+          "ParallelByKey", block, key, ordering));
+}
+
+// The implementation of the `Batched(block, policy)` building block. Runs `block` as is, only changing
+// how the messages are handed over to it by the `|` in front of it. See `BatchingPolicy` above.
+template <class LHS_TYPELIST, class RHS_TYPELIST>
+class SharedBatchedImpl;
+
+template <class... LHS_TYPES, class... RHS_TYPES>
+class SharedBatchedImpl<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>>
+    : public AbstractCurrent<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>> {
+ public:
+  static_assert(sizeof...(LHS_TYPES) > 0, "`Batched()` requires a block that accepts messages.");
+
+  using block_t = SharedCurrent<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>>;
+
+  SharedBatchedImpl(block_t block, BatchingPolicy policy)
+      : AbstractCurrent<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>>(
+            Definition(Definition::Wrap(), "Batched", block.GetDefinition())),
+        block_(block),
+        policy_(policy) {
+    block.MarkAs(BlockUsageBit::UsedInLargerBlock);
+  }
+
+  std::shared_ptr<SubCurrentScope<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>>> Run(
+      std::shared_ptr<BlockOutgoingInterface<ThreadUnsafeOutgoingTypes<RHS_TYPES...>>> next) const override {
+    this->MarkAs(BlockUsageBit::HasBeenRun);
+    return block_.Run(next);
+  }
+
+  BatchingPolicy IncomingBatchingPolicy() const override { return policy_; }
+  bool IsSingleBlock() const override { return block_.IsSingleBlock(); }
+
+ private:
+  block_t block_;
+  const BatchingPolicy policy_;
+};
+
+template <class... LHS_TYPES, class... RHS_TYPES>
+SharedCurrent<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>> Batched(
+    SharedCurrent<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>> block,
+    BatchingPolicy policy = BatchingPolicy::FlushOnIdle()) {
+  return SharedCurrent<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>>(
+      std::make_shared<SharedBatchedImpl<LHSTypes<LHS_TYPES...>, RHSTypes<RHS_TYPES...>>>(block, policy));
+}
+
 // These `using`-s are the types the user can directly operate with.
 // All of them can be liberally copied over, since the logic is concealed within the inner `shared_ptr<>`.
 template <typename RHS_TYPELIST>
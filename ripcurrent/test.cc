@@ -1035,3 +1035,249 @@ TEST(RipCurrent, TemplatedFlow) {
   ((TemplatedEmitter(Integer) + TemplatedEmitter(String)) | DumpIntegerAndString(std::ref(result))).RipCurrent().Join();
   EXPECT_EQ("42, 'The Answer'", current::strings::Join(result, ", "));
 }
+
+namespace ripcurrent_unittest {
+
+// clang-format off
+RIPCURRENT_NODE(RCEmitRange, void, Integer) {
+  RCEmitRange(int n, int modulo = 0) {
+    for (int i = 0; i < n; ++i) {
+      emit<Integer>(modulo ? i % modulo : i);
+    }
+  }
+};
+#define RCEmitRange(...) RIPCURRENT_MACRO(RCEmitRange, __VA_ARGS__)
+
+// Emits `1000 * value + the number of times this value has been seen by this instance`.
+RIPCURRENT_NODE(RCCountPerValue, Integer, Integer) {
+  std::map<int, int> seen;
+  void f(Integer x) {
+    emit<Integer>(1000 * x.value + (++seen[x.value]));
+  }
+};
+#define RCCountPerValue(...) RIPCURRENT_MACRO(RCCountPerValue, __VA_ARGS__)
+// clang-format on
+
+struct IntegerValueAsKey {
+  int operator()(const Integer& x) const { return x.value; }
+};
+
+}  // namespace ripcurrent_unittest
+
+TEST(RipCurrent, ParallelDescription) {
+  using namespace ripcurrent_unittest;
+
+  std::vector<int> result;
+
+  const auto parallel_mult = current::ripcurrent::Parallel<4>(RCMult(2));
+  const auto parallel_count = current::ripcurrent::ParallelByKey<2>(RCCountPerValue(), IntegerValueAsKey());
+
+  EXPECT_EQ("... | Parallel<4>(RCMult(2)) | ...", parallel_mult.Describe());
+  EXPECT_EQ("... | { Integer } => ParallelByKey<2>(RCCountPerValue()) => { Integer } | ...",
+            parallel_count.DescribeWithTypes());
+  EXPECT_EQ("RCEmit(1) | Parallel<4>(RCMult(2)) | RCDump(std::ref(result))",
+            (RCEmit(1) | parallel_mult | RCDump(std::ref(result))).Describe());
+}
+
+TEST(RipCurrent, ParallelPreservesOrder) {
+  current::time::ResetToZero();
+
+  using namespace ripcurrent_unittest;
+
+  std::vector<int> result;
+  (RCEmitRange(1000) | current::ripcurrent::Parallel<4>(RCMult(2)) | RCMult(5) | RCDump(std::ref(result)))
+      .RipCurrent()
+      .Join();
+
+  std::vector<int> expected;
+  for (int i = 0; i < 1000; ++i) {
+    expected.push_back(i * 10);
+  }
+  EXPECT_EQ(current::strings::Join(expected, ','), current::strings::Join(result, ','));
+}
+
+TEST(RipCurrent, ParallelWithRelaxedOrdering) {
+  current::time::ResetToZero();
+
+  using namespace ripcurrent_unittest;
+
+  std::vector<int> result;
+  (RCEmitRange(1000) | current::ripcurrent::Parallel<3>(RCMult(3), current::ripcurrent::ParallelOrdering::Relaxed) |
+   RCDump(std::ref(result)))
+      .RipCurrent()
+      .Join();
+
+  ASSERT_EQ(1000u, result.size());
+  std::sort(result.begin(), result.end());
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(i * 3, result[i]);
+  }
+}
+
+TEST(RipCurrent, ParallelByKeyKeepsPerKeyState) {
+  current::time::ResetToZero();
+
+  using namespace ripcurrent_unittest;
+
+  std::vector<int> result;
+  (RCEmitRange(1000, 10) | current::ripcurrent::ParallelByKey<4>(RCCountPerValue(), IntegerValueAsKey()) |
+   RCDump(std::ref(result)))
+      .RipCurrent()
+      .Join();
+
+  // Each value is always routed to the same instance, so the per-value counters are exact, and in order.
+  std::vector<int> expected;
+  for (int i = 0; i < 1000; ++i) {
+    expected.push_back(1000 * (i % 10) + (i / 10 + 1));
+  }
+  EXPECT_EQ(current::strings::Join(expected, ','), current::strings::Join(result, ','));
+}
+
+TEST(RipCurrent, ParallelOnlyWrapsSingleBlocks) {
+  using namespace ripcurrent_unittest;
+
+  std::string captured_error_message;
+  const auto mock_scope = current::Singleton<current::ripcurrent::RipCurrentMockableErrorHandler>().ScopedInjectHandler(
+      [&captured_error_message](const std::string& error_message) { captured_error_message = error_message; });
+
+  current::ripcurrent::Parallel<2>(current::ripcurrent::Batched(RCMult(2))).Dismiss();
+  EXPECT_EQ("", captured_error_message);
+
+  current::ripcurrent::Parallel<2>(RCMult(2) | RCMult(3)).Dismiss();
+  EXPECT_EQ(
+      "`Parallel<N>()` only wraps single blocks.\n"
+      "... | RCMult(2) | RCMult(3) | ...",
+      ExpectHasNAndReturnFirstTwoLines(4, captured_error_message));
+
+  current::ripcurrent::ParallelByKey<2>(RCCountPerValue() | RCMult(2), IntegerValueAsKey()).Dismiss();
+  EXPECT_EQ(
+      "`ParallelByKey<N>()` only wraps single blocks.\n"
+      "... | RCCountPerValue() | RCMult(2) | ...",
+      ExpectHasNAndReturnFirstTwoLines(4, captured_error_message));
+
+  current::ripcurrent::Parallel<2>(current::ripcurrent::Parallel<2>(RCMult(2))).Dismiss();
+  EXPECT_EQ(
+      "`Parallel<N>()` only wraps single blocks.\n"
+      "... | Parallel<2>(RCMult(2)) | ...",
+      ExpectHasNAndReturnFirstTwoLines(3, captured_error_message));
+}
+
+namespace ripcurrent_unittest {
+
+// clang-format off
+RIPCURRENT_NODE(RCRecordThread, Integer, Integer) {
+  std::vector<std::thread::id>* ptr;
+  RCRecordThread() : ptr(nullptr) {}  // LCOV_EXCL_LINE
+  RCRecordThread(std::vector<std::thread::id>& ref) : ptr(&ref) {}
+  void f(Integer x) {
+    CURRENT_ASSERT(ptr);
+    ptr->push_back(std::this_thread::get_id());
+    emit<Integer>(x);
+  }
+};
+#define RCRecordThread(...) RIPCURRENT_MACRO(RCRecordThread, __VA_ARGS__)
+// clang-format on
+
+}  // namespace ripcurrent_unittest
+
+TEST(RipCurrent, SynchronousBlocksAreFused) {
+  current::time::ResetToZero();
+
+  using namespace ripcurrent_unittest;
+
+  std::vector<std::thread::id> a;
+  std::vector<std::thread::id> b;
+  std::vector<int> result;
+
+  // `RCEmitRange` emits from its constructor, so its messages go through the MMPQ. Past that point, the blocks only
+  // emit from their `f()`-s, so each message goes through the rest of the flow on the thread of that first MMPQ.
+  (RCEmitRange(100) | RCRecordThread(std::ref(a)) | RCMult(2) | RCRecordThread(std::ref(b)) | RCDump(std::ref(result)))
+      .RipCurrent()
+      .Join();
+
+  ASSERT_EQ(100u, a.size());
+  ASSERT_EQ(100u, b.size());
+  EXPECT_NE(std::this_thread::get_id(), a.front());
+  for (size_t i = 0; i < 100u; ++i) {
+    EXPECT_EQ(a.front(), a[i]);
+    EXPECT_EQ(a.front(), b[i]);
+    EXPECT_EQ(static_cast<int>(i * 2), result[i]);
+  }
+}
+
+TEST(RipCurrent, MessagesArePooled) {
+  using namespace ripcurrent_unittest;
+
+  const current::CurrentSuper* first;
+  {
+    current::ripcurrent::movable_message_t message = current::ripcurrent::MakeMessage<Integer>(42);
+    first = message.get();
+    EXPECT_EQ(42, dynamic_cast<const Integer&>(*message).value);
+  }
+  {
+    current::ripcurrent::movable_message_t message = current::ripcurrent::MakeMessage<Integer>(43);
+    EXPECT_EQ(first, message.get());
+    EXPECT_EQ(43, dynamic_cast<const Integer&>(*message).value);
+  }
+}
+
+TEST(RipCurrent, BatchedDescription) {
+  using namespace ripcurrent_unittest;
+
+  std::vector<int> result;
+
+  const auto batched_mult = current::ripcurrent::Batched(RCMult(2));
+
+  EXPECT_EQ("... | Batched(RCMult(2)) | ...", batched_mult.Describe());
+  EXPECT_EQ("RCEmit(1) | Batched(RCMult(2)) | RCDump(std::ref(result))",
+            (RCEmit(1) | batched_mult | RCDump(std::ref(result))).Describe());
+}
+
+TEST(RipCurrent, BatchedFlushOnIdle) {
+  current::time::ResetToZero();
+
+  using namespace ripcurrent_unittest;
+
+  std::vector<int> result;
+  (RCEmitRange(1000) | current::ripcurrent::Batched(RCMult(2), current::ripcurrent::BatchingPolicy::FlushOnIdle(16)) |
+   RCMult(5) | RCDump(std::ref(result)))
+      .RipCurrent()
+      .Join();
+
+  std::vector<int> expected;
+  for (int i = 0; i < 1000; ++i) {
+    expected.push_back(i * 10);
+  }
+  EXPECT_EQ(current::strings::Join(expected, ','), current::strings::Join(result, ','));
+}
+
+TEST(RipCurrent, BatchedFlushAfter) {
+  current::time::ResetToZero();
+
+  using namespace ripcurrent_unittest;
+
+  // The last, partial batch is handed over once `max_latency` has passed, even though nothing else is emitted.
+  // The scope is kept alive while waiting, as tearing it down would flush the remaining messages regardless.
+  std::vector<int> result;
+  std::atomic_size_t counter(0u);
+  const auto scope = std::move(
+      (RCEmitRange(1000) |
+       current::ripcurrent::Batched(RCMult(3),
+                                    current::ripcurrent::BatchingPolicy::FlushAfter(std::chrono::milliseconds(5), 64)) |
+       RCDump(std::ref(result), std::ref(counter)))
+          .RipCurrent()
+          .Async());
+
+  // 1000 is not a multiple of 64, so the last 40 messages can only be delivered by the timer.
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (counter != 1000u && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::yield();
+  }
+  ASSERT_EQ(1000u, counter.load());
+
+  std::vector<int> expected;
+  for (int i = 0; i < 1000; ++i) {
+    expected.push_back(i * 3);
+  }
+  EXPECT_EQ(current::strings::Join(expected, ','), current::strings::Join(result, ','));
+}
@@ -27,16 +27,127 @@ SOFTWARE.
 
 #include "../port.h"
 
+#include <algorithm>
 #include <iostream>
 #include <functional>
+#include <mutex>
+#include <type_traits>
+#include <vector>
 
 #include "../typesystem/struct.h"
 #include "../bricks/template/typelist.h"
+#include "../bricks/util/singleton.h"
 
 namespace current {
 namespace ripcurrent {
 
-using movable_message_t = std::unique_ptr<CurrentSuper, CurrentSuperDeleter>;
+// The deleter of `movable_message_t`. Messages made by `MakeMessage<T>()` are returned to the pool of their type,
+// and the ones wrapped from a raw pointer are `delete`-d, as with `CurrentSuperDeleter`.
+struct MessageDeleter {
+  void (*release)(CurrentSuper*) = nullptr;
+  MessageDeleter() = default;
+  explicit MessageDeleter(void (*release)(CurrentSuper*)) : release(release) {}
+  void operator()(CurrentSuper* ptr) const {
+    if (release) {
+      release(ptr);
+    } else {
+      delete ptr;
+    }
+  }
+};
+
+using movable_message_t = std::unique_ptr<CurrentSuper, MessageDeleter>;
+
+// Per-type pools of message slots. The flows pass around lots of small messages of just a few types, each of which
+// is allocated on the thread that emits it and freed on the thread of the block that consumes it.
+// Each thread keeps a cache of free slots, and exchanges them with the shared pool in batches, so that a message
+// costs neither a `malloc()` nor a lock most of the time. The slots are never returned to the system.
+template <typename T>
+class MessagePool final {
+ public:
+  enum { kBatchSize = 64, kMaxCachedSlots = 4 * kBatchSize };
+
+  template <typename... ARGS>
+  static movable_message_t Make(ARGS&&... args) {
+    void* slot = ThreadLocalSingleton<ThreadCache>().Allocate();
+    try {
+      return movable_message_t(new (slot) T(std::forward<ARGS>(args)...), MessageDeleter(Release));
+    } catch (...) {
+      ThreadLocalSingleton<ThreadCache>().Free(slot);
+      throw;
+    }
+  }
+
+ private:
+  using slot_t = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+  class SharedPool final {
+   public:
+    void Take(std::vector<void*>& slots) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (free_.empty()) {
+        // Intentionally never freed, see above.
+        slot_t* slab = new slot_t[kBatchSize];
+        for (size_t i = 0; i < kBatchSize; ++i) {
+          slots.push_back(&slab[i]);
+        }
+      } else {
+        const size_t n = std::min(free_.size(), static_cast<size_t>(kBatchSize));
+        slots.insert(slots.end(), free_.end() - n, free_.end());
+        free_.resize(free_.size() - n);
+      }
+    }
+    void Give(std::vector<void*>& slots, size_t n) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      free_.insert(free_.end(), slots.end() - n, slots.end());
+      slots.resize(slots.size() - n);
+    }
+
+   private:
+    std::mutex mutex_;
+    std::vector<void*> free_;
+  };
+
+  // Intentionally never destructed, as messages may outlive the static objects of the program.
+  static SharedPool& Shared() {
+    static SharedPool* pool = new SharedPool();
+    return *pool;
+  }
+
+  class ThreadCache final {
+   public:
+    ThreadCache() { free_.reserve(kMaxCachedSlots + kBatchSize); }
+    ~ThreadCache() { Shared().Give(free_, free_.size()); }
+    void* Allocate() {
+      if (free_.empty()) {
+        Shared().Take(free_);
+      }
+      void* slot = free_.back();
+      free_.pop_back();
+      return slot;
+    }
+    void Free(void* slot) {
+      free_.push_back(slot);
+      if (free_.size() > kMaxCachedSlots) {
+        Shared().Give(free_, kBatchSize);
+      }
+    }
+
+   private:
+    std::vector<void*> free_;
+  };
+
+  static void Release(CurrentSuper* ptr) {
+    T* message = static_cast<T*>(ptr);
+    message->~T();
+    ThreadLocalSingleton<ThreadCache>().Free(message);
+  }
+};
+
+template <typename T, typename... ARGS>
+movable_message_t MakeMessage(ARGS&&... args) {
+  return MessagePool<T>::Make(std::forward<ARGS>(args)...);
+}
 
 #if 0
 
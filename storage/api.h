@@ -35,6 +35,7 @@ SOFTWARE.
 
 #include "rest/types.h"
 #include "rest/plain.h"
+#include "rest/cache.h"
 
 #include "../typesystem/schema/schema.h"
 #include "../blocks/http/api.h"
@@ -114,13 +115,21 @@ struct PerFieldRESTfulHandlerGenerator {
   const registerer_t registerer;
   STORAGE& storage;
   const std::string restful_url_prefix;
+  ResponseCache& response_cache;
 
-  PerFieldRESTfulHandlerGenerator(registerer_t registerer, STORAGE& storage, const std::string& restful_url_prefix)
-      : registerer(registerer), storage(storage), restful_url_prefix(restful_url_prefix) {}
+  PerFieldRESTfulHandlerGenerator(registerer_t registerer,
+                                  STORAGE& storage,
+                                  const std::string& restful_url_prefix,
+                                  ResponseCache& response_cache)
+      : registerer(registerer),
+        storage(storage),
+        restful_url_prefix(restful_url_prefix),
+        response_cache(response_cache) {}
 
   template <typename FIELD_TYPE, typename ENTRY_TYPE_WRAPPER>
   void operator()(const char* input_field_name, FIELD_TYPE, ENTRY_TYPE_WRAPPER) {
     auto& storage = this->storage;  // For lambdas.
+    auto& response_cache = this->response_cache;
     const std::string restful_url_prefix = this->restful_url_prefix;
     const std::string field_name = input_field_name;
 
@@ -134,13 +143,18 @@ struct PerFieldRESTfulHandlerGenerator {
     using PATCHHandler = DataHandlerImpl<PATCH, top_level_operation_t, specific_field_t, entry_t, key_t>;
     using DELETEHandler = DataHandlerImpl<DELETE, top_level_operation_t, specific_field_t, entry_t, key_t>;
 
-    const auto generic_data_handler = [&storage, restful_url_prefix, field_name](Request request) {
+    const auto generic_data_handler = [&storage, &response_cache, restful_url_prefix, field_name](Request request) {
+      const bool is_export = request.url.query.has(kRESTfulExportURLQueryParameter);
+      if (!is_export && response_cache.ServeIfCached(request, storage.LastAppliedTimestamp())) {
+        return;
+      }
       // TODO(dkorolev): Pass `BorrowedWithCallback<Storage>` into the request handler.
       auto generic_input = RESTfulGenericInput<STORAGE>(storage, restful_url_prefix);
       std::lock_guard<std::mutex> lock(storage.UnderlyingStream()->Impl()->publishing_mutex);
       const bool is_master = storage.template IsMasterStorage<current::locks::MutexLockStatus::AlreadyLocked>();
       if (request.method == "GET") {
         GETHandler handler;
+        const std::string cache_key = (!is_export && response_cache.Enabled()) ? ResponseCache::Key(request) : "";
         Optional<FieldExportParams> requested_export_params;
         if (request.url.query.has(kRESTfulExportURLQueryParameter)) {
           FieldExportParams params;
@@ -154,15 +168,22 @@ struct PerFieldRESTfulHandlerGenerator {
         handler.Enter(
             std::move(request),
             // Capture by reference since this lambda is run synchronously.
-            [&storage, &handler, &generic_input, &field_name, requested_export_params](
+            [&storage, &response_cache, &handler, &generic_input, &field_name, &cache_key, requested_export_params](
                 Request request,
                 const Optional<typename field_type_dependent_t<specific_field_t>::url_key_t>& url_key) {
               const specific_field_t& field = generic_input.storage(::current::storage::ImmutableFieldByIndex<INDEX>());
               generic_input.storage
                   .template ReadOnlyTransaction<current::locks::MutexLockStatus::AlreadyLocked>(
                        // Capture local variables by value for safe async transactions.
-                       [&storage, handler, generic_input, &field, url_key, field_name, requested_export_params](
-                           immutable_fields_t fields) -> Response {
+                       [&storage,
+                        &response_cache,
+                        handler,
+                        generic_input,
+                        &field,
+                        url_key,
+                        field_name,
+                        cache_key,
+                        requested_export_params](immutable_fields_t fields) -> Response {
                          using GETInput = RESTfulGETInput<STORAGE, specific_field_t>;
                          const GETInput input(
                              std::move(generic_input),
@@ -172,7 +193,14 @@ struct PerFieldRESTfulHandlerGenerator {
                              url_key,
                              storage.template IsMasterStorage<current::locks::MutexLockStatus::AlreadyLocked>(),
                              requested_export_params);
-                         return handler.Run(input);
+                         Response response = handler.Run(input);
+                         if (!cache_key.empty()) {
+                           response_cache.Store(
+                               cache_key,
+                               storage.template LastAppliedTimestamp<current::locks::MutexLockStatus::AlreadyLocked>(),
+                               response);
+                         }
+                         return response;
                        },
                        std::move(request))
                   .Detach();
@@ -322,33 +350,46 @@ struct PerFieldRESTfulHandlerGenerator {
                       std::is_same<PARTIAL_KEY_OPERATION, semantics::rest::operation::OnMatrixCol>::value,
                   "");
     auto& storage = this->storage;
+    auto& response_cache = this->response_cache;
     const std::string restful_url_prefix = this->restful_url_prefix;
 
     using entry_t = typename ENTRY_TYPE_WRAPPER::entry_t;
     using key_t = typename ENTRY_TYPE_WRAPPER::key_t;
 
-    return [&storage, restful_url_prefix, field_name](Request request) {
+    return [&storage, &response_cache, restful_url_prefix, field_name](Request request) {
+      if (response_cache.ServeIfCached(request, storage.LastAppliedTimestamp())) {
+        return;
+      }
       // TODO(dkorolev): Pass `BorrowedWithCallback<Storage>` into the request handler.
       std::lock_guard<std::mutex> lock(storage.UnderlyingStream()->Impl()->publishing_mutex);
       auto generic_input = RESTfulGenericInput<STORAGE>(storage, restful_url_prefix);
       if (request.method == "GET") {
         DataHandlerImpl<GET, PARTIAL_KEY_OPERATION, specific_field_t, entry_t, key_t> handler;
+        const std::string cache_key = response_cache.Enabled() ? ResponseCache::Key(request) : "";
         handler.Enter(
             std::move(request),
             // Capture by reference since this lambda is run synchronously.
-            [&storage, &handler, &generic_input, &field_name](Request request, const Optional<std::string>& url_key) {
+            [&storage, &response_cache, &handler, &generic_input, &field_name, &cache_key](
+                Request request, const Optional<std::string>& url_key) {
               const specific_field_t& field = generic_input.storage(::current::storage::ImmutableFieldByIndex<INDEX>());
               generic_input.storage.template ReadOnlyTransaction<current::locks::MutexLockStatus::AlreadyLocked>(
                                         // Capture local variables by value for safe async transactions.
-                                        [&storage, handler, generic_input, &field, url_key, field_name](
-                                            immutable_fields_t fields) -> Response {
+                                        [&storage, &response_cache, handler, generic_input, &field, url_key,
+                                         field_name, cache_key](immutable_fields_t fields) -> Response {
                                           using RowColGETInput =
                                               RESTfulGETRowColInput<STORAGE,
                                                                     typename PARTIAL_KEY_OPERATION::key_completeness_t,
                                                                     specific_field_t>;
                                           const RowColGETInput input(
                                               std::move(generic_input), fields, field, field_name, url_key);
-                                          return handler.Run(input);
+                                          Response response = handler.Run(input);
+                                          if (!cache_key.empty()) {
+                                            response_cache.Store(cache_key,
+                                                                 storage.template LastAppliedTimestamp<
+                                                                     current::locks::MutexLockStatus::AlreadyLocked>(),
+                                                                 response);
+                                          }
+                                          return response;
                                         },
                                         std::move(request)).Detach();
             });
@@ -390,9 +431,13 @@ struct PerFieldRESTfulHandlerGenerator {
 };
 
 template <class REST_IMPL, int INDEX, typename STORAGE>
-void GenerateRESTfulHandler(registerer_t registerer, STORAGE& storage, const std::string& restful_url_prefix) {
-  storage(::current::storage::FieldNameAndTypeByIndex<INDEX>(),
-          PerFieldRESTfulHandlerGenerator<REST_IMPL, INDEX, STORAGE>(registerer, storage, restful_url_prefix));
+void GenerateRESTfulHandler(registerer_t registerer,
+                            STORAGE& storage,
+                            const std::string& restful_url_prefix,
+                            ResponseCache& response_cache) {
+  storage(
+      ::current::storage::FieldNameAndTypeByIndex<INDEX>(),
+      PerFieldRESTfulHandlerGenerator<REST_IMPL, INDEX, STORAGE>(registerer, storage, restful_url_prefix, response_cache));
 }
 
 }  // namespace current::storage::rest::impl
@@ -422,7 +467,8 @@ class RESTfulStorage {
     }
 
     // Fill in the map of `Storage field name` -> `HTTP handler`.
-    ForEachFieldByIndex<void, STORAGE_IMPL::FIELDS_COUNT>::RegisterIt(storage, restful_url_prefix, data_->handlers_);
+    ForEachFieldByIndex<void, STORAGE_IMPL::FIELDS_COUNT>::RegisterIt(
+        storage, restful_url_prefix, data_->handlers_, data_->response_cache_);
 
     // Register the CQS handlers as well.
     RegisterCQSHandlers(storage, restful_url_prefix);
@@ -511,6 +557,12 @@ class RESTfulStorage {
         });
   }
 
+  // Opt-in caching of the responses to `GET`-s and CQS queries, until the next transaction is applied to the storage.
+  // Only use it if the CQS queries are pure functions of the storage contents and of the URL of the request.
+  void EnableResponseCache(size_t max_entries = 1000u) { data_->response_cache_.Enable(max_entries); }
+  void DisableResponseCache() { data_->response_cache_.Enable(0u); }
+  ResponseCacheStats GetResponseCacheStats() const { return data_->response_cache_.Stats(); }
+
   // Support for graceful shutdown. Alpha.
   void SwitchHTTPEndpointsTo503s() {
     data_->up_status_ = false;
@@ -535,6 +587,8 @@ class RESTfulStorage {
     std::unordered_map<std::string, std::pair<cqs_universal_parser_t, cqs_query_handler_t>> cqs_query_map_;
     std::unordered_map<std::string, std::pair<cqs_universal_parser_t, cqs_command_handler_t>> cqs_command_map_;
 
+    ResponseCache response_cache_;
+
     Data(uint16_t port, const std::string& route_prefix) : port_(port), route_prefix_(route_prefix), up_status_(true) {}
   };
   std::unique_ptr<Data> data_;
@@ -544,21 +598,23 @@ class RESTfulStorage {
   struct ForEachFieldByIndex {
     static void RegisterIt(STORAGE_IMPL& storage,
                            const std::string& restful_url_prefix,
-                           impl::storage_handlers_map_t& handlers) {
-      ForEachFieldByIndex<BLAH, I - 1>::RegisterIt(storage, restful_url_prefix, handlers);
+                           impl::storage_handlers_map_t& handlers,
+                           ResponseCache& response_cache) {
+      ForEachFieldByIndex<BLAH, I - 1>::RegisterIt(storage, restful_url_prefix, handlers, response_cache);
       using specific_entry_type_t =
           typename impl::PerFieldRESTfulHandlerGenerator<REST_IMPL, I - 1, STORAGE_IMPL>::specific_entry_type_t;
       current::metaprogramming::CallIf<FieldExposedViaREST<STORAGE_IMPL, specific_entry_type_t>::exposed>::With([&] {
         const auto registerer =
             [&handlers](const impl::storage_handlers_map_entry_t& restful_route) { handlers.insert(restful_route); };
-        impl::GenerateRESTfulHandler<REST_IMPL, I - 1, STORAGE_IMPL>(registerer, storage, restful_url_prefix);
+        impl::GenerateRESTfulHandler<REST_IMPL, I - 1, STORAGE_IMPL>(
+            registerer, storage, restful_url_prefix, response_cache);
       });
     }
   };
 
   template <typename BLAH>
   struct ForEachFieldByIndex<BLAH, 0> {
-    static void RegisterIt(STORAGE_IMPL&, const std::string&, impl::storage_handlers_map_t&) {}
+    static void RegisterIt(STORAGE_IMPL&, const std::string&, impl::storage_handlers_map_t&, ResponseCache&) {}
   };
 
   void RegisterRoute(const std::string& field_name, const RESTfulRoute& route) {
@@ -590,8 +646,12 @@ class RESTfulStorage {
   }
   void RegisterCQSHandlers(STORAGE_IMPL& storage, const std::string& restful_url_prefix) {
     const Data& data = *data_;
+    ResponseCache& response_cache = data_->response_cache_;
 
-    const auto cqs_query_handler = [&data, &storage, restful_url_prefix](Request request) {
+    const auto cqs_query_handler = [&data, &storage, &response_cache, restful_url_prefix](Request request) {
+      if (response_cache.ServeIfCached(request, storage.LastAppliedTimestamp())) {
+        return;
+      }
       std::lock_guard<std::mutex> lock(storage.UnderlyingStream()->Impl()->publishing_mutex);
       if (request.url_path_args.empty()) {
         request(Response(cqs::CQSHandlerNotSpecified(), HTTPResponseCode.NotFound));
@@ -609,20 +669,36 @@ class RESTfulStorage {
           std::shared_ptr<CurrentStruct> type_erased_query = f_parse_query_body(request);
           if (type_erased_query) {
             typename CQSHandlerImpl::Context context;
+            const std::string cache_key = response_cache.Enabled() ? ResponseCache::Key(request) : "";
             handler.Enter(
                 std::move(request),
                 context,
                 // Capture by reference since this lambda is run synchronously.
-                [&handler, &f_run_query, &generic_input, &type_erased_query, &context](Request request) {
+                [&handler, &f_run_query, &generic_input, &type_erased_query, &context, &response_cache, &cache_key](
+                    Request request) {
                   const STORAGE_IMPL& storage = generic_input.storage;
                   const cqs::CQSParameters cqs_parameters(generic_input.restful_url_prefix, request);
                   storage.template ReadOnlyTransaction<current::locks::MutexLockStatus::AlreadyLocked>(
                               // TODO(dkorolev): Revisit this as Owned/Borrowed are the organic part of Storage.
                               // Capture local variables by value for safe async transactions.
-                              [&storage, &f_run_query, handler, cqs_parameters, type_erased_query, context](
-                                  immutable_fields_t fields) -> Response {
-                                return handler.RunQuery(
+                              [&storage,
+                               &f_run_query,
+                               &response_cache,
+                               handler,
+                               cqs_parameters,
+                               type_erased_query,
+                               context,
+                               cache_key](immutable_fields_t fields) -> Response {
+                                Response response = handler.RunQuery(
                                     context, f_run_query, fields, std::move(type_erased_query), cqs_parameters);
+                                if (!cache_key.empty()) {
+                                  response_cache.Store(
+                                      cache_key,
+                                      storage.template LastAppliedTimestamp<
+                                          current::locks::MutexLockStatus::AlreadyLocked>(),
+                                      response);
+                                }
+                                return response;
                               },
                               std::move(request)).Detach();
                 });
@@ -624,6 +624,7 @@ struct GenericMatrixIteratorImplSelector<PARTIAL_KEY_TYPE, semantics::matrix_dim
   struct SingleElementOuterAccessor {
     using outer_accessor_t = typename MatrixContainerProxy<PARTIAL_KEY_TYPE>::template outer_accessor_t<FIELD>;
     using outer_iterator_t = typename outer_accessor_t::const_iterator;
+    using key_t = OUTER_KEY;
     outer_accessor_t accessor;
     SingleElementOuterAccessor(outer_accessor_t accessor) : accessor(accessor) {}
     bool Empty() const { return accessor.Empty(); }
@@ -647,6 +648,17 @@ struct GenericMatrixIteratorImplSelector<PARTIAL_KEY_TYPE, semantics::matrix_dim
     };
     SingleElementOuterIterator begin() const { return SingleElementOuterIterator(accessor.begin()); }
     SingleElementOuterIterator end() const { return SingleElementOuterIterator(accessor.end()); }
+    // Available if the underlying accessor is ordered.
+    template <typename A = outer_accessor_t>
+    auto LowerBound(const OUTER_KEY& x) const
+        -> decltype(SingleElementOuterIterator(std::declval<const A&>().LowerBound(x))) {
+      return SingleElementOuterIterator(accessor.LowerBound(x));
+    }
+    template <typename A = outer_accessor_t>
+    auto UpperBound(const OUTER_KEY& x) const
+        -> decltype(SingleElementOuterIterator(std::declval<const A&>().UpperBound(x))) {
+      return SingleElementOuterIterator(accessor.UpperBound(x));
+    }
   };
 
   struct Impl {
@@ -25,6 +25,8 @@ SOFTWARE.
 #ifndef CURRENT_STORAGE_CONTAINER_COMMON_H
 #define CURRENT_STORAGE_CONTAINER_COMMON_H
 
+#include "compact.h"
+
 #include "../../bricks/util/comparators.h"
 
 namespace current {
@@ -37,6 +39,10 @@ using Unordered = std::unordered_map<KEY, VALUE, GenericHashFunction<KEY>>;
 template <typename KEY, typename VALUE>
 using Ordered = std::map<KEY, VALUE, CurrentComparator<KEY>>;
 
+// Ordered, contiguous, read-optimized. See `compact.h`.
+template <typename KEY, typename VALUE>
+using Compact = CompactMap<KEY, VALUE, CurrentComparator<KEY>>;
+
 }  // namespace container
 }  // namespace storage
 }  // namespace current
@@ -0,0 +1,235 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2016 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// `CompactMap<KEY, VALUE>` is a read-optimized, `std::map`-compatible associative container for the rows and columns
+// of the matrix-like storage fields (`(One/Many)ToMany`).
+//
+// The elements are kept in one contiguous array, sorted by key, so that row and column scans are sequential reads,
+// and no per-element heap node is allocated. New keys are first appended to a small delta buffer, and erased keys
+// are marked as tombstones. Both are applied to the sorted array in one bulk merge, either once they outgrow their
+// capacity, or before the first read that follows a write. Thus, replaying a stream, importing a batch, or deleting
+// in bulk costs amortized O(sqrt(N)) per insert or erase, not O(N).
+//
+// All reads are `const`, yet may merge the delta buffer. This is safe since Current storage serializes all access,
+// read-only transactions included, via its publishing mutex.
+
+#ifndef CURRENT_STORAGE_CONTAINER_COMPACT_H
+#define CURRENT_STORAGE_CONTAINER_COMPACT_H
+
+#include "../../port.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace current {
+namespace storage {
+namespace container {
+
+template <typename KEY, typename VALUE, typename LESS = std::less<KEY>>
+class CompactMap final {
+ public:
+  using key_type = KEY;
+  using mapped_type = VALUE;
+  using value_type = std::pair<KEY, VALUE>;
+  using key_compare = LESS;
+  using size_type = size_t;
+  using container_t = std::vector<value_type>;
+  using const_iterator = typename container_t::const_iterator;
+  using const_reverse_iterator = typename container_t::const_reverse_iterator;
+  using iterator = const_iterator;
+
+  bool empty() const { return size() == 0u; }
+  size_t size() const { return sorted_.size() - erased_.size() + delta_.size(); }
+
+  VALUE& operator[](const KEY& key) {
+    const auto it = LowerBoundInSorted(key);
+    if (it != sorted_.end() && !less_(key, it->first)) {
+      const auto tombstone = std::find(erased_.begin(), erased_.end(), static_cast<size_t>(it - sorted_.begin()));
+      if (tombstone != erased_.end()) {
+        // Revive the erased element, as if it was inserted anew.
+        *tombstone = erased_.back();
+        erased_.pop_back();
+        it->second = VALUE();
+      }
+      return it->second;
+    }
+    for (auto& e : delta_) {
+      if (!less_(e.first, key) && !less_(key, e.first)) {
+        return e.second;
+      }
+    }
+    delta_.emplace_back(key, VALUE());
+    if (delta_.size() + erased_.size() <= DeltaCapacity()) {
+      return delta_.back().second;
+    } else {
+      MergeDelta();
+      return LowerBoundInSorted(key)->second;
+    }
+  }
+
+  size_t erase(const KEY& key) {
+    const auto it = LowerBoundInSorted(key);
+    if (it != sorted_.end() && !less_(key, it->first)) {
+      const size_t index = it - sorted_.begin();
+      if (std::find(erased_.begin(), erased_.end(), index) != erased_.end()) {
+        return 0u;
+      }
+      erased_.push_back(index);
+      if (delta_.size() + erased_.size() > DeltaCapacity()) {
+        MergeDelta();
+      }
+      return 1u;
+    }
+    for (auto& e : delta_) {
+      if (!less_(e.first, key) && !less_(key, e.first)) {
+        if (&e != &delta_.back()) {
+          e = std::move(delta_.back());
+        }
+        delta_.pop_back();
+        return 1u;
+      }
+    }
+    return 0u;
+  }
+
+  void clear() {
+    sorted_.clear();
+    delta_.clear();
+    erased_.clear();
+  }
+
+  const_iterator find(const KEY& key) const {
+    MergeDelta();
+    const auto it = lower_bound(key);
+    return (it != sorted_.end() && !less_(key, it->first)) ? it : sorted_.end();
+  }
+
+  size_t count(const KEY& key) const { return find(key) != end() ? 1u : 0u; }
+
+  const_iterator lower_bound(const KEY& key) const {
+    MergeDelta();
+    return std::lower_bound(
+        sorted_.begin(), sorted_.end(), key, [this](const value_type& lhs, const KEY& rhs) {
+          return less_(lhs.first, rhs);
+        });
+  }
+
+  const_iterator upper_bound(const KEY& key) const {
+    MergeDelta();
+    return std::upper_bound(
+        sorted_.begin(), sorted_.end(), key, [this](const KEY& lhs, const value_type& rhs) {
+          return less_(lhs, rhs.first);
+        });
+  }
+
+  const_iterator begin() const {
+    MergeDelta();
+    return sorted_.begin();
+  }
+  const_iterator end() const {
+    MergeDelta();
+    return sorted_.end();
+  }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  const_reverse_iterator rbegin() const {
+    MergeDelta();
+    return sorted_.rbegin();
+  }
+  const_reverse_iterator rend() const {
+    MergeDelta();
+    return sorted_.rend();
+  }
+  const_reverse_iterator crbegin() const { return rbegin(); }
+  const_reverse_iterator crend() const { return rend(); }
+
+  // Releases the slack of the underlying arrays, for the fields that are done with bulk loading.
+  void shrink_to_fit() {
+    MergeDelta();
+    sorted_.shrink_to_fit();
+    delta_.shrink_to_fit();
+    erased_.shrink_to_fit();
+  }
+
+ private:
+  typename container_t::iterator LowerBoundInSorted(const KEY& key) {
+    return std::lower_bound(
+        sorted_.begin(), sorted_.end(), key, [this](const value_type& lhs, const KEY& rhs) {
+          return less_(lhs.first, rhs);
+        });
+  }
+
+  // The delta buffer and the tombstones grow as the square root of the sorted array, to keep both the linear scans
+  // over them and the amortized cost of the merge at O(sqrt(N)) per inserted or erased element.
+  size_t DeltaCapacity() const {
+    return std::max(static_cast<size_t>(16u), static_cast<size_t>(std::sqrt(static_cast<double>(sorted_.size()))));
+  }
+
+  void MergeDelta() const {
+    if (!erased_.empty()) {
+      // Drop the tombstoned elements in one pass.
+      std::sort(erased_.begin(), erased_.end());
+      auto tombstone = erased_.begin();
+      size_t kept = 0u;
+      for (size_t i = 0u; i < sorted_.size(); ++i) {
+        if (tombstone != erased_.end() && *tombstone == i) {
+          ++tombstone;
+        } else {
+          if (kept != i) {
+            sorted_[kept] = std::move(sorted_[i]);
+          }
+          ++kept;
+        }
+      }
+      sorted_.erase(sorted_.begin() + kept, sorted_.end());
+      erased_.clear();
+    }
+    if (!delta_.empty()) {
+      const auto comparator = [this](const value_type& lhs, const value_type& rhs) {
+        return less_(lhs.first, rhs.first);
+      };
+      std::sort(delta_.begin(), delta_.end(), comparator);
+      const size_t middle = sorted_.size();
+      std::move(delta_.begin(), delta_.end(), std::back_inserter(sorted_));
+      delta_.clear();
+      std::inplace_merge(sorted_.begin(), sorted_.begin() + middle, sorted_.end(), comparator);
+    }
+  }
+
+  LESS less_;
+  mutable container_t sorted_;
+  mutable container_t delta_;
+  mutable std::vector<size_t> erased_;  // Indexes of the erased elements of `sorted_`.
+};
+
+}  // namespace container
+}  // namespace storage
+}  // namespace current
+
+#endif  // CURRENT_STORAGE_CONTAINER_COMPACT_H
@@ -32,6 +32,7 @@ SOFTWARE.
 #include "../base.h"
 
 #include "../../typesystem/optional.h"
+#include "../../bricks/util/iterator.h"  // For `stl_wrappers::sfinae::is_unordered_map`.
 
 namespace current {
 namespace storage {
@@ -209,6 +210,15 @@ class GenericDictionary {
   Iterator begin() const { return Iterator(map_.cbegin()); }
   Iterator end() const { return Iterator(map_.cend()); }
 
+  template <typename U = map_t, class = std::enable_if_t<!stl_wrappers::sfinae::is_unordered_map<U>::value>>
+  Iterator LowerBound(sfinae::CF<key_t> x) const {
+    return Iterator(map_.lower_bound(x));
+  }
+  template <typename U = map_t, class = std::enable_if_t<!stl_wrappers::sfinae::is_unordered_map<U>::value>>
+  Iterator UpperBound(sfinae::CF<key_t> x) const {
+    return Iterator(map_.upper_bound(x));
+  }
+
  private:
   const std::string field_name_;
   map_t map_;
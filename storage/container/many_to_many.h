@@ -160,6 +160,7 @@ class GenericManyToMany {
   struct OuterAccessor final {
     using OUTER_KEY = typename OUTER_MAP::key_type;
     using INNER_MAP = typename OUTER_MAP::mapped_type;
+    using key_t = OUTER_KEY;
     const OUTER_MAP& map_;
 
     struct OuterIterator final {
@@ -194,6 +195,15 @@ class GenericManyToMany {
       }
     }
 
+    template <typename U = OUTER_MAP, class = std::enable_if_t<!stl_wrappers::sfinae::is_unordered_map<U>::value>>
+    OuterIterator LowerBound(const OUTER_KEY& x) const {
+      return OuterIterator(map_.lower_bound(x));
+    }
+    template <typename U = OUTER_MAP, class = std::enable_if_t<!stl_wrappers::sfinae::is_unordered_map<U>::value>>
+    OuterIterator UpperBound(const OUTER_KEY& x) const {
+      return OuterIterator(map_.upper_bound(x));
+    }
+
     OuterIterator begin() const { return OuterIterator(map_.cbegin()); }
     OuterIterator end() const { return OuterIterator(map_.cend()); }
   };
@@ -292,6 +302,14 @@ using OrderedManyToUnorderedMany = GenericManyToMany<T,
                                                      Ordered,
                                                      Unordered>;
 
+template <typename T, typename UPDATE_EVENT, typename DELETE_EVENT, typename PATCH_EVENT_OR_VOID>
+using CompactManyToCompactMany = GenericManyToMany<T,
+                                                   UPDATE_EVENT,
+                                                   DELETE_EVENT,
+                                                   PATCH_EVENT_OR_VOID,
+                                                   Compact,
+                                                   Compact>;
+
 #else
 
 template <typename T, typename UPDATE_EVENT, typename DELETE_EVENT>
@@ -306,6 +324,9 @@ using UnorderedManyToOrderedMany = GenericManyToMany<T, UPDATE_EVENT, DELETE_EVE
 template <typename T, typename UPDATE_EVENT, typename DELETE_EVENT>
 using OrderedManyToUnorderedMany = GenericManyToMany<T, UPDATE_EVENT, DELETE_EVENT, Ordered, Unordered>;
 
+template <typename T, typename UPDATE_EVENT, typename DELETE_EVENT>
+using CompactManyToCompactMany = GenericManyToMany<T, UPDATE_EVENT, DELETE_EVENT, Compact, Compact>;
+
 #endif  // CURRENT_STORAGE_PATCH_SUPPORT
 
 }  // namespace container
@@ -332,6 +353,11 @@ struct StorageFieldTypeSelector<container::OrderedManyToUnorderedMany<T, E1, E2,
   static const char* HumanReadableName() { return "OrderedManyToUnorderedMany"; }
 };
 
+template <typename T, typename E1, typename E2, typename E3>  // Entry, update event, delete event, patch event or void.
+struct StorageFieldTypeSelector<container::CompactManyToCompactMany<T, E1, E2, E3>> {
+  static const char* HumanReadableName() { return "CompactManyToCompactMany"; }
+};
+
 #else
 
 template <typename T, typename E1, typename E2>  // Entry, update event, delete event.
@@ -354,6 +380,11 @@ struct StorageFieldTypeSelector<container::OrderedManyToUnorderedMany<T, E1, E2>
   static const char* HumanReadableName() { return "OrderedManyToUnorderedMany"; }
 };
 
+template <typename T, typename E1, typename E2>  // Entry, update event, delete event.
+struct StorageFieldTypeSelector<container::CompactManyToCompactMany<T, E1, E2>> {
+  static const char* HumanReadableName() { return "CompactManyToCompactMany"; }
+};
+
 #endif  // CURRENT_STORAGE_PATCH_SUPPORT
 
 }  // namespace storage
@@ -363,5 +394,6 @@ using current::storage::container::UnorderedManyToUnorderedMany;
 using current::storage::container::OrderedManyToOrderedMany;
 using current::storage::container::UnorderedManyToOrderedMany;
 using current::storage::container::OrderedManyToUnorderedMany;
+using current::storage::container::CompactManyToCompactMany;
 
 #endif  // CURRENT_STORAGE_CONTAINER_MANY_TO_MANY_H
@@ -242,6 +242,15 @@ class GenericOneToMany {
       }
     }
 
+    template <typename U = ROWS_MAP, class = std::enable_if_t<!stl_wrappers::sfinae::is_unordered_map<U>::value>>
+    RowsIterator LowerBound(const key_t& x) const {
+      return RowsIterator(map_.lower_bound(x));
+    }
+    template <typename U = ROWS_MAP, class = std::enable_if_t<!stl_wrappers::sfinae::is_unordered_map<U>::value>>
+    RowsIterator UpperBound(const key_t& x) const {
+      return RowsIterator(map_.upper_bound(x));
+    }
+
     RowsIterator begin() const { return RowsIterator(map_.cbegin()); }
     RowsIterator end() const { return RowsIterator(map_.cend()); }
   };
@@ -330,6 +339,14 @@ using OrderedOneToUnorderedMany = GenericOneToMany<T,
                                                    Ordered,
                                                    Unordered>;
 
+template <typename T, typename UPDATE_EVENT, typename DELETE_EVENT, typename PATCH_EVENT_OR_VOID>
+using CompactOneToCompactMany = GenericOneToMany<T,
+                                                 UPDATE_EVENT,
+                                                 DELETE_EVENT,
+                                                 PATCH_EVENT_OR_VOID,
+                                                 Compact,
+                                                 Compact>;
+
 #else
 
 template <typename T, typename UPDATE_EVENT, typename DELETE_EVENT>
@@ -344,6 +361,9 @@ using UnorderedOneToOrderedMany = GenericOneToMany<T, UPDATE_EVENT, DELETE_EVENT
 template <typename T, typename UPDATE_EVENT, typename DELETE_EVENT>
 using OrderedOneToUnorderedMany = GenericOneToMany<T, UPDATE_EVENT, DELETE_EVENT, Ordered, Unordered>;
 
+template <typename T, typename UPDATE_EVENT, typename DELETE_EVENT>
+using CompactOneToCompactMany = GenericOneToMany<T, UPDATE_EVENT, DELETE_EVENT, Compact, Compact>;
+
 #endif  // CURRENT_STORAGE_PATCH_SUPPORT
 
 }  // namespace container
@@ -370,6 +390,11 @@ struct StorageFieldTypeSelector<container::OrderedOneToUnorderedMany<T, E1, E2,
   static const char* HumanReadableName() { return "OrderedOneToUnorderedMany"; }
 };
 
+template <typename T, typename E1, typename E2, typename E3>  // Entry, update event, delete event, patch event or void.
+struct StorageFieldTypeSelector<container::CompactOneToCompactMany<T, E1, E2, E3>> {
+  static const char* HumanReadableName() { return "CompactOneToCompactMany"; }
+};
+
 #else
 
 template <typename T, typename E1, typename E2>  // Entry, update event, delete event.
@@ -392,6 +417,11 @@ struct StorageFieldTypeSelector<container::OrderedOneToUnorderedMany<T, E1, E2>>
   static const char* HumanReadableName() { return "OrderedOneToUnorderedMany"; }
 };
 
+template <typename T, typename E1, typename E2>  // Entry, update event, delete event.
+struct StorageFieldTypeSelector<container::CompactOneToCompactMany<T, E1, E2>> {
+  static const char* HumanReadableName() { return "CompactOneToCompactMany"; }
+};
+
 #endif  // CURRENT_STORAGE_PATCH_SUPPORT
 
 }  // namespace storage
@@ -401,5 +431,6 @@ using current::storage::container::UnorderedOneToUnorderedMany;
 using current::storage::container::OrderedOneToOrderedMany;
 using current::storage::container::UnorderedOneToOrderedMany;
 using current::storage::container::OrderedOneToUnorderedMany;
+using current::storage::container::CompactOneToCompactMany;
 
 #endif  // CURRENT_STORAGE_CONTAINER_ONE_TO_MANY_H
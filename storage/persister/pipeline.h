@@ -0,0 +1,216 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2016 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// `ReplayPipeline<DECODED>` is the two-stage pipeline used by following storages to import the transactions
+// replicated from the master.
+//
+// Raw log lines are `Push()`-ed in stream order. They are decoded concurrently by a pool of worker threads,
+// and then handed over to the single applier thread strictly in the order they were pushed. The applier
+// takes all the consecutive decoded entries available at once, so that the caller can apply the whole batch
+// under one acquisition of the storage-wide mutex.
+//
+// The number of entries in flight is bounded, `Push()` blocks when the pipeline is full.
+//
+// If decoding or applying an entry throws, the pipeline stops, and the exception is rethrown from the next call
+// to `Push()` or `Flush()`, on the thread feeding the pipeline, same as with the serial replay.
+
+#ifndef CURRENT_STORAGE_PERSISTER_PIPELINE_H
+#define CURRENT_STORAGE_PERSISTER_PIPELINE_H
+
+#include "../../port.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace current {
+namespace storage {
+namespace persister {
+
+template <typename DECODED>
+class ReplayPipeline final {
+ public:
+  using decode_function_t = std::function<DECODED(const std::string&)>;  // Called from the worker threads.
+  using apply_function_t = std::function<void(std::vector<DECODED>&)>;   // Called from the applier thread.
+
+  ReplayPipeline(size_t decoding_threads, size_t max_in_flight, decode_function_t decode_f, apply_function_t apply_f)
+      : max_in_flight_(max_in_flight), decode_f_(decode_f), apply_f_(apply_f) {
+    CURRENT_ASSERT(decoding_threads > 0u);
+    CURRENT_ASSERT(max_in_flight_ > 0u);
+    for (size_t i = 0; i < decoding_threads; ++i) {
+      decoding_threads_.emplace_back(&ReplayPipeline::DecodingThread, this);
+    }
+    applier_thread_ = std::thread(&ReplayPipeline::ApplierThread, this);
+  }
+
+  // Stops the pipeline. The entries not yet applied are discarded.
+  ~ReplayPipeline() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      destructing_ = true;
+    }
+    decode_cv_.notify_all();
+    apply_cv_.notify_all();
+    progress_cv_.notify_all();
+    for (auto& thread : decoding_threads_) {
+      thread.join();
+    }
+    applier_thread_.join();
+  }
+
+  void Push(const std::string& raw_log_line) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    progress_cv_.wait(lock, [this]() { return destructing_ || error_ || slots_.size() < max_in_flight_; });
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    if (!destructing_) {
+      slots_.emplace_back(raw_log_line);
+      decode_cv_.notify_one();
+    }
+  }
+
+  // Blocks until every entry pushed so far has been applied.
+  void Flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    progress_cv_.wait(lock, [this]() { return destructing_ || error_ || (slots_.empty() && !applying_); });
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+ private:
+  struct Slot {
+    std::string raw;
+    bool decoded = false;
+    DECODED value;
+    explicit Slot(const std::string& raw) : raw(raw) {}
+  };
+
+  void DecodingThread() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      decode_cv_.wait(
+          lock, [this]() { return destructing_ || error_ || next_to_decode_ < first_slot_ + slots_.size(); });
+      if (destructing_ || error_) {
+        return;
+      }
+      // Slots are only removed from the front once decoded, so the index of the taken one remains valid.
+      const uint64_t index = next_to_decode_++;
+      std::string raw = std::move(slots_[index - first_slot_].raw);
+      lock.unlock();
+      DECODED value;
+      std::exception_ptr error;
+      try {
+        value = decode_f_(raw);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      lock.lock();
+      if (error) {
+        StopWithErrorFromLockedSection(error);
+        return;
+      }
+      Slot& slot = slots_[index - first_slot_];
+      slot.value = std::move(value);
+      slot.decoded = true;
+      if (index == first_slot_) {
+        apply_cv_.notify_one();
+      }
+    }
+  }
+
+  void ApplierThread() {
+    std::vector<DECODED> batch;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      apply_cv_.wait(lock,
+                     [this]() { return destructing_ || error_ || (!slots_.empty() && slots_.front().decoded); });
+      if (destructing_ || error_) {
+        return;
+      }
+      batch.clear();
+      while (!slots_.empty() && slots_.front().decoded) {
+        batch.push_back(std::move(slots_.front().value));
+        slots_.pop_front();
+        ++first_slot_;
+      }
+      applying_ = true;
+      lock.unlock();
+      progress_cv_.notify_all();
+      std::exception_ptr error;
+      try {
+        apply_f_(batch);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      lock.lock();
+      applying_ = false;
+      if (error) {
+        StopWithErrorFromLockedSection(error);
+        return;
+      }
+      progress_cv_.notify_all();
+    }
+  }
+
+  // Keeps the first error only, the entries after the failed one are not applied anyway.
+  void StopWithErrorFromLockedSection(std::exception_ptr error) {
+    if (!error_) {
+      error_ = error;
+    }
+    decode_cv_.notify_all();
+    apply_cv_.notify_all();
+    progress_cv_.notify_all();
+  }
+
+  const size_t max_in_flight_;
+  const decode_function_t decode_f_;
+  const apply_function_t apply_f_;
+
+  std::mutex mutex_;
+  std::condition_variable decode_cv_;    // Signaled when there is a new entry to decode.
+  std::condition_variable apply_cv_;     // Signaled when the front entry has been decoded.
+  std::condition_variable progress_cv_;  // Signaled when entries leave the pipeline, for `Push()` and `Flush()`.
+  std::deque<Slot> slots_;
+  uint64_t first_slot_ = 0u;      // The sequential number of `slots_.front()`.
+  uint64_t next_to_decode_ = 0u;  // The sequential number of the next slot to be picked up by a decoding thread.
+  bool applying_ = false;
+  bool destructing_ = false;
+  std::exception_ptr error_;  // Set once decoding or applying an entry has failed, stops the pipeline.
+
+  std::vector<std::thread> decoding_threads_;
+  std::thread applier_thread_;
+};
+
+}  // namespace persister
+}  // namespace storage
+}  // namespace current
+
+#endif  // CURRENT_STORAGE_PERSISTER_PIPELINE_H
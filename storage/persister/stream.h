@@ -27,6 +27,7 @@ SOFTWARE.
 #define CURRENT_STORAGE_PERSISTER_STREAM_H
 
 #include "common.h"
+#include "pipeline.h"
 #include "../base.h"
 #include "../exceptions.h"
 #include "../transaction.h"
@@ -38,7 +39,15 @@ namespace current {
 namespace storage {
 namespace persister {
 
-template <typename MUTATIONS_VARIANT, template <typename> class UNDERLYING_PERSISTER, typename STREAM_RECORD_TYPE>
+constexpr static size_t kMaxReplayEntriesInFlight = 1024u;
+
+// With non-zero `REPLAY_DECODING_THREADS`, the following storage does not parse the replicated transactions on its
+// stream subscriber thread. Instead, raw log lines are decoded concurrently, and applied in order, in batches,
+// each batch under a single acquisition of the publishing mutex. See `pipeline.h`.
+template <typename MUTATIONS_VARIANT,
+          template <typename> class UNDERLYING_PERSISTER,
+          typename STREAM_RECORD_TYPE,
+          size_t REPLAY_DECODING_THREADS = 0u>
 class StreamStreamPersisterImpl final {
  public:
   using variant_t = MUTATIONS_VARIANT;
@@ -71,6 +80,31 @@ class StreamStreamPersisterImpl final {
   };
   using StreamSubscriber = current::ss::StreamSubscriber<StreamSubscriberImpl, transaction_t>;
 
+  struct DecodedStreamRecord {
+    idxts_t idx_ts;
+    stream_entry_t entry;
+  };
+  using replay_pipeline_t = ReplayPipeline<DecodedStreamRecord>;
+
+  struct StreamRawSubscriberImpl {
+    using EntryResponse = current::ss::EntryResponse;
+    using TerminationResponse = current::ss::TerminationResponse;
+    replay_pipeline_t* pipeline_;
+
+    StreamRawSubscriberImpl(replay_pipeline_t* pipeline) : pipeline_(pipeline) {}
+
+    EntryResponse operator()(const std::string& raw_log_line, uint64_t, idxts_t) {
+      pipeline_->Push(raw_log_line);
+      return EntryResponse::More;
+    }
+
+    EntryResponse operator()(std::chrono::microseconds) const { return EntryResponse::More; }
+
+    EntryResponse EntryResponseIfNoMorePassTypeFilter() const { return EntryResponse::More; }
+    TerminationResponse Terminate() const { return TerminationResponse::Terminate; }
+  };
+  using StreamRawSubscriber = current::ss::StreamSubscriber<StreamRawSubscriberImpl, stream_entry_t>;
+
   struct Master {};
   struct Following {};
 
@@ -85,7 +119,7 @@ class StreamStreamPersisterImpl final {
           ApplyMutationsFromLockedSectionOrConstructor(transaction, timestamp);
         });
     std::lock_guard<std::mutex> lock(stream_publishing_mutex_ref_);
-    SyncReplayStreamFromLockedSectionOrConstructor(0u);
+    SyncReplayStreamFromLockedSectionOrConstructor(subscriber_instance_->next_replay_index_);
   }
 
   StreamStreamPersisterImpl(Following, fields_update_function_t f, Borrowed<stream_t> stream)
@@ -97,6 +131,9 @@ class StreamStreamPersisterImpl final {
           std::lock_guard<std::mutex> lock(stream_publishing_mutex_ref_);
           ApplyMutationsFromLockedSectionOrConstructor(transaction, timestamp);
         });
+    if (REPLAY_DECODING_THREADS) {
+      CreateReplayPipelineFromLockedSectionOrConstructor();
+    }
     std::lock_guard<std::mutex> lock(stream_publishing_mutex_ref_);
     SubscribeToStreamFromLockedSection();
   }
@@ -104,6 +141,7 @@ class StreamStreamPersisterImpl final {
   ~StreamStreamPersisterImpl() {
     std::lock_guard<std::mutex> master_follower_change_lock(master_follower_change_mutex_);
     TerminateStreamSubscriptionFromLockedSection();
+    replay_pipeline_ = nullptr;
   }
 
   template <current::locks::MutexLockStatus MLS>
@@ -164,12 +202,29 @@ class StreamStreamPersisterImpl final {
       CURRENT_THROW(StorageIsAlreadyMasterException());
     } else {
       TerminateStreamSubscriptionFromLockedSection();
-      std::lock_guard<std::mutex> lock(stream_publishing_mutex_ref_);
-      publisher_used_ = nullptr;
-      publisher_used_ = stream_->template BecomeFollowingStream<current::locks::MutexLockStatus::AlreadyLocked>();
-      const uint64_t save_replay_index = subscriber_instance_->next_replay_index_;
+      try {
+        if (replay_pipeline_) {
+          // Apply what has already been received from the stream before taking over as the master.
+          replay_pipeline_->Flush();
+        }
+        std::lock_guard<std::mutex> lock(stream_publishing_mutex_ref_);
+        auto publisher = stream_->template BecomeFollowingStream<current::locks::MutexLockStatus::AlreadyLocked>();
+        SyncReplayStreamFromLockedSectionOrConstructor(subscriber_instance_->next_replay_index_);
+        publisher_used_ = nullptr;
+        publisher_used_ = std::move(publisher);
+      } catch (...) {
+        // Remain the following storage, resuming from the entry that has failed to be replayed.
+        if (replay_pipeline_) {
+          raw_subscriber_instance_ = nullptr;
+          replay_pipeline_ = nullptr;
+          CreateReplayPipelineFromLockedSectionOrConstructor();
+        }
+        SubscribeToStreamFromLockedSection(subscriber_instance_->next_replay_index_);
+        throw;
+      }
+      replay_pipeline_ = nullptr;
+      raw_subscriber_instance_ = nullptr;
       subscriber_instance_ = nullptr;
-      SyncReplayStreamFromLockedSectionOrConstructor(save_replay_index);
     }
   }
 
@@ -178,14 +233,27 @@ class StreamStreamPersisterImpl final {
  private:
   // Invariant: both `subscriber_creator_destructor_mutex_` and `stream_publishing_mutex_ref_` are locked,
   // or the call is taking place from the constructor.
-  void SyncReplayStreamFromLockedSectionOrConstructor(uint64_t from_idx) {
+  // Advances `next_replay_index` as it goes, for the replay to be resumed should it throw.
+  void SyncReplayStreamFromLockedSectionOrConstructor(uint64_t& next_replay_index) {
     for (const auto& stream_record :
-         stream_->Data()->template Iterate<current::locks::MutexLockStatus::AlreadyLocked>(from_idx)) {
+         stream_->Data()->template Iterate<current::locks::MutexLockStatus::AlreadyLocked>(next_replay_index)) {
       if (Exists<transaction_t>(stream_record.entry)) {
         const transaction_t& transaction = Value<transaction_t>(stream_record.entry);
         ApplyMutationsFromLockedSectionOrConstructor(transaction, stream_record.idx_ts.us);
       }
+      next_replay_index = stream_record.idx_ts.index + 1u;
+    }
+  }
+
+  static DecodedStreamRecord DecodeRawLogLine(const std::string& raw_log_line) {
+    const auto tab_pos = raw_log_line.find('\t');
+    if (tab_pos == std::string::npos) {
+      CURRENT_THROW(current::persistence::MalformedEntryException(raw_log_line));
     }
+    DecodedStreamRecord result;
+    result.idx_ts = ParseJSON<idxts_t>(raw_log_line.substr(0, tab_pos));
+    result.entry = ParseJSON<stream_entry_t>(raw_log_line.substr(tab_pos + 1));
+    return result;
   }
 
   void ApplyMutationsFromLockedSectionOrConstructor(const transaction_t& transaction,
@@ -198,10 +266,32 @@ class StreamStreamPersisterImpl final {
 
  private:
   // Invariant: `master_follower_change_mutex_` is locked, or the call is happening from the constructor.
-  void SubscribeToStreamFromLockedSection() {
+  void CreateReplayPipelineFromLockedSectionOrConstructor() {
+    replay_pipeline_ = std::make_unique<replay_pipeline_t>(
+        REPLAY_DECODING_THREADS,
+        kMaxReplayEntriesInFlight,
+        [](const std::string& raw_log_line) { return DecodeRawLogLine(raw_log_line); },
+        [this](std::vector<DecodedStreamRecord>& batch) {
+          std::lock_guard<std::mutex> lock(stream_publishing_mutex_ref_);
+          for (const auto& record : batch) {
+            if (Exists<transaction_t>(record.entry)) {
+              ApplyMutationsFromLockedSectionOrConstructor(Value<transaction_t>(record.entry), record.idx_ts.us);
+            }
+            subscriber_instance_->next_replay_index_ = record.idx_ts.index + 1u;
+          }
+        });
+    raw_subscriber_instance_ = std::make_unique<StreamRawSubscriber>(replay_pipeline_.get());
+  }
+
+  // Invariant: `master_follower_change_mutex_` is locked, or the call is happening from the constructor.
+  void SubscribeToStreamFromLockedSection(uint64_t begin_idx = 0u) {
     CURRENT_ASSERT(!subscriber_scope_);
     CURRENT_ASSERT(subscriber_instance_);
-    subscriber_scope_ = std::move(stream_->template Subscribe<transaction_t>(*subscriber_instance_));
+    if (raw_subscriber_instance_) {
+      subscriber_scope_ = std::move(stream_->SubscribeUnchecked(*raw_subscriber_instance_, begin_idx));
+    } else {
+      subscriber_scope_ = std::move(stream_->template Subscribe<transaction_t>(*subscriber_instance_, begin_idx));
+    }
   }
 
   // Invariant: `master_follower_change_mutex_` is locked.
@@ -209,7 +299,7 @@ class StreamStreamPersisterImpl final {
   void TerminateStreamSubscriptionFromLockedSection() { subscriber_scope_ = nullptr; }
 
   void SetLastAppliedTimestampFromLockedSection(std::chrono::microseconds timestamp) {
-    CURRENT_ASSERT(timestamp > last_applied_timestamp_);
+    CURRENT_ASSERT(timestamp > last_applied_timestamp_.load());
     last_applied_timestamp_ = timestamp;
   }
 
@@ -222,9 +312,12 @@ class StreamStreamPersisterImpl final {
 
   mutable std::mutex master_follower_change_mutex_;
   std::unique_ptr<StreamSubscriber> subscriber_instance_;
+  std::unique_ptr<replay_pipeline_t> replay_pipeline_;  // Set iff a following storage replays via the pipeline.
+  std::unique_ptr<StreamRawSubscriber> raw_subscriber_instance_;
   current::stream::SubscriberScope subscriber_scope_;
 
-  std::chrono::microseconds last_applied_timestamp_ = std::chrono::microseconds(-1);  // Replayed or from the master.
+  // Replayed or from the master. Atomic, as it is read from outside the locked section to version cached responses.
+  std::atomic<std::chrono::microseconds> last_applied_timestamp_{std::chrono::microseconds(-1)};
 
   HTTPRoutesScope handlers_scope_;
 };
@@ -236,11 +329,20 @@ using StreamInMemoryStreamPersister =
 template <typename TYPELIST, typename STREAM_RECORD_TYPE = NoCustomPersisterParam>
 using StreamStreamPersister = StreamStreamPersisterImpl<TYPELIST, current::persistence::File, STREAM_RECORD_TYPE>;
 
+// Following storages atop this persister decode replicated transactions in parallel. See `pipeline.h`.
+constexpr static size_t kDefaultReplayDecodingThreads = 4u;
+template <typename TYPELIST, typename STREAM_RECORD_TYPE = NoCustomPersisterParam>
+using PipelinedStreamStreamPersister = StreamStreamPersisterImpl<TYPELIST,
+                                                                 current::persistence::File,
+                                                                 STREAM_RECORD_TYPE,
+                                                                 kDefaultReplayDecodingThreads>;
+
 }  // namespace persister
 }  // namespace storage
 }  // namespace current
 
 using current::storage::persister::StreamInMemoryStreamPersister;
 using current::storage::persister::StreamStreamPersister;
+using current::storage::persister::PipelinedStreamStreamPersister;
 
 #endif  // CURRENT_STORAGE_PERSISTER_STREAM_H
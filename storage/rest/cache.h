@@ -0,0 +1,144 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2016 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// `ResponseCache` keeps the responses to RESTful `GET`-s and CQS queries, keyed by their full URL, and versioned by
+// the timestamp of the last transaction applied to the storage. Each transaction, whether committed on the master
+// or replayed by a follower, bumps this timestamp, so a response cached for the current version is exactly the one
+// the handler would produce now. Thus, no explicit invalidation is needed, and cache hits are served without
+// locking the publishing mutex of the storage.
+//
+// Up to `max_entries` responses are kept; the least recently used one is evicted to make room for a new one.
+// The cache is disabled by default. See `RESTfulStorage::EnableResponseCache()`.
+
+#ifndef CURRENT_STORAGE_REST_CACHE_H
+#define CURRENT_STORAGE_REST_CACHE_H
+
+#include "../../port.h"
+
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "../../blocks/http/api.h"
+
+namespace current {
+namespace storage {
+namespace rest {
+
+struct ResponseCacheStats {
+  uint64_t hits = 0u;
+  uint64_t misses = 0u;
+};
+
+class ResponseCache final {
+ public:
+  ResponseCache() : max_entries_(0u) {}
+
+  // Zero `max_entries` disables the cache.
+  void Enable(size_t max_entries) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_entries_ = max_entries;
+    responses_.clear();
+    recently_used_.clear();
+  }
+
+  bool Enabled() const { return max_entries_ > 0u; }
+
+  // The path of `request.url` is trimmed down to the route, the URL path arguments are kept separately.
+  static std::string Key(const Request& request) {
+    return request.url_path_args.ComposeURLPath() + request.url.ComposeParameters();
+  }
+
+  // Responds to the `request` and returns `true` if the response for its URL has been cached at `version`.
+  bool ServeIfCached(Request& request, std::chrono::microseconds version) {
+    if (!Enabled() || request.method != "GET") {
+      return false;
+    }
+    Response response;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      const auto cit = (version == version_) ? responses_.find(Key(request)) : responses_.end();
+      if (cit == responses_.end()) {
+        ++stats_.misses;
+        return false;
+      }
+      ++stats_.hits;
+      recently_used_.splice(recently_used_.begin(), recently_used_, cit->second.second);
+      response = cit->second.first;
+    }
+    request(std::move(response));
+    return true;
+  }
+
+  // Must be called from the locked section, where `version` is exactly the version the `response` was built at.
+  void Store(const std::string& key, std::chrono::microseconds version, const Response& response) {
+    if (!Enabled() || response.code != HTTPResponseCode.OK) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!Enabled()) {
+      return;  // Disabled concurrently.
+    }
+    if (version != version_) {
+      // Versions only grow, and the responses cached at an older one are of no further use.
+      responses_.clear();
+      recently_used_.clear();
+      version_ = version;
+    }
+    const auto it = responses_.find(key);
+    if (it != responses_.end()) {
+      it->second.first = response;
+      recently_used_.splice(recently_used_.begin(), recently_used_, it->second.second);
+      return;
+    }
+    if (responses_.size() >= max_entries_) {
+      responses_.erase(recently_used_.back());
+      recently_used_.pop_back();
+    }
+    recently_used_.push_front(key);
+    responses_.emplace(key, std::make_pair(response, recently_used_.begin()));
+  }
+
+  ResponseCacheStats Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+ private:
+  std::atomic_size_t max_entries_;
+  mutable std::mutex mutex_;
+  std::chrono::microseconds version_ = std::chrono::microseconds(-1);
+  std::list<std::string> recently_used_;  // The keys of `responses_`, the most recently used first.
+  std::unordered_map<std::string, std::pair<Response, std::list<std::string>::iterator>> responses_;
+  ResponseCacheStats stats_;
+};
+
+}  // namespace current::storage::rest
+}  // namespace current::storage
+}  // namespace current
+
+#endif  // CURRENT_STORAGE_REST_CACHE_H
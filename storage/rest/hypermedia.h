@@ -26,6 +26,8 @@ SOFTWARE.
 // Hypermedia: A rather hacky solution for Hypermedia REST API supporting:
 // * Rich JSON format (top-level `url_*` fields, and actual data in `data`.)
 // * Poor man's stateless "pagination" through collections and collection "slices" (rows/cols of matrices).
+//   Either by index, `?i=&n=`, or by an opaque cursor, `?cursor=&n=`, which encodes the key of the last returned element.
+//   Cursors resume in O(log N) on ordered containers, and from the last returned key, not index, on unordered ones.
 // * Full and brief fields sets.
 
 #ifndef CURRENT_STORAGE_REST_HYPERMEDIA_H
@@ -33,6 +35,8 @@ SOFTWARE.
 
 #include "simple.h"
 
+#include "../../bricks/util/base64.h"
+
 namespace current {
 namespace storage {
 namespace rest {
@@ -77,6 +81,69 @@ struct PopulateCollectionRecord<ENTRY, current::GenericMapAccessor<MAP>> {
   }
 };
 
+template <typename T>
+struct IsCompositeKey : std::false_type {};
+
+template <typename ROW, typename COL>
+struct IsCompositeKey<std::pair<ROW, COL>> : std::true_type {};
+
+// The key that the cursor-based pagination remembers and resumes from is the iterator's own key, if available.
+// This way, for ordered containers, it can be passed right into `UpperBound()`.
+template <typename PARTICULAR_FIELD, typename ENTRY>
+struct CursorKey {
+  template <typename ITERATOR>
+  static std::string Get(const ITERATOR& iterator) {
+    return GetImpl(iterator, 0);
+  }
+
+ private:
+  template <typename ITERATOR>
+  static auto GetImpl(const ITERATOR& iterator, int)
+      -> std::enable_if_t<!IsCompositeKey<current::decay<decltype(iterator.key())>>::value, std::string> {
+    return current::ToString(iterator.key());
+  }
+  template <typename ITERATOR>
+  static auto GetImpl(const ITERATOR& iterator, long)
+      -> decltype(current::ToString(iterator.OuterKeyForPartialHypermediaCollectionView())) {
+    return current::ToString(iterator.OuterKeyForPartialHypermediaCollectionView());
+  }
+  template <typename ITERATOR>
+  static std::string GetImpl(const ITERATOR& iterator, ...) {
+    return ComposeRESTfulKey<PARTICULAR_FIELD, ENTRY>(iterator);
+  }
+};
+
+// Positions the iterator right past the element with the given cursor key, or where it would be if it is gone by now.
+// Only ordered containers, which expose `UpperBound()`, are supported, so that the seek is O(log N).
+// For unordered ones it would take a scan of the collection, which is no better than the `?i=` pagination.
+template <typename PARTICULAR_FIELD, typename ENTRY>
+struct CursorSeek {
+  template <typename ITERABLE>
+  static constexpr bool Supported() {
+    return decltype(SeekImpl(std::declval<const ITERABLE&>(),
+                             std::declval<const std::string&>(),
+                             std::declval<decltype(std::declval<const ITERABLE&>().begin())&>(),
+                             0))::value;
+  }
+
+  template <typename ITERABLE, typename ITERATOR>
+  static void Seek(const ITERABLE& span, const std::string& key, ITERATOR& iterator) {
+    SeekImpl(span, key, iterator, 0);
+  }
+
+ private:
+  template <typename ITERABLE, typename ITERATOR>
+  static auto SeekImpl(const ITERABLE& span, const std::string& key, ITERATOR& iterator, int)
+      -> decltype(iterator = span.UpperBound(current::FromString<typename ITERABLE::key_t>(key)), std::true_type()) {
+    iterator = span.UpperBound(current::FromString<typename ITERABLE::key_t>(key));
+    return std::true_type();
+  }
+  template <typename ITERABLE, typename ITERATOR>
+  static std::false_type SeekImpl(const ITERABLE&, const std::string&, ITERATOR&, ...) {
+    return std::false_type();
+  }
+};
+
 struct HypermediaResponseFormatter {
   // TODO(dkorolev): We could move to per-HTTP-VERB context type as it's high performance time.
   struct Context {
@@ -86,6 +153,10 @@ struct HypermediaResponseFormatter {
     // For poor man's pagination when viewing the collection.
     mutable uint64_t query_i = 0u;
     mutable uint64_t query_n = 10u;  // Default page size.
+
+    // For cursor-based pagination, enabled by the presence of `?cursor`. An empty cursor stands for the first page.
+    bool query_cursor_mode = false;
+    std::string query_cursor;
   };
 
   template <typename ENTRY>
@@ -119,6 +190,11 @@ struct HypermediaResponseFormatter {
     HypermediaRESTCollectionResponse<collection_element_t> response;
     response.url_directory = collection_url;
 
+    if (context.query_cursor_mode) {
+      return BuildResponseWithCollectionPageAfterCursor<PARTICULAR_FIELD, ENTRY>(
+          context, pagination_url, collection_url, std::forward<ITERABLE>(span), response);
+    }
+
     // Poor man's pagination.
     const size_t total = span.Size();
     bool has_previous_page = false;
@@ -126,7 +202,6 @@ struct HypermediaResponseFormatter {
     uint64_t current_index = 0;
     response.data.reserve(context.query_n);
     for (auto iterator = span.begin(); iterator != span.end(); ++iterator) {
-      using iterator_t = decltype(iterator);
       // NOTE(dkorolev): This `iterator` can be of more than three different kinds, among which are:
       // 1) container/many_to_many.h. ManyToMany::OuterAccessor::OuterIterator
       // 2) container/one_to_many.h, OneToMany::RowsAccessor::RowsIterator
@@ -136,11 +211,7 @@ struct HypermediaResponseFormatter {
       // To keep the generic code generic, it's accesses as `iterator`, not via a range-based loop.
       if (current_index >= context.query_i && current_index < context.query_i + context.query_n) {
         response.data.resize(response.data.size() + 1);
-        collection_element_t& record = response.data.back();
-
-        record.url = collection_url + '/' + ComposeRESTfulKey<PARTICULAR_FIELD, ENTRY>(iterator);
-        PopulateCollectionRecord<ENTRY, typename current::decay<typename iterator_t::value_t>>::DoIt(
-            record.DataOrBriefByRef(), iterator);
+        PopulateRecord<PARTICULAR_FIELD, ENTRY>(response.data.back(), collection_url, iterator);
       } else if (current_index < context.query_i) {
         has_previous_page = true;
       } else if (current_index >= context.query_i + context.query_n) {
@@ -171,6 +242,68 @@ struct HypermediaResponseFormatter {
           context.query_n);
     }
 
+    return Response(response, HTTPResponseCode.OK);
+  }
+
+ private:
+  template <typename PARTICULAR_FIELD, typename ENTRY, typename RECORD, typename ITERATOR>
+  static void PopulateRecord(RECORD& record, const std::string& collection_url, const ITERATOR& iterator) {
+    record.url = collection_url + '/' + ComposeRESTfulKey<PARTICULAR_FIELD, ENTRY>(iterator);
+    PopulateCollectionRecord<ENTRY, typename current::decay<typename ITERATOR::value_t>>::DoIt(
+        record.DataOrBriefByRef(), iterator);
+  }
+
+  // Cursor-based pagination. Forward-only: `url_previous_page` is never set, and `i` is always zero, as computing it
+  // would take the very O(i) walk over the collection that cursors are here to avoid.
+  template <typename PARTICULAR_FIELD, typename ENTRY, typename ITERABLE, typename RESPONSE>
+  static Response BuildResponseWithCollectionPageAfterCursor(const Context& context,
+                                                             const std::string& pagination_url,
+                                                             const std::string& collection_url,
+                                                             ITERABLE&& span,
+                                                             RESPONSE& response) {
+    const auto gen_page_url = [&pagination_url](const std::string& cursor, uint64_t url_n) {
+      return pagination_url + "?cursor=" + cursor + "&n=" + current::ToString(url_n);
+    };
+
+    if (!CursorSeek<PARTICULAR_FIELD, ENTRY>::template Supported<current::decay<ITERABLE>>()) {
+      return ErrorResponse(InvalidCursorError("Cursor-based pagination is only supported for ordered collections.",
+                                              context.query_cursor),
+                           HTTPResponseCode.BadRequest);
+    }
+
+    auto iterator = span.begin();
+    if (!context.query_cursor.empty()) {
+      std::string key;
+      try {
+        key = current::Base64URLDecode(context.query_cursor);
+      } catch (const current::Base64DecodeException&) {
+        return ErrorResponse(InvalidCursorError("Malformed cursor.", context.query_cursor),
+                             HTTPResponseCode.BadRequest);
+      }
+      CursorSeek<PARTICULAR_FIELD, ENTRY>::Seek(span, key, iterator);
+    }
+
+    response.data.reserve(context.query_n);
+    std::string last_key;
+    bool has_next_page = false;
+    for (; iterator != span.end(); ++iterator) {
+      if (response.data.size() >= context.query_n) {
+        has_next_page = true;
+        break;
+      }
+      response.data.resize(response.data.size() + 1);
+      PopulateRecord<PARTICULAR_FIELD, ENTRY>(response.data.back(), collection_url, iterator);
+      last_key = CursorKey<PARTICULAR_FIELD, ENTRY>::Get(iterator);
+    }
+
+    response.url = gen_page_url(context.query_cursor, context.query_n);
+    response.i = 0u;
+    response.n = response.data.size();
+    response.total = span.Size();
+    if (has_next_page) {
+      response.url_next_page = gen_page_url(current::Base64URLEncode(last_key), context.query_n);
+    }
+
     return Response(response, HTTPResponseCode.OK);
   }
 };
@@ -199,6 +332,8 @@ struct Hypermedia : generic::Structured<hypermedia::HypermediaResponseFormatter>
       context.brief = ((q["fields"] == "brief") || q.has("brief")) && !q.has("full");
       context.query_i = current::FromString<uint64_t>(q.get("i", current::ToString(context.query_i)));
       context.query_n = current::FromString<uint64_t>(q.get("n", current::ToString(context.query_n)));
+      context.query_cursor_mode = q.has("cursor");
+      context.query_cursor = q.get("cursor", "");
 
       SUPER_GET_HANDLER_GENERATOR::Enter(std::move(request), std::forward<F>(next));
     }
@@ -138,6 +138,10 @@ inline generic::RESTError InvalidKeyError(const std::string& message,
   return generic::RESTError("InvalidKey", message, details);
 }
 
+inline generic::RESTError InvalidCursorError(const std::string& message, const std::string& cursor) {
+  return generic::RESTError("InvalidCursor", message, {{"cursor", cursor}});
+}
+
 inline generic::RESTError ResourceNotFoundError(const std::string& message,
                                                 const std::map<std::string, std::string>& details) {
   return generic::RESTError("ResourceNotFound", message, details);
@@ -34,6 +34,9 @@ SOFTWARE.
 //   Empty(), Size(), Rows()/Cols(), Add(cell), Delete(row, col) [, iteration, {lower/upper}_bound].
 //   `row_t` and `col_t` are either the type of `T.row` / `T.col`, or of `T.get_row()` / `T.get_col()`.
 //
+// * Compact(One/Many)ToCompactMany<T> <=> same as above, with rows and columns kept in sorted contiguous arrays.
+//   Ordered, read-optimized: row and column scans are sequential reads, and no per-cell node is allocated for them.
+//
 // All Current-friendly types support persistence.
 //
 // Only allow default constructors for containers.
@@ -245,6 +248,9 @@ namespace storage {
 #define CURRENT_STORAGE_FIELD_ENTRY_OrderedManyToUnorderedMany(entry_type, entry_name) \
   CURRENT_STORAGE_FIELD_ENTRY_Matrix_IMPL(OrderedManyToUnorderedMany, entry_type, entry_name)
 
+#define CURRENT_STORAGE_FIELD_ENTRY_CompactManyToCompactMany(entry_type, entry_name) \
+  CURRENT_STORAGE_FIELD_ENTRY_Matrix_IMPL(CompactManyToCompactMany, entry_type, entry_name)
+
 #define CURRENT_STORAGE_FIELD_ENTRY_UnorderedOneToUnorderedOne(entry_type, entry_name) \
   CURRENT_STORAGE_FIELD_ENTRY_Matrix_IMPL(UnorderedOneToUnorderedOne, entry_type, entry_name)
 
@@ -269,6 +275,9 @@ namespace storage {
 #define CURRENT_STORAGE_FIELD_ENTRY_OrderedOneToUnorderedMany(entry_type, entry_name) \
   CURRENT_STORAGE_FIELD_ENTRY_Matrix_IMPL(OrderedOneToUnorderedMany, entry_type, entry_name)
 
+#define CURRENT_STORAGE_FIELD_ENTRY_CompactOneToCompactMany(entry_type, entry_name) \
+  CURRENT_STORAGE_FIELD_ENTRY_Matrix_IMPL(CompactOneToCompactMany, entry_type, entry_name)
+
 #define CURRENT_STORAGE_FIELD_ENTRY(container, entry_type, entry_name) \
   CURRENT_STORAGE_FIELD_ENTRY_##container(entry_type, entry_name)
 
@@ -1315,6 +1315,34 @@ TEST(TransactionalStorage, TransactionMetaFields) {
   }
 }
 
+TEST(TransactionalStorage, TransactionsAreParsedWithNoDOM) {
+  current::time::ResetToZero();
+
+  using namespace transactional_storage_test;
+  using storage_t = TestStorage<StreamInMemoryStreamPersister>;
+  using current::serialization::json::ReusableJSONParserMemory;
+
+  current::Owned<storage_t> storage = storage_t::CreateMasterStorage();
+  current::time::SetNow(std::chrono::microseconds(100));
+  const auto result = storage->ReadWriteTransaction([](MutableFields<storage_t> fields) {
+    fields.d.Add(Record{"one", 1});
+    fields.d.Add(Record{"two", 2});
+    fields.d.Erase("one");
+    fields.omany_to_omany.Add(Cell{1, "one", 1});
+    fields.SetTransactionMetaField("who", "anyone");
+  }).Go();
+  EXPECT_TRUE(WasCommitted(result));
+
+  // The meta, the mutations, and the objects within are all parsed directly.
+  const std::string json = JSON((*storage->UnderlyingStream()->Data()->Iterate(0u).begin()).entry);
+  const uint64_t before = ReusableJSONParserMemory::ValuesParsedViaDOM();
+  const auto transaction = ParseJSON<storage_t::transaction_t>(json);
+  EXPECT_EQ(before, ReusableJSONParserMemory::ValuesParsedViaDOM());
+  EXPECT_EQ(4u, transaction.mutations.size());
+  EXPECT_EQ("anyone", transaction.meta.fields.at("who"));
+  EXPECT_EQ(json, JSON(transaction));
+}
+
 TEST(TransactionalStorage, LastModifiedInDictionaryContainer) {
   current::time::ResetToZero();
 
@@ -1930,6 +1958,173 @@ TEST(TransactionalStorage, GracefulShutdown) {
   ASSERT_THROW(result.Go(), current::storage::StorageInGracefulShutdownException);
 }
 
+namespace transactional_storage_test {
+
+CURRENT_STORAGE_FIELD_ENTRY(CompactManyToCompactMany, Cell, CellCompactManyToCompactMany);
+CURRENT_STORAGE_FIELD_ENTRY(CompactOneToCompactMany, Cell, CellCompactOneToCompactMany);
+
+CURRENT_STORAGE(CompactTestStorage) {
+  CURRENT_STORAGE_FIELD(cmany_to_cmany, CellCompactManyToCompactMany);
+  CURRENT_STORAGE_FIELD(cone_to_cmany, CellCompactOneToCompactMany);
+  CURRENT_STORAGE_FIELD(omany_to_omany, CellOrderedManyToOrderedMany);
+};
+
+}  // namespace transactional_storage_test
+
+TEST(TransactionalStorage, CompactMatrixContainers) {
+  current::time::ResetToZero();
+
+  using namespace transactional_storage_test;
+  using storage_t = CompactTestStorage<StreamInMemoryStreamPersister>;
+
+  auto storage = storage_t::CreateMasterStorage();
+
+  // Insert enough cells, in a shuffled order, to have the delta buffers merged more than once.
+  {
+    const auto result = storage->ReadWriteTransaction([](MutableFields<storage_t> fields) {
+      for (int32_t i = 0; i < 1000; ++i) {
+        const int32_t x = (i * 37) % 1000;
+        const Cell cell(x % 10, current::ToString(x / 10 + 100), x);
+        fields.cmany_to_cmany.Add(cell);
+        fields.cone_to_cmany.Add(cell);
+        fields.omany_to_omany.Add(cell);
+      }
+      EXPECT_EQ(1000u, fields.cmany_to_cmany.Size());
+      EXPECT_EQ(10u, fields.cmany_to_cmany.Rows().Size());
+      EXPECT_EQ(100u, fields.cmany_to_cmany.Cols().Size());
+      EXPECT_EQ(100u, fields.cone_to_cmany.Cols().Size());
+    }).Go();
+    EXPECT_TRUE(WasCommitted(result));
+  }
+
+  // Compact and `std::map`-based containers must agree on the contents and on the order of rows and columns.
+  const auto dump = [](const std::string& prefix, const Cell& cell) {
+    return prefix + current::ToString(cell.foo) + ':' + cell.bar + '=' + current::ToString(cell.phew) + ' ';
+  };
+  {
+    const auto result = storage->ReadOnlyTransaction([&dump](ImmutableFields<storage_t> fields) {
+      std::string compact;
+      std::string ordered;
+      for (const auto& row : fields.cmany_to_cmany.Rows()) {
+        for (const auto& cell : row) {
+          compact += dump("R", cell);
+        }
+      }
+      for (const auto& col : fields.cmany_to_cmany.Cols()) {
+        for (const auto& cell : col) {
+          compact += dump("C", cell);
+        }
+      }
+      for (const auto& row : fields.omany_to_omany.Rows()) {
+        for (const auto& cell : row) {
+          ordered += dump("R", cell);
+        }
+      }
+      for (const auto& col : fields.omany_to_omany.Cols()) {
+        for (const auto& cell : col) {
+          ordered += dump("C", cell);
+        }
+      }
+      EXPECT_EQ(ordered, compact);
+
+      EXPECT_EQ(100u, fields.cmany_to_cmany.Row(7).Size());
+      EXPECT_EQ(10u, fields.cmany_to_cmany.Col("142").Size());
+      EXPECT_EQ(427, Value(fields.cmany_to_cmany.Get(7, "142")).phew);
+      EXPECT_EQ("143", (*fields.cmany_to_cmany.Row(7).UpperBound("142")).bar);
+      EXPECT_EQ("R7:199=997 ", dump("R", *fields.cmany_to_cmany.Row(7).rbegin()));
+      EXPECT_FALSE(fields.cmany_to_cmany.Has(10, "100"));
+
+      // In `OneToMany`, the cell added last for each col wins.
+      EXPECT_EQ(100u, fields.cone_to_cmany.Size());
+      EXPECT_EQ(1, Value(fields.cone_to_cmany.Get(1, "100")).phew);
+      EXPECT_FALSE(fields.cone_to_cmany.Has(0, "100"));
+    }).Go();
+    EXPECT_TRUE(WasCommitted(result));
+  }
+
+  // Erase some cells, add some back, roll back, and confirm the integrity of rows and columns.
+  {
+    const auto result = storage->ReadWriteTransaction([](MutableFields<storage_t> fields) {
+      for (int32_t x = 0; x < 1000; x += 2) {
+        fields.cmany_to_cmany.Erase(x % 10, current::ToString(x / 10 + 100));
+      }
+      EXPECT_EQ(500u, fields.cmany_to_cmany.Size());
+      EXPECT_EQ(5u, fields.cmany_to_cmany.Rows().Size());
+      EXPECT_FALSE(fields.cmany_to_cmany.Rows().Has(0));
+      EXPECT_TRUE(fields.cmany_to_cmany.Rows().Has(1));
+      fields.cmany_to_cmany.Add(Cell(0, "500", 42));
+      EXPECT_EQ(1u, fields.cmany_to_cmany.Row(0).Size());
+      CURRENT_STORAGE_THROW_ROLLBACK();
+    }).Go();
+    EXPECT_FALSE(WasCommitted(result));
+  }
+  {
+    const auto result = storage->ReadOnlyTransaction([](ImmutableFields<storage_t> fields) {
+      EXPECT_EQ(1000u, fields.cmany_to_cmany.Size());
+      EXPECT_EQ(100u, fields.cmany_to_cmany.Row(0).Size());
+      EXPECT_FALSE(fields.cmany_to_cmany.Has(0, "500"));
+      size_t total = 0u;
+      for (const auto& col : fields.cmany_to_cmany.Cols()) {
+        total += col.Size();
+      }
+      EXPECT_EQ(1000u, total);
+    }).Go();
+    EXPECT_TRUE(WasCommitted(result));
+  }
+}
+
+TEST(TransactionalStorage, CompactMapErase) {
+  current::storage::container::CompactMap<int, std::string> map;
+  std::map<int, std::string> golden;
+  const auto dump = [](const std::string& prefix, const std::pair<int, std::string>& e) {
+    return prefix + current::ToString(e.first) + '=' + e.second + ' ';
+  };
+  const auto compare = [&]() {
+    std::string compact;
+    std::string ordered;
+    for (const auto& e : map) {
+      compact += dump("", e);
+    }
+    for (const auto& e : golden) {
+      ordered += dump("", e);
+    }
+    EXPECT_EQ(ordered, compact);
+    EXPECT_EQ(golden.size(), map.size());
+  };
+
+  for (int i = 0; i < 1000; ++i) {
+    map[i] = golden[i] = current::ToString(i);
+  }
+  compare();
+
+  // Erase in bulk, with the erased elements kept as tombstones until the next merge.
+  for (int i = 0; i < 1000; i += 3) {
+    EXPECT_EQ(1u, map.erase(i));
+    EXPECT_EQ(0u, map.erase(i));
+    golden.erase(i);
+  }
+  EXPECT_EQ(golden.size(), map.size());
+  compare();
+
+  // Erasing, then re-inserting the same key before the merge yields a default-constructed value.
+  EXPECT_EQ(1u, map.erase(1));
+  EXPECT_EQ("", map[1]);
+  map[1] = "one";
+  golden[1] = "one";
+  EXPECT_EQ(1u, map.erase(2));
+  map[1001] = golden[1001] = "new";
+  golden.erase(2);
+  compare();
+  EXPECT_EQ(0u, map.count(2));
+  EXPECT_EQ("one", map.find(1)->second);
+
+  for (int i = 0; i < 1002; ++i) {
+    map.erase(i);
+  }
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.begin() == map.end());
+}
+
 #endif  // STORAGE_ONLY_RUN_RESTFUL_TESTS
 
 namespace transactional_storage_test {
@@ -2165,6 +2360,42 @@ TEST(TransactionalStorage, RESTfulAPITest) {
     EXPECT_EQ(user1_key + '\t' + JSON(user1) + '\n' + user2_key + '\t' + JSON(user2) + '\n',
               HTTP(GET(base_url + "/api_plain/data/user")).body);
 
+    // Cursor-based pagination through the ordered dictionary of users.
+    {
+      using page_t =
+          hypermedia::HypermediaRESTCollectionResponse<hypermedia::HypermediaRESTFullCollectionRecord<SimpleUser>>;
+      const auto page1 = ParseJSON<page_t>(HTTP(GET(base_url + "/api_hypermedia/data/user?cursor&n=1")).body);
+      ASSERT_EQ(1u, page1.data.size());
+      EXPECT_EQ(1u, page1.n);
+      EXPECT_EQ(2u, page1.total);
+      EXPECT_FALSE(Exists(page1.url_previous_page));
+      ASSERT_TRUE(Exists(page1.url_next_page));
+      const std::string next_page_path = Value(page1.url_next_page).substr(Value(page1.url_next_page).find("/data/"));
+      EXPECT_EQ("/data/user?cursor=" + current::Base64URLEncode(page1.data[0].data.key) + "&n=1", next_page_path);
+
+      const auto page2 = ParseJSON<page_t>(HTTP(GET(base_url + "/api_hypermedia" + next_page_path)).body);
+      ASSERT_EQ(1u, page2.data.size());
+      EXPECT_FALSE(Exists(page2.url_next_page));
+      EXPECT_LT(page1.data[0].data.key, page2.data[0].data.key);
+      EXPECT_EQ((std::set<std::string>{user1_key, user2_key}),
+                (std::set<std::string>{page1.data[0].data.key, page2.data[0].data.key}));
+
+      EXPECT_EQ(400, static_cast<int>(HTTP(GET(base_url + "/api_hypermedia/data/user?cursor=!!!&n=1")).code));
+
+      // A cursor pointing to a deleted element resumes right past where it was.
+      const auto page2_again = ParseJSON<page_t>(HTTP(GET(base_url + "/api_hypermedia/data/user?cursor=" +
+                                                           current::Base64URLEncode(page1.data[0].data.key + "!") +
+                                                           "&n=1")).body);
+      ASSERT_EQ(1u, page2_again.data.size());
+      EXPECT_EQ(page2.data[0].data.key, page2_again.data[0].data.key);
+
+      // Unordered containers do not support cursors.
+      const auto unordered = HTTP(GET(base_url + "/api_hypermedia/data/post?cursor&n=1"));
+      EXPECT_EQ(400, static_cast<int>(unordered.code));
+      EXPECT_NE(std::string::npos, unordered.body.find("only supported for ordered collections")) << unordered.body;
+      EXPECT_EQ(400, static_cast<int>(HTTP(GET(base_url + "/api_hypermedia/data/like.row?cursor&n=1")).code));
+    }
+
     // Confirm matrix collection retrieval.
     EXPECT_EQ(200, static_cast<int>(HTTP(GET(base_url + "/api_plain/data/user.key")).code));
     EXPECT_EQ(404, static_cast<int>(HTTP(GET(base_url + "/api_plain/data/user.row")).code));
@@ -2617,6 +2848,80 @@ TEST(TransactionalStorage, RESTfulAPIMatrixTest) {
           "3\",\"data\":{\"row\":\"!2\",\"col\":3}}]}\n",
           response.body);
     }
+    // And cursor-based pagination, over both rows of the matrix and the elements of a row.
+    {
+      const auto response = HTTP(GET(base_url + "/hypermedia/data/composite_m2m.1?cursor&n=2"));
+      EXPECT_EQ(200, static_cast<int>(response.code));
+      EXPECT_EQ(
+          "{\"success\":true,\"url\":\"/data/composite_m2m.1?cursor=&n=2\",\"url_directory\":\"/data/"
+          "composite_m2m.1\",\"i\":0,\"n\":2,\"total\":3,\"url_next_page\":\"/data/composite_m2m.1?cursor=ITI=&n=2\","
+          "\"url_previous_page\":null,"
+          "\"data\":[{\"url\":\"/data/composite_m2m.1/"
+          "!1\",\"data\":{\"total\":2,\"preview\":[{\"row\":\"!1\",\"col\":2},{\"row\":\"!1\",\"col\":3}]}},{"
+          "\"url\":\"/data/composite_m2m.1/"
+          "!2\",\"data\":{\"total\":2,\"preview\":[{\"row\":\"!2\",\"col\":1},{\"row\":\"!2\",\"col\":3}]}}]}\n",
+          response.body);
+    }
+    {
+      // Same for the rows of a `OneToOne` matrix, each of which is a single element.
+      for (int i = 1; i <= 3; ++i) {
+        const std::string row = "!" + current::ToString(i);
+        EXPECT_EQ(201,
+                  static_cast<int>(HTTP(PUT(base_url + "/plain/data/composite_o2o/" + row + '/' + current::ToString(i),
+                                            SimpleComposite(row, std::chrono::microseconds(i)))).code));
+      }
+      const auto response = HTTP(GET(base_url + "/hypermedia/data/composite_o2o.1?cursor=" +
+                                     current::Base64URLEncode("!15") + "&n=1"));
+      EXPECT_EQ(200, static_cast<int>(response.code));
+      EXPECT_EQ(
+          "{\"success\":true,\"url\":\"/data/composite_o2o.1?cursor=ITE1&n=1\",\"url_directory\":\"/data/"
+          "composite_o2o.1\",\"i\":0,\"n\":1,\"total\":3,\"url_next_page\":\"/data/composite_o2o.1?cursor=ITI=&n=1\","
+          "\"url_previous_page\":null,\"data\":[{\"url\":\"/data/composite_o2o.1/!2\",\"data\":{\"total\":1,"
+          "\"preview\":[{\"row\":\"!2\",\"col\":2}]}}]}\n",
+          response.body);
+    }
+    {
+      const auto response = HTTP(GET(base_url + "/hypermedia/data/composite_m2m.1?cursor=ITI=&n=2"));
+      EXPECT_EQ(200, static_cast<int>(response.code));
+      EXPECT_EQ(
+          "{\"success\":true,\"url\":\"/data/composite_m2m.1?cursor=ITI=&n=2\",\"url_directory\":\"/data/"
+          "composite_m2m.1\",\"i\":0,\"n\":1,\"total\":3,\"url_next_page\":null,\"url_previous_page\":null,"
+          "\"data\":[{\"url\":\"/data/composite_m2m.1/"
+          "!3\",\"data\":{\"total\":2,\"preview\":[{\"row\":\"!3\",\"col\":1},{\"row\":\"!3\",\"col\":2}]}}]}\n",
+          response.body);
+    }
+    {
+      const auto response = HTTP(GET(base_url + "/hypermedia/data/composite_m2m.1/!2?cursor&n=1"));
+      EXPECT_EQ(200, static_cast<int>(response.code));
+      EXPECT_EQ(
+          "{\"success\":true,\"url\":\"/data/composite_m2m.1/!2?cursor=&n=1\",\"url_directory\":\"/data/"
+          "composite_m2m\",\"i\":0,\"n\":1,\"total\":2,\"url_next_page\":\"/data/composite_m2m.1/"
+          "!2?cursor=MQ==&n=1\",\"url_previous_page\":null,\"data\":[{\"url\":\"/data/composite_m2m/!2/"
+          "1\",\"data\":{\"row\":\"!2\",\"col\":1}}]}\n",
+          response.body);
+    }
+    {
+      const auto response = HTTP(GET(base_url + "/hypermedia/data/composite_m2m.1/!2?cursor=MQ==&n=1"));
+      EXPECT_EQ(200, static_cast<int>(response.code));
+      EXPECT_EQ(
+          "{\"success\":true,\"url\":\"/data/composite_m2m.1/!2?cursor=MQ==&n=1\",\"url_directory\":\"/data/"
+          "composite_m2m\",\"i\":0,\"n\":1,\"total\":2,\"url_next_page\":null,\"url_previous_page\":null,"
+          "\"data\":[{\"url\":\"/data/composite_m2m/!2/3\",\"data\":{\"row\":\"!2\",\"col\":3}}]}\n",
+          response.body);
+    }
+    {
+      // The ordered rows of a matrix are sought to right past the cursor key, which may be gone by now.
+      const auto response = HTTP(GET(base_url + "/hypermedia/data/composite_m2m.1?cursor=" +
+                                     current::Base64URLEncode("!15") + "&n=1"));
+      EXPECT_EQ(200, static_cast<int>(response.code));
+      EXPECT_EQ(
+          "{\"success\":true,\"url\":\"/data/composite_m2m.1?cursor=ITE1&n=1\",\"url_directory\":\"/data/"
+          "composite_m2m.1\",\"i\":0,\"n\":1,\"total\":3,\"url_next_page\":\"/data/composite_m2m.1?cursor=ITI=&n=1\","
+          "\"url_previous_page\":null,"
+          "\"data\":[{\"url\":\"/data/composite_m2m.1/"
+          "!2\",\"data\":{\"total\":2,\"preview\":[{\"row\":\"!2\",\"col\":1},{\"row\":\"!2\",\"col\":3}]}}]}\n",
+          response.body);
+    }
   }
 
   {
@@ -2986,6 +3291,88 @@ TEST(TransactionalStorage, CQSTest) {
   // TODO(dkorolev): Also test transaction meta fields.
 }
 
+namespace transactional_storage_test {
+
+CURRENT_STRUCT(CQSCountingQuery) {
+  static std::atomic_int& Invocations() {
+    static std::atomic_int invocations(0);
+    return invocations;
+  }
+
+  template <class IMMUTABLE_FIELDS>
+  Response Query(const IMMUTABLE_FIELDS& fields, const current::storage::rest::cqs::CQSParameters&) const {
+    ++Invocations();
+    return Response(current::ToString(fields.user.Size()));
+  }
+};
+
+}  // namespace transactional_storage_test
+
+TEST(TransactionalStorage, CachedResponses) {
+  current::time::ResetToZero();
+
+  using namespace transactional_storage_test;
+  using storage_t = SimpleStorage<StreamInMemoryStreamPersister>;
+
+  auto storage = storage_t::CreateMasterStorage();
+
+  const auto base_url = current::strings::Printf("http://localhost:%d", FLAGS_transactional_storage_test_port);
+  auto rest = RESTfulStorage<storage_t>(*storage, FLAGS_transactional_storage_test_port, "/api", "");
+  rest.template AddCQSQuery<CQSCountingQuery>("count");
+  CQSCountingQuery::Invocations() = 0;
+
+  current::time::SetNow(std::chrono::microseconds(100));
+  EXPECT_EQ(201, static_cast<int>(HTTP(PUT(base_url + "/api/data/user/dima", SimpleUser("dima", "DK"))).code));
+
+  // Disabled by default.
+  EXPECT_EQ("1", HTTP(GET(base_url + "/api/cqs/query/count")).body);
+  EXPECT_EQ("1", HTTP(GET(base_url + "/api/cqs/query/count")).body);
+  EXPECT_EQ(2, CQSCountingQuery::Invocations());
+
+  rest.EnableResponseCache();
+  EXPECT_EQ("1", HTTP(GET(base_url + "/api/cqs/query/count")).body);
+  EXPECT_EQ("1", HTTP(GET(base_url + "/api/cqs/query/count")).body);
+  EXPECT_EQ("1", HTTP(GET(base_url + "/api/cqs/query/count?unused=42")).body);
+  EXPECT_EQ(4, CQSCountingQuery::Invocations());
+  EXPECT_EQ("DK", ParseJSON<SimpleUser>(HTTP(GET(base_url + "/api/data/user/dima")).body).name);
+  EXPECT_EQ("DK", ParseJSON<SimpleUser>(HTTP(GET(base_url + "/api/data/user/dima")).body).name);
+  EXPECT_EQ(404, static_cast<int>(HTTP(GET(base_url + "/api/data/user/max")).code));
+  EXPECT_EQ(404, static_cast<int>(HTTP(GET(base_url + "/api/data/user/max")).code));
+  {
+    const auto stats = rest.GetResponseCacheStats();
+    EXPECT_EQ(2u, stats.hits);
+    EXPECT_EQ(5u, stats.misses);
+  }
+
+  // Any transaction invalidates the cached responses.
+  current::time::SetNow(std::chrono::microseconds(200));
+  EXPECT_EQ(201, static_cast<int>(HTTP(PUT(base_url + "/api/data/user/max", SimpleUser("max", "MZ"))).code));
+  current::time::SetNow(std::chrono::microseconds(300));
+  EXPECT_EQ(200, static_cast<int>(HTTP(PUT(base_url + "/api/data/user/dima", SimpleUser("dima", "DKK"))).code));
+  EXPECT_EQ("2", HTTP(GET(base_url + "/api/cqs/query/count")).body);
+  EXPECT_EQ("2", HTTP(GET(base_url + "/api/cqs/query/count")).body);
+  EXPECT_EQ(5, CQSCountingQuery::Invocations());
+  EXPECT_EQ("DKK", ParseJSON<SimpleUser>(HTTP(GET(base_url + "/api/data/user/dima")).body).name);
+  EXPECT_EQ("MZ", ParseJSON<SimpleUser>(HTTP(GET(base_url + "/api/data/user/max")).body).name);
+
+  rest.DisableResponseCache();
+  EXPECT_EQ("2", HTTP(GET(base_url + "/api/cqs/query/count")).body);
+  EXPECT_EQ(6, CQSCountingQuery::Invocations());
+
+  // Once full, the cache evicts the least recently used response to make room for the new one.
+  rest.EnableResponseCache(2u);
+  EXPECT_EQ("2", HTTP(GET(base_url + "/api/cqs/query/count?a")).body);
+  EXPECT_EQ("2", HTTP(GET(base_url + "/api/cqs/query/count?b")).body);
+  EXPECT_EQ("2", HTTP(GET(base_url + "/api/cqs/query/count?a")).body);
+  EXPECT_EQ(8, CQSCountingQuery::Invocations());
+  EXPECT_EQ("2", HTTP(GET(base_url + "/api/cqs/query/count?c")).body);
+  EXPECT_EQ("2", HTTP(GET(base_url + "/api/cqs/query/count?a")).body);
+  EXPECT_EQ("2", HTTP(GET(base_url + "/api/cqs/query/count?c")).body);
+  EXPECT_EQ(9, CQSCountingQuery::Invocations());
+  EXPECT_EQ("2", HTTP(GET(base_url + "/api/cqs/query/count?b")).body);
+  EXPECT_EQ(10, CQSCountingQuery::Invocations());
+}
+
 // LCOV_EXCL_START
 // Test the `CURRENT_STORAGE_FIELD_EXCLUDE_FROM_REST(field)` macro.
 namespace transactional_storage_test {
@@ -3346,6 +3733,133 @@ TEST(TransactionalStorage, FollowingStorageFlipsToMaster) {
   }
 }
 
+TEST(TransactionalStorage, PipelinedFollowingStorageReplaysInOrderAndFlipsToMaster) {
+  current::time::ResetToZero();
+
+  using namespace transactional_storage_test;
+  using storage_t = SimpleStorage<PipelinedStreamStreamPersister>;
+  using transaction_t = typename storage_t::transaction_t;
+  using stream_t = current::stream::Stream<transaction_t, current::persistence::File>;
+  using StreamReplicator = current::stream::StreamReplicator<stream_t>;
+
+  const std::string master_file_name = current::FileSystem::JoinPath(FLAGS_transactional_storage_test_tmpdir, "master");
+  const auto master_file_remover = current::FileSystem::ScopedRmFile(master_file_name);
+
+  const std::string follower_file_name =
+      current::FileSystem::JoinPath(FLAGS_transactional_storage_test_tmpdir, "follower");
+  const auto follower_file_remover = current::FileSystem::ScopedRmFile(follower_file_name);
+
+  auto owned_follower_stream = stream_t::CreateStream(follower_file_name);
+  auto replicator = std::make_unique<StreamReplicator>(owned_follower_stream);
+
+  auto master_stream = storage_t::stream_t::CreateStream(master_file_name);
+  auto master_storage = storage_t::CreateMasterStorageAtopExistingStream(master_stream);
+  auto follower_storage = storage_t::CreateFollowingStorageAtopExistingStream(owned_follower_stream);
+
+  // Each transaction overwrites the same record, so that the final state is only correct if they are applied in order.
+  const size_t N = 500u;
+  {
+    const auto replicator_scope = master_storage->template Subscribe<transaction_t>(*replicator);
+    for (size_t i = 1u; i <= N; ++i) {
+      current::time::SetNow(std::chrono::microseconds(i * 100));
+      const auto result = master_storage->ReadWriteTransaction([i](MutableFields<storage_t> fields) {
+        fields.user.Add(SimpleUser("i" + current::ToString(i), "x"));
+        fields.user.Add(SimpleUser("last", current::ToString(i)));
+      }).Go();
+      EXPECT_TRUE(WasCommitted(result));
+    }
+
+    size_t user_size = 0u;
+    do {
+      const auto result = follower_storage->ReadOnlyTransaction([](ImmutableFields<storage_t> fields) {
+        return fields.user.Size();
+      }).Go();
+      EXPECT_TRUE(WasCommitted(result));
+      user_size = Value(result);
+    } while (user_size != N + 1u);
+
+    const auto result = follower_storage->ReadOnlyTransaction([N](ImmutableFields<storage_t> fields) {
+      ASSERT_TRUE(Exists(fields.user["last"]));
+      EXPECT_EQ(current::ToString(N), Value(fields.user["last"]).name);
+    }).Go();
+    EXPECT_TRUE(WasCommitted(result));
+    EXPECT_EQ(std::chrono::microseconds(N * 100), follower_storage->LastAppliedTimestamp());
+  }
+
+  replicator = nullptr;
+  ASSERT_NO_THROW(follower_storage->FlipToMaster());
+  EXPECT_TRUE(follower_storage->IsMasterStorage());
+
+  current::time::SetNow(std::chrono::microseconds((N + 1) * 100));
+  {
+    const auto result = follower_storage->ReadWriteTransaction([](MutableFields<storage_t> fields) {
+      fields.user.Add(SimpleUser("last", "flipped"));
+    }).Go();
+    EXPECT_TRUE(WasCommitted(result));
+  }
+  {
+    const auto result = follower_storage->ReadOnlyTransaction([N](ImmutableFields<storage_t> fields) {
+      EXPECT_EQ(N + 1u, fields.user.Size());
+      EXPECT_EQ("flipped", Value(fields.user["last"]).name);
+    }).Go();
+    EXPECT_TRUE(WasCommitted(result));
+  }
+}
+
+TEST(TransactionalStorage, PipelinedFollowingStorageRemainsFollowingIfReplayFails) {
+  current::time::ResetToZero();
+
+  using namespace transactional_storage_test;
+  using storage_t = SimpleStorage<PipelinedStreamStreamPersister>;
+  using transaction_t = typename storage_t::transaction_t;
+  using stream_t = current::stream::Stream<transaction_t, current::persistence::File>;
+
+  const std::string follower_file_name =
+      current::FileSystem::JoinPath(FLAGS_transactional_storage_test_tmpdir, "follower");
+  const auto follower_file_remover = current::FileSystem::ScopedRmFile(follower_file_name);
+
+  auto owned_follower_stream = stream_t::CreateStream(follower_file_name);
+  auto publisher = std::make_unique<current::Borrowed<typename stream_t::publisher_t>>(
+      owned_follower_stream->BecomeFollowingStream());
+  auto follower_storage = storage_t::CreateFollowingStorageAtopExistingStream(owned_follower_stream);
+
+  (*publisher)->PublishUnsafe("{\"index\":0,\"us\":100}\t{\"not\":\"a transaction\"}");
+  publisher = nullptr;
+
+  // The error is surfaced, and the storage keeps following the stream, from the entry that has failed.
+  EXPECT_THROW(follower_storage->FlipToMaster(), TypeSystemParseJSONException);
+  EXPECT_FALSE(follower_storage->IsMasterStorage());
+  EXPECT_THROW(follower_storage->FlipToMaster(), TypeSystemParseJSONException);
+  EXPECT_FALSE(follower_storage->IsMasterStorage());
+  EXPECT_EQ(std::chrono::microseconds(-1), follower_storage->LastAppliedTimestamp());
+}
+
+TEST(TransactionalStorage, ReplayPipelineRethrowsDecodingErrors) {
+  std::vector<int> applied;
+  current::storage::persister::ReplayPipeline<int> pipeline(
+      4u,
+      16u,
+      [](const std::string& raw) -> int {
+        if (raw == "bad") {
+          CURRENT_THROW(current::persistence::MalformedEntryException(raw));
+        }
+        return current::FromString<int>(raw);
+      },
+      [&applied](std::vector<int>& batch) { applied.insert(applied.end(), batch.begin(), batch.end()); });
+
+  for (int i = 0; i < 10; ++i) {
+    pipeline.Push(current::ToString(i));
+  }
+  pipeline.Flush();
+  EXPECT_EQ(10u, applied.size());
+
+  // The error is surfaced on the thread feeding the pipeline, and nothing past the malformed entry is applied.
+  ASSERT_NO_THROW(pipeline.Push("bad"));
+  EXPECT_THROW(pipeline.Flush(), current::persistence::MalformedEntryException);
+  EXPECT_THROW(pipeline.Push("42"), current::persistence::MalformedEntryException);
+  EXPECT_EQ(10u, applied.size());
+}
+
 #ifdef CURRENT_STORAGE_PATCH_SUPPORT
 
 namespace transactional_storage_test {
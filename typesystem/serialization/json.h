@@ -28,6 +28,7 @@ SOFTWARE.
 
 #include "serialization.h"
 
+#include "json/arena.h"
 #include "json/enum.h"
 #include "json/immutable_optional.h"
 #include "json/map.h"
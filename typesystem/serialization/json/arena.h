@@ -0,0 +1,94 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2015 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+          (c) 2016 Maxim Zhurovich <zhurovich@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// `JSONParseArena<T>` holds a batch of objects parsed from JSON, all of which are released at once with `Clear()`.
+// The released objects are not freed, but reused by the next batch: the JSON is parsed into them in place, so that
+// the strings and the vectors within keep their memory, and a batch of similar entries, once the arena has warmed
+// up, is parsed with few heap allocations, if any. Meant for replaying and importing entries in bulk.
+//
+// The references returned by `Parse()` remain valid until `Clear()`.
+
+#ifndef CURRENT_TYPE_SYSTEM_SERIALIZATION_JSON_ARENA_H
+#define CURRENT_TYPE_SYSTEM_SERIALIZATION_JSON_ARENA_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "json.h"
+
+namespace current {
+namespace serialization {
+namespace json {
+
+template <typename T, class J = JSONFormat::Current>
+class JSONParseArena final {
+ public:
+  JSONParseArena() = default;
+  JSONParseArena(const JSONParseArena&) = delete;
+  JSONParseArena& operator=(const JSONParseArena&) = delete;
+
+  // Throws the same exceptions as `ParseJSON()`. On a failure the arena is left as it was.
+  T& Parse(const char* json) {
+    if (size_ == objects_.size()) {
+      objects_.emplace_back(std::make_unique<T>());
+    }
+    T& object = *objects_[size_];
+    ParseJSON<T, J>(json, object);
+    ++size_;
+    return object;
+  }
+
+  T& Parse(const std::string& json) { return Parse(json.c_str()); }
+
+  size_t Size() const { return size_; }
+  bool Empty() const { return size_ == 0u; }
+
+  T& operator[](size_t index) { return *objects_[index]; }
+  const T& operator[](size_t index) const { return *objects_[index]; }
+
+  // Releases all the objects parsed so far, keeping their memory for the next batch.
+  void Clear() { size_ = 0u; }
+
+  // Frees the memory too.
+  void ShrinkToFit() {
+    objects_.resize(size_);
+    objects_.shrink_to_fit();
+  }
+
+ private:
+  std::vector<std::unique_ptr<T>> objects_;
+  size_t size_ = 0u;
+};
+
+}  // namespace current::serialization::json
+}  // namespace current::serialization
+
+using serialization::json::JSONParseArena;
+}  // namespace current
+
+using current::JSONParseArena;
+
+#endif  // CURRENT_TYPE_SYSTEM_SERIALIZATION_JSON_ARENA_H
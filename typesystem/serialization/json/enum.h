@@ -65,6 +65,28 @@ struct DeserializeImpl<json::JSONParser<JSON_FORMAT>, T, std::enable_if_t<std::i
   }
 };
 
+namespace json {
+
+template <class JSON_FORMAT, typename T>
+struct JSONDirectDeserializeImpl<JSON_FORMAT, T, std::enable_if_t<std::is_enum<T>::value>> {
+  static void DoDeserialize(JSONDirectParser<JSON_FORMAT>& parser, T& destination) {
+    const rapidjson::Value& value = parser.Scalar();
+    if (std::numeric_limits<typename std::underlying_type<T>::type>::is_signed) {
+      if (!value.IsInt64()) {
+        parser.Fallback();
+      }
+      destination = static_cast<T>(value.GetInt64());
+    } else {
+      if (!value.IsUint64()) {
+        parser.Fallback();
+      }
+      destination = static_cast<T>(value.GetUint64());
+    }
+  }
+};
+
+}  // namespace current::serialization::json
+
 }  // namespace current::serialization
 }  // namespace current
 
@@ -26,8 +26,11 @@ SOFTWARE.
 #ifndef CURRENT_TYPE_SYSTEM_SERIALIZATION_JSON_JSON_H
 #define CURRENT_TYPE_SYSTEM_SERIALIZATION_JSON_JSON_H
 
+#include <cstring>
+
 #include "exceptions.h"
 #include "rapidjson.h"
+#include "scan.h"
 
 #include "../serialization.h"
 
@@ -37,6 +40,7 @@ SOFTWARE.
 
 #include "../../../bricks/strings/chunk.h"
 #include "../../../bricks/template/pod.h"  // `current::copy_free`.
+#include "../../../bricks/util/singleton.h"
 
 namespace current {
 namespace serialization {
@@ -119,66 +123,194 @@ struct IsJSONSerializableImpl<false, false, false, T> {
   constexpr static bool value = false;
 };
 
-// For RapidJSON value assignments, specifically strings (use `SetString`, not `SetValue`) and `std::chrono::*`.
+// The streaming writer all JSON serialization goes through. There is no intermediate DOM.
+class JSONWriter final : public rapidjson::Writer<rapidjson::StringBuffer> {
+ public:
+  using base_t = rapidjson::Writer<rapidjson::StringBuffer>;
+  using base_t::String;
+
+  explicit JSONWriter(rapidjson::StringBuffer& buffer) : base_t(buffer) {}
+
+  // Writes exactly what `base_t::String()` does, copying the characters between the ones to escape as a whole.
+  bool String(const std::string& value) {
+    Prefix(rapidjson::kStringType);
+    rapidjson::StringBuffer& os = *os_;
+    os.Put('\"');
+    const char* p = value.c_str();
+    const char* const end = p + value.length();
+    while (true) {
+      // The terminating zero of `value` stops the scan.
+      const char* q = FindJSONSpecialCharacter(p);
+      std::memcpy(os.Push(static_cast<size_t>(q - p)), p, static_cast<size_t>(q - p));
+      if (q == end) {
+        break;
+      }
+      WriteEscaped(os, *q);
+      p = q + 1;
+    }
+    os.Put('\"');
+    return EndValue(true);
+  }
+
+ private:
+  static void WriteEscaped(rapidjson::StringBuffer& os, char c) {
+    static const char hex_digits[] = "0123456789ABCDEF";
+    os.Put('\\');
+    switch (c) {
+      case '\"':
+        os.Put('\"');
+        break;
+      case '\\':
+        os.Put('\\');
+        break;
+      case '\b':
+        os.Put('b');
+        break;
+      case '\f':
+        os.Put('f');
+        break;
+      case '\n':
+        os.Put('n');
+        break;
+      case '\r':
+        os.Put('r');
+        break;
+      case '\t':
+        os.Put('t');
+        break;
+      default:
+        os.Put('u');
+        os.Put('0');
+        os.Put('0');
+        os.Put(hex_digits[static_cast<unsigned char>(c) >> 4]);
+        os.Put(hex_digits[static_cast<unsigned char>(c) & 15u]);
+    }
+  }
+};
+
+using json_writer_t = JSONWriter;
+
+// For writing primitive values: numbers and booleans here, strings and `std::chrono::*` in `primitives.h`.
+template <typename T, class ENABLE = void>
+struct JSONValueWriterImpl;
+
+template <>
+struct JSONValueWriterImpl<bool> {
+  static void WriteValue(json_writer_t& writer, bool value) { writer.Bool(value); }
+};
+
+template <typename T>
+struct JSONValueWriterImpl<T, std::enable_if_t<std::is_integral<T>::value && std::is_signed<T>::value>> {
+  static void WriteValue(json_writer_t& writer, T value) { writer.Int64(static_cast<int64_t>(value)); }
+};
+
+template <typename T>
+struct JSONValueWriterImpl<
+    T,
+    std::enable_if_t<std::is_integral<T>::value && !std::is_signed<T>::value && !std::is_same<T, bool>::value>> {
+  static void WriteValue(json_writer_t& writer, T value) { writer.Uint64(static_cast<uint64_t>(value)); }
+};
+
 template <typename T>
-struct JSONValueAssignerImpl {
-  static void AssignValue(rapidjson::Value& destination, current::copy_free<T> value) { destination = value; }
+struct JSONValueWriterImpl<T, std::enable_if_t<std::is_floating_point<T>::value>> {
+  static void WriteValue(json_writer_t& writer, T value) { writer.Double(static_cast<double>(value)); }
 };
 
+// `JSONStringifier` emits the JSON of the object as it is being traversed, into the provided buffer.
+//
+// Object members are written via `MaybeMember()`, which defers writing the key until the value is. This way, the
+// members the value of which ends up absent (ex. a `Variant` or an `Optional` in the `Minimalistic` format),
+// are omitted altogether. Absent values not directly under an object key are written as `null`-s.
 template <class JSON_FORMAT>
 class JSONStringifier final {
  public:
-  JSONStringifier() {
-    // Can't assign in the initializer list, `current_` is the field before `document_`.
-    // And I've confirmed keeping `document_` first results in performance degradation. -- D.K.
-    current_ = &document_;
-  }
-
-  rapidjson::Value& Current() { return *current_; }
-  rapidjson::Document::AllocatorType& Allocator() { return document_.GetAllocator(); }
+  explicit JSONStringifier(rapidjson::StringBuffer& buffer) : writer_(buffer) {}
 
+  // Writes a primitive value.
   template <typename T>
   void operator=(T&& x) {
-    JSONValueAssignerImpl<current::decay<T>>::AssignValue(*current_, std::forward<T>(x));
+    WriteKeyIfPending();
+    JSONValueWriterImpl<current::decay<T>>::WriteValue(writer_, std::forward<T>(x));
+  }
+
+  void operator=(const char* s) {
+    WriteKeyIfPending();
+    writer_.String(s);
   }
 
+  void WriteNull() {
+    WriteKeyIfPending();
+    writer_.Null();
+  }
+
+  void StartObject() {
+    WriteKeyIfPending();
+    writer_.StartObject();
+  }
+  void EndObject() { writer_.EndObject(); }
+
+  void StartArray() {
+    WriteKeyIfPending();
+    writer_.StartArray();
+  }
+  void EndArray() { writer_.EndArray(); }
+
+  // The key for the object member to be written next. The value must follow, and must not be absent.
+  void Key(const char* key) { writer_.Key(key); }
+  void Key(const std::string& key) { writer_.Key(key.c_str(), static_cast<rapidjson::SizeType>(key.length())); }
+
   // Serialize another object, in an inner scope. The object is guaranteed to result in a valid value.
   template <typename T>
-  void Inner(rapidjson::Value* inner_value, T&& x) {
-    std::swap(current_, inner_value);
+  void Inner(T&& x) {
     Serialize(*this, std::forward<T>(x));
-    std::swap(current_, inner_value);
   }
 
-  // Serialize another object, in an inner scope. The object may end up a no-op, which should be ignored.
-  // Example: A `Variant` or `Optional` in the `Minimalistic` format.
-  void MarkAsAbsentValue() { current_ = nullptr; }
+  // Serialize a member of an object, in an inner scope. The value may end up a no-op, which should be ignored.
+  // IMPORTANT: The `key` must outlive the call.
   template <typename T>
-  bool MaybeInner(rapidjson::Value* inner_value, T&& x) {
-    rapidjson::Value* previous = current_;
-    current_ = inner_value;
+  void MaybeMember(const char* key, T&& x) {
+    pending_key_ = key;
     Serialize(*this, std::forward<T>(x));
-    if (current_) {
-      current_ = previous;
-      return true;
+    pending_key_ = nullptr;
+  }
+
+  // Called by the serializers of values that may be absent.
+  void MarkAsAbsentValue() {
+    if (pending_key_) {
+      pending_key_ = nullptr;
     } else {
-      current_ = previous;
-      return false;
+      writer_.Null();
     }
   }
 
-  std::string ResultingJSON() const {
-    rapidjson::StringBuffer string_buffer;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(string_buffer);
-    document_.Accept(writer);
-    return string_buffer.GetString();
+ private:
+  void WriteKeyIfPending() {
+    if (pending_key_) {
+      writer_.Key(pending_key_);
+      pending_key_ = nullptr;
+    }
   }
 
- private:
-  rapidjson::Value* current_;
-  rapidjson::Document document_;
+  json_writer_t writer_;
+  const char* pending_key_ = nullptr;
 };
 
+// `JSON()` reuses the per-thread output buffer, to save on allocations. Nested `JSON()` calls use a local one.
+struct ReusableJSONOutputBuffer final {
+  // Buffers grown above this size are released after use, so that an odd huge object does not pin the memory.
+  constexpr static size_t kMaxRetainedBufferSize = 1024u * 1024u;
+
+  rapidjson::StringBuffer buffer;
+  bool in_use = false;
+};
+
+template <class J, typename T>
+inline void AppendJSONUsingBuffer(rapidjson::StringBuffer& buffer, std::string& output, const T& source) {
+  JSONStringifier<J> json_stringifier(buffer);
+  Serialize(json_stringifier, source);
+  output.append(buffer.GetString(), buffer.GetSize());
+}
+
 enum class JSONVariantStyle : int { Current, Simple, NewtonsoftFSharp };
 
 template <JSONVariantStyle>
@@ -238,16 +370,71 @@ struct JSONPatchMode<JSONPatcher<J>> {
   constexpr static bool value = true;
 };
 
+// The per-thread scratch memory of the JSON parsers: the pool for the DOM, and the reader of the values parsed
+// one by one, see `JSONDirectParser`. The DOM of a typical entry fits into the preallocated buffer, so that parsing
+// it takes no memory allocations. Nested parsers, if any, use their own memory.
+struct ReusableJSONParserMemory final {
+  constexpr static size_t kBufferSizeInWords = 8u * 1024u;  // 64KB.
+
+  uint64_t buffer[kBufferSizeInWords];
+  rapidjson::MemoryPoolAllocator<> allocator;
+  rapidjson::Reader reader;
+  std::string key;
+  std::string value;
+  bool in_use = false;
+  uint64_t values_parsed_via_dom = 0u;
+
+  ReusableJSONParserMemory() : allocator(buffer, sizeof(buffer)) {}
+
+  // The number of JSON documents and values this thread has parsed via the DOM. For the tests to confirm that
+  // the values which should be parsed directly are.
+  static uint64_t ValuesParsedViaDOM() {
+    return ThreadLocalSingleton<ReusableJSONParserMemory>().values_parsed_via_dom;
+  }
+
+  // Returns the memory to use, or `nullptr` if it is taken.
+  static ReusableJSONParserMemory* Acquire() {
+    ReusableJSONParserMemory& memory = ThreadLocalSingleton<ReusableJSONParserMemory>();
+    if (!memory.in_use) {
+      memory.in_use = true;
+      return &memory;
+    } else {
+      return nullptr;
+    }
+  }
+
+  // Frees the chunks allocated past the preallocated buffer, so that a large document does not pin the memory.
+  static void Release(ReusableJSONParserMemory* memory) {
+    if (memory) {
+      memory->allocator.Clear();
+      memory->in_use = false;
+    }
+  }
+};
+
 template <class JSON_FORMAT>
 class JSONParser final {
  public:
-  explicit JSONParser(const char* json) {
+  explicit JSONParser(const char* json)
+      : memory_(ReusableJSONParserMemory::Acquire()), document_(memory_ ? &memory_->allocator : nullptr) {
+    ++ThreadLocalSingleton<ReusableJSONParserMemory>().values_parsed_via_dom;
     if (document_.Parse(json).HasParseError()) {
+      ReusableJSONParserMemory::Release(memory_);
       CURRENT_THROW(InvalidJSONException(json));
     }
     current_ = &document_;
+    path_.reserve(kPathInitialCapacity);
   }
 
+  // Deserializes the `value` parsed elsewhere, or the missing one if `value` is `nullptr`. The memory is borrowed.
+  JSONParser(rapidjson::Value* value, rapidjson::MemoryPoolAllocator<>& allocator)
+      : current_(value), memory_(nullptr), document_(&allocator) {}
+
+  ~JSONParser() { ReusableJSONParserMemory::Release(memory_); }
+
+  JSONParser(const JSONParser&) = delete;
+  JSONParser& operator=(const JSONParser&) = delete;
+
   operator bool() const { return current_ != nullptr; }
   rapidjson::Value& Current() { return *current_; }
   rapidjson::Value* CurrentAsPtr() { return current_; }
@@ -318,22 +505,344 @@ class JSONParser final {
   }
 
  private:
+  // Enough for the paths of reasonably nested objects, so that the path is not reallocated while parsing.
+  constexpr static size_t kPathInitialCapacity = 32u;
+
   rapidjson::Value* current_;
   std::vector<CharPtrOrInt> path_;
+  ReusableJSONParserMemory* const memory_;
   rapidjson::Document document_;
 };
 
+template <class JSON_FORMAT>
+class JSONDirectParser;
+
+// Parses the value of type `T` with `JSONDirectParser`. Specialized next to `DeserializeImpl` for the types that are
+// parsed directly; the rest are parsed via the DOM, which is built just for their own JSON values.
+template <class JSON_FORMAT, typename T, typename ENABLE = void>
+struct JSONDirectDeserializeImpl {
+  static void DoDeserialize(JSONDirectParser<JSON_FORMAT>& parser, T& destination) {
+    parser.DeserializeViaDOM(destination);
+  }
+};
+
+// Thrown by `JSONDirectParser` when the value is not what it expects. The value, and only it, is then parsed again
+// via the DOM, so that the result is the same as before.
+struct JSONDirectParserFallback final {};
+
+// Thrown by `JSONDirectParser` when the input can not be parsed even via the DOM. The whole document is then parsed
+// again via the DOM, so that the exception reported to the user, with the path and the offending value, is the same
+// as before.
+struct JSONDirectParserDocumentFallback final {};
+
+// Parses JSON straight into the destination object, with no DOM. The parser walks the objects and arrays itself,
+// mapping member names to fields via `JSONStructFieldsIndex`, and reads each scalar value using `rapidjson::Reader`,
+// so that the numbers and strings are treated exactly as they are in the DOM.
+template <class JSON_FORMAT>
+class JSONDirectParser final {
+ public:
+  // Calls `f(parser)` to parse the value. Returns `false` if `json` could not be parsed directly, and the DOM should
+  // be used instead.
+  template <typename F>
+  static bool Parse(const char* json, F&& f) {
+    ReusableJSONParserMemory* memory = ReusableJSONParserMemory::Acquire();
+    if (!memory) {
+      return false;
+    }
+    bool ok = true;
+    try {
+      JSONDirectParser parser(json, *memory);
+      f(parser);
+      if (parser.Peek() != '\0') {
+        Fallback();
+      }
+    } catch (const JSONDirectParserFallback&) {
+      ok = false;
+    } catch (const JSONDirectParserDocumentFallback&) {
+      ok = false;
+    } catch (const TypeSystemParseJSONException&) {
+      ok = false;
+    } catch (UninitializedVariant) {
+      ok = false;
+    }
+    ReusableJSONParserMemory::Release(memory);
+    return ok;
+  }
+
+  // Parses the next value into `destination`. Should the value not be what the direct parser expects, it is parsed
+  // again via the DOM, while the values around it are still parsed directly.
+  template <typename T>
+  void Inner(T& destination) {
+    const char* begin = stream_.src_;
+    try {
+      JSONDirectDeserializeImpl<JSON_FORMAT, T>::DoDeserialize(*this, destination);
+    } catch (const JSONDirectParserFallback&) {
+      stream_.src_ = begin;
+      DeserializeViaDOM(destination);
+    }
+  }
+
+  [[noreturn]] static void Fallback() { throw JSONDirectParserFallback(); }
+
+  // Returns the next non-whitespace character, without consuming it.
+  char Peek() {
+    const char c = stream_.Peek();
+    if (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+      // Compact JSON has no whitespace at all, so only call into RapidJSON when there is some to skip.
+      rapidjson::SkipWhitespace(stream_);
+      return stream_.Peek();
+    } else {
+      return c;
+    }
+  }
+
+  // Consumes `null`, if it is the next value.
+  bool TryNull() {
+    if (Peek() == 'n') {
+      if (!Scalar().IsNull()) {
+        Fallback();
+      }
+      return true;
+    } else {
+      return false;
+    }
+  }
+
+  // Reads a number, `true`, `false`, or `null`, into the DOM value, which is only valid until the next call.
+  const rapidjson::Value& Scalar() {
+    ScalarHandler handler(scalar_, nullptr);
+    ReadScalar(handler);
+    if (handler.is_string) {
+      Fallback();
+    }
+    return scalar_;
+  }
+
+  void String(std::string& destination) {
+    if (Peek() == '\"') {
+      const char* p = stream_.src_ + 1;
+      destination.clear();
+      while (true) {
+        const char* q = FindJSONSpecialCharacter(p);
+        destination.append(p, q);
+        if (*q == '\"') {
+          stream_.src_ = q + 1;
+          return;
+        }
+        const char unescaped = (*q == '\\') ? Unescape(q[1]) : '\0';
+        if (!unescaped) {
+          break;
+        }
+        destination += unescaped;
+        p = q + 2;
+      }
+    }
+    // The `\uXXXX` characters, the malformed strings, and the non-strings are left to RapidJSON.
+    ScalarHandler handler(scalar_, &destination);
+    ReadScalar(handler);
+    if (!handler.is_string) {
+      Fallback();
+    }
+  }
+
+  // Reads a string into the scratch memory, which is only valid until the next call.
+  const std::string& String() {
+    String(memory_.value);
+    return memory_.value;
+  }
+
+  // Calls `f(key, length)` for each member of the object, which must consume its value. The key is only valid until
+  // the value is parsed.
+  template <typename F>
+  void Object(F&& f) {
+    Expect('{');
+    if (!TryConsume('}')) {
+      do {
+        if (Peek() != '"') {
+          Fallback();
+        }
+        String(memory_.key);
+        Expect(':');
+        f(memory_.key.c_str(), memory_.key.length());
+      } while (TryConsume(','));
+      Expect('}');
+    }
+  }
+
+  // Calls `f()` for each element of the array, which must consume it.
+  template <typename F>
+  void Array(F&& f) {
+    Expect('[');
+    if (!TryConsume(']')) {
+      do {
+        f();
+      } while (TryConsume(','));
+      Expect(']');
+    }
+  }
+
+  void SkipValue() {
+    rapidjson::BaseReaderHandler<> handler;
+    if (memory_.reader.Parse<rapidjson::kParseStopWhenDoneFlag>(stream_, handler).IsError()) {
+      Fallback();
+    }
+  }
+
+  // For the types not parsed directly: builds the DOM of the next value only, and deserializes it.
+  template <typename T>
+  void DeserializeViaDOM(T& destination) {
+    ++memory_.values_parsed_via_dom;
+    rapidjson::Document document(&memory_.allocator);
+    if (document.ParseStream<rapidjson::kParseStopWhenDoneFlag>(stream_).HasParseError()) {
+      throw JSONDirectParserDocumentFallback();
+    }
+    JSONParser<JSON_FORMAT> json_parser(&document, memory_.allocator);
+    Deserialize(json_parser, destination);
+  }
+
+  // For the fields missing from the input, as only the DOM-based logic knows which ones may be missing.
+  template <typename T>
+  void DeserializeMissingViaDOM(T& destination) {
+    JSONParser<JSON_FORMAT> json_parser(nullptr, memory_.allocator);
+    Deserialize(json_parser, destination);
+  }
+
+ private:
+  struct ScalarHandler : rapidjson::BaseReaderHandler<rapidjson::UTF8<>, ScalarHandler> {
+    rapidjson::Value& value;
+    std::string* string;
+    bool is_string = false;
+
+    ScalarHandler(rapidjson::Value& value, std::string* string) : value(value), string(string) {}
+
+    bool Default() { return false; }  // Objects and arrays are not scalars.
+    bool Null() {
+      value.SetNull();
+      return true;
+    }
+    bool Bool(bool b) {
+      value.SetBool(b);
+      return true;
+    }
+    bool Int(int i) {
+      value.SetInt(i);
+      return true;
+    }
+    bool Uint(unsigned u) {
+      value.SetUint(u);
+      return true;
+    }
+    bool Int64(int64_t i) {
+      value.SetInt64(i);
+      return true;
+    }
+    bool Uint64(uint64_t u) {
+      value.SetUint64(u);
+      return true;
+    }
+    bool Double(double d) {
+      value.SetDouble(d);
+      return true;
+    }
+    bool String(const char* s, rapidjson::SizeType length, bool) {
+      if (string) {
+        string->assign(s, length);
+      }
+      is_string = true;
+      return true;
+    }
+  };
+
+  JSONDirectParser(const char* json, ReusableJSONParserMemory& memory) : stream_(json), memory_(memory) {}
+
+  static char Unescape(char c) {
+    switch (c) {
+      case '\"':
+      case '\\':
+      case '/':
+        return c;
+      case 'b':
+        return '\b';
+      case 'f':
+        return '\f';
+      case 'n':
+        return '\n';
+      case 'r':
+        return '\r';
+      case 't':
+        return '\t';
+      default:
+        return '\0';
+    }
+  }
+
+  void ReadScalar(ScalarHandler& handler) {
+    if (memory_.reader.Parse<rapidjson::kParseStopWhenDoneFlag>(stream_, handler).IsError()) {
+      Fallback();
+    }
+  }
+
+  bool TryConsume(char c) {
+    if (Peek() == c) {
+      stream_.Take();
+      return true;
+    } else {
+      return false;
+    }
+  }
+
+  void Expect(char c) {
+    if (!TryConsume(c)) {
+      Fallback();
+    }
+  }
+
+  rapidjson::StringStream stream_;
+  ReusableJSONParserMemory& memory_;
+  rapidjson::Value scalar_;
+};
+
 template <class J, typename T>
 void ParseJSONViaRapidJSON(const char* json, T& destination) {
+  // Patching keeps the fields missing from the input, and is left to the DOM.
+  if (!JSONPatchMode<J>::value &&
+      JSONDirectParser<J>::Parse(json, [&destination](JSONDirectParser<J>& parser) { parser.Inner(destination); })) {
+    return;
+  }
   JSONParser<J> json_parser(json);
   Deserialize(json_parser, destination);
 }
 
+// Appends the JSON of `source` to `output`. Useful to build the payload in place, or to reuse the string.
+template <class J = JSONFormat::Current, typename T>
+inline void AppendJSON(std::string& output, const T& source) {
+  ReusableJSONOutputBuffer& reusable = ThreadLocalSingleton<ReusableJSONOutputBuffer>();
+  if (!reusable.in_use) {
+    struct Lease final {
+      ReusableJSONOutputBuffer& reusable;
+      explicit Lease(ReusableJSONOutputBuffer& reusable) : reusable(reusable) { reusable.in_use = true; }
+      ~Lease() {
+        if (reusable.buffer.GetSize() > ReusableJSONOutputBuffer::kMaxRetainedBufferSize) {
+          reusable.buffer.Clear();
+          reusable.buffer.ShrinkToFit();
+        } else {
+          reusable.buffer.Clear();
+        }
+        reusable.in_use = false;
+      }
+    } lease(reusable);
+    AppendJSONUsingBuffer<J>(reusable.buffer, output, source);
+  } else {
+    rapidjson::StringBuffer buffer;
+    AppendJSONUsingBuffer<J>(buffer, output, source);
+  }
+}
+
 template <class J = JSONFormat::Current, typename T>
 inline std::string JSON(const T& source) {
-  JSONStringifier<J> json_stringifier;
-  Serialize(json_stringifier, source);
-  return json_stringifier.ResultingJSON();
+  std::string result;
+  AppendJSON<J>(result, source);
+  return result;
 }
 
 template <class J = JSONFormat::Current>
@@ -425,6 +934,7 @@ inline Optional<T> TryParseJSON(const strings::Chunk& source) {
 
 // Keep top-level symbols both in `current::` and in global namespace.
 using serialization::json::JSON;
+using serialization::json::AppendJSON;
 using serialization::json::ParseJSON;
 using serialization::json::TryParseJSON;
 using serialization::json::PatchObjectWithJSON;
@@ -436,6 +946,7 @@ using serialization::json::JSONUninitializedVariantObjectException;
 }  // namespace current
 
 using current::JSON;
+using current::AppendJSON;
 using current::ParseJSON;
 using current::TryParseJSON;
 using current::PatchObjectWithJSON;
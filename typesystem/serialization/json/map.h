@@ -39,18 +39,14 @@ namespace serialization {
 template <class JSON_FORMAT, typename TK, typename TV, typename TC, typename TA>
 struct SerializeImpl<json::JSONStringifier<JSON_FORMAT>, std::map<TK, TV, TC, TA>> {
   static void DoSerialize(json::JSONStringifier<JSON_FORMAT>& json_stringifier, const std::map<TK, TV, TC, TA>& value) {
-    json_stringifier.Current().SetArray();
+    json_stringifier.StartArray();
     for (const auto& element : value) {
-      rapidjson::Value key_value_as_array;
-      key_value_as_array.SetArray();
-      rapidjson::Value populated_key;
-      rapidjson::Value populated_value;
-      json_stringifier.Inner(&populated_key, element.first);
-      json_stringifier.Inner(&populated_value, element.second);
-      key_value_as_array.PushBack(std::move(populated_key.Move()), json_stringifier.Allocator());
-      key_value_as_array.PushBack(std::move(populated_value.Move()), json_stringifier.Allocator());
-      json_stringifier.Current().PushBack(std::move(key_value_as_array.Move()), json_stringifier.Allocator());
+      json_stringifier.StartArray();
+      json_stringifier.Inner(element.first);
+      json_stringifier.Inner(element.second);
+      json_stringifier.EndArray();
     }
+    json_stringifier.EndArray();
   }
 };
 
@@ -58,13 +54,12 @@ template <class JSON_FORMAT, typename TV, typename TC, typename TA>
 struct SerializeImpl<json::JSONStringifier<JSON_FORMAT>, std::map<std::string, TV, TC, TA>> {
   static void DoSerialize(json::JSONStringifier<JSON_FORMAT>& json_stringifier,
                           const std::map<std::string, TV, TC, TA>& value) {
-    json_stringifier.Current().SetObject();
+    json_stringifier.StartObject();
     for (const auto& element : value) {
-      rapidjson::Value populated_value;
-      json_stringifier.Inner(&populated_value, element.second);
-      json_stringifier.Current().AddMember(
-          rapidjson::StringRef(element.first), std::move(populated_value.Move()), json_stringifier.Allocator());
+      json_stringifier.Key(element.first);
+      json_stringifier.Inner(element.second);
     }
+    json_stringifier.EndObject();
   }
 };
 
@@ -121,6 +116,23 @@ struct IsJSONSerializable<std::map<K, V, CMP, ALLOC>> {
 };
 }  // namespace json
 
+namespace json {
+
+template <class JSON_FORMAT, typename TV, typename TC, typename TA>
+struct JSONDirectDeserializeImpl<JSON_FORMAT, std::map<std::string, TV, TC, TA>> {
+  static void DoDeserialize(JSONDirectParser<JSON_FORMAT>& parser, std::map<std::string, TV, TC, TA>& destination) {
+    destination.clear();
+    parser.Object([&parser, &destination](const char* key, size_t length) {
+      std::string k(key, length);
+      TV v;
+      parser.Inner(v);
+      destination.emplace(std::move(k), std::move(v));
+    });
+  }
+};
+
+}  // namespace current::serialization::json
+
 }  // namespace current::serialization
 }  // namespace current
 
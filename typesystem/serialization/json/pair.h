@@ -36,13 +36,10 @@ namespace serialization {
 template <class JSON_FORMAT, typename TF, typename TS>
 struct SerializeImpl<json::JSONStringifier<JSON_FORMAT>, std::pair<TF, TS>> {
   static void DoSerialize(json::JSONStringifier<JSON_FORMAT>& json_stringifier, const std::pair<TF, TS>& value) {
-    rapidjson::Value first_value;
-    rapidjson::Value second_value;
-    json_stringifier.Inner(&first_value, value.first);
-    json_stringifier.Inner(&second_value, value.second);
-    json_stringifier.Current().SetArray();
-    json_stringifier.Current().PushBack(std::move(first_value.Move()), json_stringifier.Allocator());
-    json_stringifier.Current().PushBack(std::move(second_value.Move()), json_stringifier.Allocator());
+    json_stringifier.StartArray();
+    json_stringifier.Inner(value.first);
+    json_stringifier.Inner(value.second);
+    json_stringifier.EndArray();
   }
 };
 
@@ -50,13 +47,12 @@ template <typename TF, typename TS>
 struct SerializeImpl<json::JSONStringifier<json::JSONFormat::NewtonsoftFSharp>, std::pair<TF, TS>> {
   static void DoSerialize(json::JSONStringifier<json::JSONFormat::NewtonsoftFSharp>& json_stringifier,
                           const std::pair<TF, TS>& value) {
-    rapidjson::Value first_value;
-    rapidjson::Value second_value;
-    json_stringifier.Inner(&first_value, value.first);
-    json_stringifier.Inner(&second_value, value.second);
-    json_stringifier.Current().SetObject();
-    json_stringifier.Current().AddMember("Item1", std::move(first_value.Move()), json_stringifier.Allocator());
-    json_stringifier.Current().AddMember("Item2", std::move(second_value.Move()), json_stringifier.Allocator());
+    json_stringifier.StartObject();
+    json_stringifier.Key("Item1");
+    json_stringifier.Inner(value.first);
+    json_stringifier.Key("Item2");
+    json_stringifier.Inner(value.second);
+    json_stringifier.EndObject();
   }
 };
 
@@ -36,24 +36,20 @@ namespace serialization {
 
 namespace json {
 template <>
-struct JSONValueAssignerImpl<std::string> {
-  static void AssignValue(rapidjson::Value& destination, const std::string& value) {
-    destination = rapidjson::StringRef(value);
+struct JSONValueWriterImpl<std::string> {
+  static void WriteValue(json_writer_t& writer, const std::string& value) {
+    writer.String(value);
   }
 };
 
 template <>
-struct JSONValueAssignerImpl<std::chrono::microseconds> {
-  static void AssignValue(rapidjson::Value& destination, std::chrono::microseconds value) {
-    destination.SetInt64(value.count());
-  }
+struct JSONValueWriterImpl<std::chrono::microseconds> {
+  static void WriteValue(json_writer_t& writer, std::chrono::microseconds value) { writer.Int64(value.count()); }
 };
 
 template <>
-struct JSONValueAssignerImpl<std::chrono::milliseconds> {
-  static void AssignValue(rapidjson::Value& destination, std::chrono::milliseconds value) {
-    destination.SetInt64(value.count());
-  }
+struct JSONValueWriterImpl<std::chrono::milliseconds> {
+  static void WriteValue(json_writer_t& writer, std::chrono::milliseconds value) { writer.Int64(value.count()); }
 };
 }  // namespace curent::serialization::json
 
@@ -175,6 +171,83 @@ struct DeserializeImpl<json::JSONParser<JSON_FORMAT>, std::chrono::microseconds>
   }
 };
 
+namespace json {
+
+template <class JSON_FORMAT, typename T>
+struct JSONDirectDeserializeImpl<JSON_FORMAT,
+                                 T,
+                                 std::enable_if_t<std::numeric_limits<T>::is_integer &&
+                                                  !std::numeric_limits<T>::is_signed && !std::is_same<T, bool>::value>> {
+  static void DoDeserialize(JSONDirectParser<JSON_FORMAT>& parser, T& destination) {
+    const rapidjson::Value& value = parser.Scalar();
+    if (!value.IsUint64()) {
+      parser.Fallback();
+    }
+    destination = static_cast<T>(value.GetUint64());
+  }
+};
+
+template <class JSON_FORMAT, typename T>
+struct JSONDirectDeserializeImpl<JSON_FORMAT,
+                                 T,
+                                 std::enable_if_t<std::numeric_limits<T>::is_integer && std::numeric_limits<T>::is_signed>> {
+  static void DoDeserialize(JSONDirectParser<JSON_FORMAT>& parser, T& destination) {
+    const rapidjson::Value& value = parser.Scalar();
+    if (!value.IsInt64()) {
+      parser.Fallback();
+    }
+    destination = static_cast<T>(value.GetInt64());
+  }
+};
+
+template <class JSON_FORMAT, typename T>
+struct JSONDirectDeserializeImpl<JSON_FORMAT,
+                                 T,
+                                 std::enable_if_t<std::is_same<T, float>::value || std::is_same<T, double>::value>> {
+  static void DoDeserialize(JSONDirectParser<JSON_FORMAT>& parser, T& destination) {
+    const rapidjson::Value& value = parser.Scalar();
+    if (!value.IsNumber()) {
+      parser.Fallback();
+    }
+    destination = static_cast<T>(value.GetDouble());
+  }
+};
+
+template <class JSON_FORMAT>
+struct JSONDirectDeserializeImpl<JSON_FORMAT, std::string> {
+  static void DoDeserialize(JSONDirectParser<JSON_FORMAT>& parser, std::string& destination) {
+    parser.String(destination);
+  }
+};
+
+template <class JSON_FORMAT>
+struct JSONDirectDeserializeImpl<JSON_FORMAT, bool> {
+  static void DoDeserialize(JSONDirectParser<JSON_FORMAT>& parser, bool& destination) {
+    const rapidjson::Value& value = parser.Scalar();
+    if (!value.IsBool()) {
+      parser.Fallback();
+    }
+    destination = value.GetBool();
+  }
+};
+
+template <class JSON_FORMAT, typename T>
+struct JSONDirectDeserializeImpl<
+    JSON_FORMAT,
+    T,
+    std::enable_if_t<std::is_same<T, std::chrono::milliseconds>::value ||
+                     std::is_same<T, std::chrono::microseconds>::value>> {
+  static void DoDeserialize(JSONDirectParser<JSON_FORMAT>& parser, T& destination) {
+    const rapidjson::Value& value = parser.Scalar();
+    if (!value.IsInt64()) {
+      parser.Fallback();
+    }
+    destination = T(value.GetInt64());
+  }
+};
+
+}  // namespace current::serialization::json
+
 }  // namespace current::serialization
 }  // namespace current
 
@@ -0,0 +1,174 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2015 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+          (c) 2016 Maxim Zhurovich <zhurovich@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// `FindJSONSpecialCharacter()` scans a string for the first character which can not be copied into a JSON string
+// as is: the double quote, the backslash, or a control one. Both the serializer and the parser go through it, so that
+// the strings free of such characters, which is most of them, are copied as a whole instead of char by char.
+//
+// Long strings are scanned 32 or 16 bytes at a time, using AVX2 if the CPU has it, or SSE2. Define
+// `CURRENT_JSON_NO_SIMD` to only use the scalar version. It is also used under AddressSanitizer and ThreadSanitizer,
+// which rightfully flag the vectorized loads reading past the end of the string.
+
+#ifndef CURRENT_TYPE_SYSTEM_SERIALIZATION_JSON_SCAN_H
+#define CURRENT_TYPE_SYSTEM_SERIALIZATION_JSON_SCAN_H
+
+#include "../../../port.h"
+
+#include <cstdint>
+
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#define CURRENT_JSON_NO_SIMD
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer)
+#define CURRENT_JSON_NO_SIMD
+#endif
+#endif
+
+#if !defined(CURRENT_JSON_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__))
+#define CURRENT_JSON_SIMD_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) && !defined(__INTEL_COMPILER)
+#define CURRENT_JSON_SIMD_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+namespace current {
+namespace serialization {
+namespace json {
+namespace scan {
+
+inline bool IsSpecialCharacter(char c) {
+  return c == '\"' || c == '\\' || static_cast<unsigned char>(c) < 0x20u;
+}
+
+inline const char* FindSpecialCharacterScalar(const char* p) {
+  while (!IsSpecialCharacter(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+#ifdef CURRENT_JSON_SIMD_SSE2
+
+// The index of the lowest set bit of the non-zero `mask`.
+inline unsigned int LowestSetBit(unsigned int mask) {
+#ifdef __GNUC__
+  return static_cast<unsigned int>(__builtin_ctz(mask));
+#else
+  unsigned int result = 0u;
+  while (!(mask & 1u)) {
+    mask >>= 1;
+    ++result;
+  }
+  return result;
+#endif
+}
+
+// The loads are aligned, so that they never cross a page boundary, and reading past the terminating zero is safe.
+inline const char* FindSpecialCharacterSSE2(const char* p) {
+  while (reinterpret_cast<uintptr_t>(p) & 15u) {
+    if (IsSpecialCharacter(*p)) {
+      return p;
+    }
+    ++p;
+  }
+  const __m128i quote = _mm_set1_epi8('\"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i control = _mm_set1_epi8(0x1f);
+  for (;; p += 16) {
+    const __m128i s = _mm_load_si128(reinterpret_cast<const __m128i*>(p));
+    // `c < 0x20` <=> `max(c, 0x1f) == 0x1f`, unsigned.
+    const __m128i x = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(s, quote), _mm_cmpeq_epi8(s, backslash)),
+                                   _mm_cmpeq_epi8(_mm_max_epu8(s, control), control));
+    const int mask = _mm_movemask_epi8(x);
+    if (mask) {
+      return p + LowestSetBit(static_cast<unsigned int>(mask));
+    }
+  }
+}
+
+#endif  // CURRENT_JSON_SIMD_SSE2
+
+#ifdef CURRENT_JSON_SIMD_AVX2
+
+__attribute__((target("avx2"))) inline const char* FindSpecialCharacterAVX2(const char* p) {
+  while (reinterpret_cast<uintptr_t>(p) & 31u) {
+    if (IsSpecialCharacter(*p)) {
+      return p;
+    }
+    ++p;
+  }
+  const __m256i quote = _mm256_set1_epi8('\"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i control = _mm256_set1_epi8(0x1f);
+  for (;; p += 32) {
+    const __m256i s = _mm256_load_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i x = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(s, quote), _mm256_cmpeq_epi8(s, backslash)),
+                                      _mm256_cmpeq_epi8(_mm256_max_epu8(s, control), control));
+    const unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(x));
+    if (mask) {
+      return p + LowestSetBit(mask);
+    }
+  }
+}
+
+#endif  // CURRENT_JSON_SIMD_AVX2
+
+using find_special_character_t = const char* (*)(const char*);
+
+inline find_special_character_t SelectFindSpecialCharacter() {
+#ifdef CURRENT_JSON_SIMD_AVX2
+  if (__builtin_cpu_supports("avx2")) {
+    return FindSpecialCharacterAVX2;
+  }
+#endif
+#ifdef CURRENT_JSON_SIMD_SSE2
+  return FindSpecialCharacterSSE2;
+#else
+  return FindSpecialCharacterScalar;
+#endif
+}
+
+}  // namespace current::serialization::json::scan
+
+// Returns the pointer to the first double quote, backslash, or control character at or after `p`.
+// The string must be zero-terminated; the terminating zero counts as a control character.
+inline const char* FindJSONSpecialCharacter(const char* p) {
+  // Short strings are not worth the call.
+  for (const char* end = p + 16; p != end; ++p) {
+    if (scan::IsSpecialCharacter(*p)) {
+      return p;
+    }
+  }
+  static const scan::find_special_character_t impl = scan::SelectFindSpecialCharacter();
+  return impl(p);
+}
+
+}  // namespace current::serialization::json
+}  // namespace current::serialization
+}  // namespace current
+
+#endif  // CURRENT_TYPE_SYSTEM_SERIALIZATION_JSON_SCAN_H
@@ -26,7 +26,11 @@ SOFTWARE.
 #ifndef CURRENT_TYPE_SYSTEM_SERIALIZATION_JSON_STRUCT_H
 #define CURRENT_TYPE_SYSTEM_SERIALIZATION_JSON_STRUCT_H
 
+#include <array>
+#include <cstring>
+#include <string>
 #include <type_traits>
+#include <utility>
 
 #include "json.h"
 
@@ -44,15 +48,10 @@ class JSONStructFieldsSerializer {
   explicit JSONStructFieldsSerializer(json::JSONStringifier<JSON_FORMAT>& json_stringifier)
       : json_stringifier_(json_stringifier) {}
 
-  // IMPORTANT: Must take name as `const char* name`, as `const std::string& name`
-  // would fail memory-allocation-wise due to over-smartness of RapidJSON.
+  // IMPORTANT: Must take name as `const char* name`, as the stringifier holds on to it until the value is written.
   template <typename U>
   void operator()(const char* name, const U& source) const {
-    rapidjson::Value placeholder;
-    if (json_stringifier_.MaybeInner(&placeholder, source)) {
-      json_stringifier_.Current().AddMember(
-          rapidjson::StringRef(name), std::move(placeholder.Move()), json_stringifier_.Allocator());
-    }
+    json_stringifier_.MaybeMember(name, source);
   }
 
  private:
@@ -77,6 +76,39 @@ struct SerializeStructImpl<JSON_FORMAT, CurrentStruct> {
   static void SerializeStruct(JSONStructFieldsSerializer<JSON_FORMAT>&, const CurrentStruct&) {}
 };
 
+// Maps a JSON member name to the index of the field of `T`, not including the ones of its super, using the
+// compile-time table of field names. The search starts at `hint`, the field expected next: the members of the objects
+// serialized by `JSON()` come in the order of the fields, so that the first name compared is usually the one.
+template <typename T>
+struct JSONStructFieldsIndex final {
+  using names_t = current::reflection::FieldNames<T>;
+
+  constexpr static size_t kNotFound = static_cast<size_t>(-1);
+
+  static size_t Find(const char* name, size_t length, size_t hint = 0u) {
+    size_t i = hint < names_t::size ? hint : 0u;
+    for (size_t n = 0u; n < names_t::size; ++n) {
+      if (names_t::lengths[i] == length && !std::memcmp(names_t::names[i], name, length)) {
+        return i;
+      }
+      if (++i == names_t::size) {
+        i = 0u;
+      }
+    }
+    return kNotFound;
+  }
+
+  // Whether `T` has the field named `name`. For the compile-time checks.
+  constexpr static bool Declares(const char* name, size_t i = 0u) {
+    return i < names_t::size && (SameName(names_t::names[i], name) || Declares(name, i + 1u));
+  }
+
+ private:
+  constexpr static bool SameName(const char* lhs, const char* rhs) {
+    return *lhs == *rhs && (!*lhs || SameName(lhs + 1, rhs + 1));
+  }
+};
+
 }  // namespace current::serialization::json
 
 template <class JSON_FORMAT, typename T>
@@ -84,9 +116,10 @@ struct SerializeImpl<json::JSONStringifier<JSON_FORMAT>,
                      T,
                      std::enable_if_t<IS_CURRENT_STRUCT(T) && !std::is_same<T, CurrentStruct>::value>> {
   static void DoSerialize(json::JSONStringifier<JSON_FORMAT>& json_stringifier, const T& value) {
-    json_stringifier.Current().SetObject();
+    json_stringifier.StartObject();
     json::JSONStructFieldsSerializer<JSON_FORMAT> visitor(json_stringifier);
     json::SerializeStructImpl<JSON_FORMAT, T>::SerializeStruct(visitor, value);
+    json_stringifier.EndObject();
   }
 };
 
@@ -99,42 +132,316 @@ template <class JSON_FORMAT, typename T>
 struct DeserializeImpl<json::JSONParser<JSON_FORMAT>,
                        T,
                        std::enable_if_t<IS_CURRENT_STRUCT(T) && !std::is_same<T, CurrentStruct>::value>> {
+  using decayed_t = current::decay<T>;
+  using super_t = current::reflection::SuperType<decayed_t>;
+  constexpr static size_t kFieldsCount = static_cast<size_t>(current::reflection::FieldCounter<decayed_t>::value);
+  using members_t = std::array<rapidjson::Value*, kFieldsCount>;
+
+  // The fields are visited in the order of their indexes, so the JSON member of each has been found beforehand.
   class DeserializeSingleField {
    public:
-    explicit DeserializeSingleField(json::JSONParser<JSON_FORMAT>& json_parser) : json_parser_(json_parser) {}
+    DeserializeSingleField(json::JSONParser<JSON_FORMAT>& json_parser, const members_t& members)
+        : json_parser_(json_parser), members_(members) {}
 
-    // IMPORTANT: Must take `name` as `const char* name`, since `const std::string& name`
-    // would fail memory-allocation-wise due to over-smartness of RapidJSON.
+    // IMPORTANT: Must take `name` as `const char* name`, as it is kept in the path until the field is parsed.
     template <typename U>
-    void operator()(const char* name, U& value) const {
-      if (json_parser_.Current().HasMember(name)) {
-        json_parser_.Inner(&json_parser_.Current()[name], value, ".", name);
-      } else {
-        json_parser_.Inner(nullptr, value, ".", name);
-      }
+    void operator()(const char* name, U& value) {
+      json_parser_.Inner(members_[index_++], value, ".", name);
     }
 
    private:
     json::JSONParser<JSON_FORMAT>& json_parser_;
+    const members_t& members_;
+    size_t index_ = 0u;
   };
 
   static void DoDeserialize(json::JSONParser<JSON_FORMAT>& json_parser, T& destination) {
-    using decayed_t = current::decay<T>;
-    using super_t = current::reflection::SuperType<decayed_t>;
-
     if (json_parser && json_parser.Current().IsObject()) {
       if (!std::is_same<super_t, CurrentStruct>::value) {
         Deserialize(json_parser, static_cast<super_t&>(destination));
       }
+      // One pass over the members of the JSON object, instead of one lookup by name per field.
+      // Should a member be present more than once, the first one is used.
+      members_t members;
+      members.fill(nullptr);
+      rapidjson::Value& object = json_parser.Current();
+      size_t hint = 0u;
+      for (auto it = object.MemberBegin(); it != object.MemberEnd(); ++it) {
+        const size_t index =
+            json::JSONStructFieldsIndex<decayed_t>::Find(it->name.GetString(), it->name.GetStringLength(), hint);
+        if (index != json::JSONStructFieldsIndex<decayed_t>::kNotFound) {
+          if (!members[index]) {
+            members[index] = &it->value;
+          }
+          hint = index + 1u;
+        }
+      }
+      DeserializeSingleField visitor(json_parser, members);
       current::reflection::VisitAllFields<decayed_t, current::reflection::FieldNameAndMutableValue>::WithObject(
-          destination, DeserializeSingleField(json_parser));
+          destination, visitor);
     } else if (!json::JSONPatchMode<JSON_FORMAT>::value || (json_parser && !json_parser.Current().IsObject())) {
       CURRENT_THROW(JSONSchemaException("object", json_parser));  // LCOV_EXCL_LINE
     }
   }
 };
 
+namespace json {
+
+// Parses the fields of `T` declared by `T` itself, delegating the ones of its super to `JSONDirectStructFields` of
+// the super. The fields are numbered throughout the hierarchy, those of the supers first, to track the missing ones,
+// and to only parse the requested ones, if `requested` is not `nullptr`; see `ParseJSONFields()`.
+template <class JSON_FORMAT, typename T>
+struct JSONDirectStructFields {
+  using super_t = current::reflection::SuperType<T>;
+  using super_fields_t = JSONDirectStructFields<JSON_FORMAT, super_t>;
+  using field_parser_t = void (*)(JSONDirectParser<JSON_FORMAT>&, T&);
+  constexpr static size_t kOwnFieldsCount = static_cast<size_t>(current::reflection::FieldCounter<T>::value);
+  constexpr static size_t kFirstFieldIndex = super_fields_t::kFieldsCount;
+  constexpr static size_t kFieldsCount = kFirstFieldIndex + kOwnFieldsCount;
+
+  constexpr static size_t kNotFound = static_cast<size_t>(-1);
+
+  static void ParseObject(JSONDirectParser<JSON_FORMAT>& parser, T& destination, const bool* requested) {
+    std::array<bool, kFieldsCount> parsed{};
+    size_t next = 0u;
+    parser.Object([&parser, &destination, &parsed, requested, &next](const char* key, size_t length) {
+      if (!ParseField(parser, destination, key, length, parsed.data(), requested, next)) {
+        parser.SkipValue();
+      }
+    });
+    DeserializeMissingFields(parser, destination, parsed.data(), requested);
+  }
+
+  // Returns the index of the field throughout the hierarchy, or `kNotFound`.
+  template <typename U, typename C>
+  static size_t FieldIndex(U C::*field) {
+    size_t index = kNotFound;
+    size_t i = 0u;
+    current::reflection::VisitAllFields<T, current::reflection::FieldNameAndPtr<T>>::WithoutObject(
+        FieldFinder<U, C>(field, index, i));
+    return index != kNotFound ? kFirstFieldIndex + index : super_fields_t::FieldIndex(field);
+  }
+
+  // For the inputs not parsed directly, only the requested fields are deserialized from the DOM.
+  static void DeserializeFieldsViaDOM(JSONParser<JSON_FORMAT>& json_parser, T& destination, const bool* requested) {
+    super_fields_t::DeserializeFieldsViaDOM(json_parser, static_cast<super_t&>(destination), requested);
+    current::reflection::VisitAllFields<T, current::reflection::FieldNameAndMutableValue>::WithObject(
+        destination, RequestedFieldsDeserializer(json_parser, requested + kFirstFieldIndex));
+  }
+
+  constexpr static bool Declares(const char* name) {
+    return JSONStructFieldsIndex<T>::Declares(name) || super_fields_t::Declares(name);
+  }
+
+  static bool HasField(const char* key, size_t length) {
+    return JSONStructFieldsIndex<T>::Find(key, length) != JSONStructFieldsIndex<T>::kNotFound ||
+           super_fields_t::HasField(key, length);
+  }
+
+  // Returns `false` if there is no field named `key`. The field `next`, numbered throughout the hierarchy,
+  // is looked at first, and is updated to the one after the field parsed.
+  static bool ParseField(JSONDirectParser<JSON_FORMAT>& parser,
+                         T& destination,
+                         const char* key,
+                         size_t length,
+                         bool* parsed,
+                         const bool* requested,
+                         size_t& next) {
+    const size_t hint = next >= kFirstFieldIndex ? next - kFirstFieldIndex : 0u;
+    const size_t index = JSONStructFieldsIndex<T>::Find(key, length, hint);
+    if (index == JSONStructFieldsIndex<T>::kNotFound) {
+      return super_fields_t::ParseField(
+          parser, static_cast<super_t&>(destination), key, length, parsed, requested, next);
+    }
+    constexpr bool shadows_super_field = ShadowsSuperField();
+    if (shadows_super_field && super_fields_t::HasField(key, length)) {
+      // The DOM-based deserializer would feed this member to both fields.
+      parser.Fallback();
+    }
+    next = kFirstFieldIndex + index + 1u;
+    if (requested && !requested[kFirstFieldIndex + index]) {
+      parser.SkipValue();
+    } else if (!parsed[kFirstFieldIndex + index]) {
+      parsed[kFirstFieldIndex + index] = true;
+      FieldParsers()[index](parser, destination);
+    } else {
+      // Should a member be present more than once, the first one is used.
+      parser.SkipValue();
+    }
+    return true;
+  }
+
+  static void DeserializeMissingFields(JSONDirectParser<JSON_FORMAT>& parser,
+                                       T& destination,
+                                       const bool* parsed,
+                                       const bool* requested) {
+    super_fields_t::DeserializeMissingFields(parser, static_cast<super_t&>(destination), parsed, requested);
+    const bool* own_requested = requested ? requested + kFirstFieldIndex : nullptr;
+    current::reflection::VisitAllFields<T, current::reflection::FieldNameAndMutableValue>::WithObject(
+        destination, MissingFieldsDeserializer(parser, parsed + kFirstFieldIndex, own_requested));
+  }
+
+ private:
+  struct FieldParser {
+    JSONDirectParser<JSON_FORMAT>& parser;
+    explicit FieldParser(JSONDirectParser<JSON_FORMAT>& parser) : parser(parser) {}
+    template <typename U>
+    void operator()(const char*, U& value) const {
+      parser.Inner(value);
+    }
+  };
+
+  // Whether any field of `T` has the same name as a field of its super, known at compile time.
+  constexpr static bool ShadowsSuperField(size_t i = 0u) {
+    return i < kOwnFieldsCount &&
+           (super_fields_t::Declares(JSONStructFieldsIndex<T>::names_t::names[i]) || ShadowsSuperField(i + 1u));
+  }
+
+  template <int I>
+  static void ParseFieldByIndex(JSONDirectParser<JSON_FORMAT>& parser, T& destination) {
+    destination.CURRENT_REFLECTION(FieldParser(parser),
+                                   current::reflection::Index<current::reflection::FieldNameAndMutableValue, I>());
+  }
+
+  // The table is a constant, initialized statically. The trailing `nullptr` is there for the structs with no fields.
+  template <int... NS>
+  static const field_parser_t* FieldParsers(current::variadic_indexes::indexes<NS...>) {
+    static const field_parser_t parsers[] = {&ParseFieldByIndex<NS>..., nullptr};
+    return parsers;
+  }
+
+  static const field_parser_t* FieldParsers() {
+    return FieldParsers(current::variadic_indexes::generate_indexes<static_cast<int>(kOwnFieldsCount)>());
+  }
+
+  class MissingFieldsDeserializer {
+   public:
+    MissingFieldsDeserializer(JSONDirectParser<JSON_FORMAT>& parser, const bool* parsed, const bool* requested)
+        : parser_(parser), parsed_(parsed), requested_(requested) {}
+
+    template <typename U>
+    void operator()(const char*, U& value) {
+      if (!parsed_[index_] && (!requested_ || requested_[index_])) {
+        parser_.DeserializeMissingViaDOM(value);
+      }
+      ++index_;
+    }
+
+   private:
+    JSONDirectParser<JSON_FORMAT>& parser_;
+    const bool* parsed_;
+    const bool* requested_;
+    size_t index_ = 0u;
+  };
+
+  template <typename U, typename C>
+  struct FieldFinder {
+    U C::*field;
+    size_t& index;
+    size_t& i;
+    FieldFinder(U C::*field, size_t& index, size_t& i) : field(field), index(index), i(i) {}
+    void operator()(const char*, U C::*candidate) const {
+      if (candidate == field) {
+        index = i;
+      }
+      ++i;
+    }
+    template <typename V, typename D>
+    void operator()(const char*, V D::*) const {
+      ++i;
+    }
+  };
+
+  class RequestedFieldsDeserializer {
+   public:
+    RequestedFieldsDeserializer(JSONParser<JSON_FORMAT>& json_parser, const bool* requested)
+        : json_parser_(json_parser), requested_(requested) {}
+
+    // IMPORTANT: Must take `name` as `const char* name`, as it is kept in the path until the field is parsed.
+    template <typename U>
+    void operator()(const char* name, U& value) {
+      if (requested_[index_++]) {
+        rapidjson::Value& object = json_parser_.Current();
+        const auto member = object.FindMember(name);
+        json_parser_.Inner(member != object.MemberEnd() ? &member->value : nullptr, value, ".", name);
+      }
+    }
+
+   private:
+    JSONParser<JSON_FORMAT>& json_parser_;
+    const bool* requested_;
+    size_t index_ = 0u;
+  };
+};
+
+template <class JSON_FORMAT>
+struct JSONDirectStructFields<JSON_FORMAT, CurrentStruct> {
+  constexpr static size_t kFieldsCount = 0u;
+  template <typename U, typename C>
+  static size_t FieldIndex(U C::*) {
+    return static_cast<size_t>(-1);
+  }
+  static void DeserializeFieldsViaDOM(JSONParser<JSON_FORMAT>&, CurrentStruct&, const bool*) {}
+  constexpr static bool Declares(const char*) { return false; }
+  static bool HasField(const char*, size_t) { return false; }
+  static bool ParseField(
+      JSONDirectParser<JSON_FORMAT>&, CurrentStruct&, const char*, size_t, bool*, const bool*, size_t&) {
+    return false;
+  }
+  static void DeserializeMissingFields(JSONDirectParser<JSON_FORMAT>&, CurrentStruct&, const bool*, const bool*) {}
+};
+
+template <class JSON_FORMAT, typename T>
+struct JSONDirectDeserializeImpl<JSON_FORMAT,
+                                 T,
+                                 std::enable_if_t<IS_CURRENT_STRUCT(T) && !std::is_same<T, CurrentStruct>::value>> {
+  using fields_t = JSONDirectStructFields<JSON_FORMAT, current::decay<T>>;
+
+  static void DoDeserialize(JSONDirectParser<JSON_FORMAT>& parser, T& destination) {
+    fields_t::ParseObject(parser, destination, nullptr);
+  }
+};
+
+// Parses only the listed `fields` of `destination` out of the JSON object, leaving its other fields intact.
+// The values of the other members are skipped over without being parsed or stored.
+// Ex.: `ParseJSONFields(json, entry, &Entry::key, &Entry::timestamp)`.
+template <class J = JSONFormat::Current, typename T, typename... PTRS>
+inline void ParseJSONFields(const char* json, T& destination, PTRS... fields) {
+  static_assert(IS_CURRENT_STRUCT(T), "`ParseJSONFields` must be called with a `CURRENT_STRUCT`.");
+  static_assert(sizeof...(PTRS) > 0, "`ParseJSONFields` must be called with at least one field.");
+  using fields_t = JSONDirectStructFields<J, T>;
+  std::array<bool, fields_t::kFieldsCount> requested{};
+  for (const size_t index : {fields_t::FieldIndex(fields)...}) {
+    CURRENT_ASSERT(index != fields_t::kNotFound);
+    requested[index] = true;
+  }
+  try {
+    if (!JSONDirectParser<J>::Parse(json, [&destination, &requested](JSONDirectParser<J>& parser) {
+          fields_t::ParseObject(parser, destination, requested.data());
+        })) {
+      JSONParser<J> json_parser(json);
+      if (!json_parser.Current().IsObject()) {
+        CURRENT_THROW(JSONSchemaException("object", json_parser));  // LCOV_EXCL_LINE
+      }
+      fields_t::DeserializeFieldsViaDOM(json_parser, destination, requested.data());
+    }
+  } catch (UninitializedVariant) {
+    CURRENT_THROW(JSONUninitializedVariantObjectException());
+  }
+}
+
+template <class J = JSONFormat::Current, typename T, typename... PTRS>
+inline void ParseJSONFields(const std::string& json, T& destination, PTRS... fields) {
+  ParseJSONFields<J>(json.c_str(), destination, fields...);
+}
+
+}  // namespace current::serialization::json
+
 }  // namespace current::serialization
+
+using serialization::json::ParseJSONFields;
 }  // namespace current
 
+using current::ParseJSONFields;
+
 #endif  // CURRENT_TYPE_SYSTEM_SERIALIZATION_JSON_STRUCT_H
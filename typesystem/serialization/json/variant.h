@@ -26,7 +26,10 @@ SOFTWARE.
 #ifndef CURRENT_TYPE_SYSTEM_SERIALIZATION_JSON_VARIANT_H
 #define CURRENT_TYPE_SYSTEM_SERIALIZATION_JSON_VARIANT_H
 
+#include <cstring>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 #include "primitives.h"
 #include "typeid.h"
@@ -61,29 +64,22 @@ class JSONVariantSerializer<json::JSONVariantStyle::Current, JSON_FORMAT> {
 
   template <typename X>
   std::enable_if_t<IS_CURRENT_STRUCT_OR_VARIANT(X)> operator()(const X& object) {
-    rapidjson::Value serialized_object;
-    json_stringifier_.Inner(&serialized_object, object);
+    json_stringifier_.StartObject();
 
-    using namespace ::current::reflection;
-    rapidjson::Value serialized_type_id;
-    json_stringifier_.Inner(&serialized_type_id, Value<ReflectedTypeBase>(Reflector().ReflectType<X>()).type_id);
-
-    json_stringifier_.Current().SetObject();
-
-    json_stringifier_.Current().AddMember(
-        rapidjson::StringRef(reflection::CurrentTypeName<X, reflection::NameFormat::Z>()),
-        std::move(serialized_object.Move()),
-        json_stringifier_.Allocator());
+    json_stringifier_.Key(reflection::CurrentTypeName<X, reflection::NameFormat::Z>());
+    json_stringifier_.Inner(object);
 
     if (json::JSONVariantTypeIDInEmptyKey<JSON_FORMAT>::value) {
-      json_stringifier_.Current().AddMember("", std::move(serialized_type_id.Move()), json_stringifier_.Allocator());
+      using namespace ::current::reflection;
+      json_stringifier_.Key("");
+      json_stringifier_.Inner(Value<ReflectedTypeBase>(Reflector().ReflectType<X>()).type_id);
     }
     if (json::JSONVariantTypeNameInDollarKey<JSON_FORMAT>::value) {
-      json_stringifier_.Current().AddMember(
-          "$",
-          rapidjson::StringRef(reflection::CurrentTypeName<X, reflection::NameFormat::Z>()),
-          json_stringifier_.Allocator());
+      json_stringifier_.Key("$");
+      json_stringifier_ = reflection::CurrentTypeName<X, reflection::NameFormat::Z>();
     }
+
+    json_stringifier_.EndObject();
   }
 
  private:
@@ -104,24 +100,19 @@ class JSONVariantSerializer<json::JSONVariantStyle::NewtonsoftFSharp, JSON_FORMA
 
   template <typename X>
   std::enable_if_t<IS_CURRENT_STRUCT_OR_VARIANT(X)> operator()(const X& object) {
-    rapidjson::Value serialized_object;
-    json_stringifier_.Inner(&serialized_object, object);
+    json_stringifier_.StartObject();
 
-    json_stringifier_.Current().SetObject();
-    json_stringifier_.Current().AddMember(
-        "Case",
-        rapidjson::StringRef(reflection::CurrentTypeName<X, reflection::NameFormat::Z>()),
-        json_stringifier_.Allocator());
+    json_stringifier_.Key("Case");
+    json_stringifier_ = reflection::CurrentTypeName<X, reflection::NameFormat::Z>();
 
     if (IS_CURRENT_VARIANT(X) || !IS_EMPTY_CURRENT_STRUCT(X)) {
-      rapidjson::Value fields_as_array;
-      fields_as_array.SetArray();
-      fields_as_array.PushBack(std::move(serialized_object.Move()), json_stringifier_.Allocator());
-
-      json_stringifier_.Current().AddMember(std::move(rapidjson::Value("Fields", json_stringifier_.Allocator()).Move()),
-                                            std::move(fields_as_array.Move()),
-                                            json_stringifier_.Allocator());
+      json_stringifier_.Key("Fields");
+      json_stringifier_.StartArray();
+      json_stringifier_.Inner(object);
+      json_stringifier_.EndArray();
     }
+
+    json_stringifier_.EndObject();
   }
 
  private:
@@ -410,7 +401,7 @@ struct SerializeImpl<json::JSONStringifier<JSON_FORMAT>, T, std::enable_if_t<IS_
       value.Call(impl);
     } else {
       if (json::JSONVariantStyleUseNulls<JSON_FORMAT::variant_style>::value) {
-        json_stringifier.Current().SetNull();
+        json_stringifier.WriteNull();
       } else {
         json_stringifier.MarkAsAbsentValue();
       }
@@ -432,6 +423,137 @@ struct DeserializeImpl<json::JSONParser<JSON_FORMAT>, T, std::enable_if_t<IS_CUR
   }
 };
 
+namespace json {
+
+// The cases of `VARIANT` for `JSONDirectParser`: the name of each, its type id as it is in the JSON, and the parser
+// of its value. Built once per type. Should two different cases have the same name, which of them is meant is left
+// to the DOM-based deserializer.
+template <class JSON_FORMAT, typename VARIANT>
+class JSONDirectVariantCases final {
+ public:
+  using case_parser_t = void (*)(JSONDirectParser<JSON_FORMAT>&, VARIANT&);
+
+  struct Case final {
+    const char* name;
+    size_t length;
+    std::string type_id;
+    case_parser_t parser;
+  };
+
+  static const JSONDirectVariantCases& Instance() {
+    static const JSONDirectVariantCases instance;
+    return instance;
+  }
+
+  bool Ambiguous() const { return ambiguous_; }
+
+  // Variants have few cases, so the names are compared one by one.
+  const Case* Find(const char* name, size_t length) const {
+    for (const Case& c : cases_) {
+      if (c.length == length && !std::memcmp(c.name, name, length)) {
+        return &c;
+      }
+    }
+    return nullptr;
+  }
+
+ private:
+  template <typename X>
+  struct Registerer {
+    Registerer(JSONDirectVariantCases& cases) { cases.template Register<X>(); }
+  };
+
+  JSONDirectVariantCases() {
+    current::metaprogramming::call_all_constructors_with<Registerer,
+                                                         JSONDirectVariantCases,
+                                                         typename VARIANT::typelist_t>(*this);
+  }
+
+  template <typename X>
+  void Register() {
+    const char* name = reflection::CurrentTypeName<X, reflection::NameFormat::Z>();
+    std::string type_id;
+    if (JSON_FORMAT::variant_style == JSONVariantStyle::Current) {
+      type_id = "T" + current::ToString(Value<reflection::ReflectedTypeBase>(reflection::Reflector().ReflectType<X>())
+                                            .type_id);
+    }
+    const Case* existing = Find(name, std::strlen(name));
+    if (!existing) {
+      cases_.push_back(Case{name, std::strlen(name), type_id, &ParseCase<X>});
+    } else if (existing->type_id != type_id || existing->parser != &ParseCase<X>) {
+      ambiguous_ = true;
+    }
+  }
+
+  template <typename X>
+  static void ParseCase(JSONDirectParser<JSON_FORMAT>& parser, VARIANT& destination) {
+    parser.Inner(destination.template Construct<X>());
+  }
+
+  std::vector<Case> cases_;
+  bool ambiguous_ = false;
+};
+
+// Parses the variants straight into the case named by the key of the object, with no DOM. In the `Current` style,
+// the case is confirmed by the type id, which follows it. The `NewtonsoftFSharp` style, where the name of the case
+// is a value, is parsed via the DOM.
+template <class JSON_FORMAT, typename T>
+struct JSONDirectDeserializeImpl<
+    JSON_FORMAT,
+    T,
+    std::enable_if_t<IS_CURRENT_VARIANT(T) && JSON_FORMAT::variant_style != JSONVariantStyle::NewtonsoftFSharp>> {
+  using cases_t = JSONDirectVariantCases<JSON_FORMAT, T>;
+  constexpr static bool kByTypeID = JSON_FORMAT::variant_style == JSONVariantStyle::Current;
+
+  static void DoDeserialize(JSONDirectParser<JSON_FORMAT>& parser, T& destination) {
+    const cases_t& cases = cases_t::Instance();
+    if (cases.Ambiguous()) {
+      parser.DeserializeViaDOM(destination);
+      return;
+    }
+    if (parser.TryNull()) {
+      if (JSONVariantStyleUseNulls<JSON_FORMAT::variant_style>::value) {
+        parser.Fallback();
+      }
+      return;
+    }
+    const typename cases_t::Case* parsed_case = nullptr;
+    bool type_id_confirmed = false;
+    parser.Object([&](const char* key, size_t length) {
+      if (!length) {
+        if (!kByTypeID || type_id_confirmed) {
+          // Should the type id be present more than once, the first one is used.
+          parser.SkipValue();
+        } else if (parsed_case && parser.String() == parsed_case->type_id) {
+          type_id_confirmed = true;
+        } else {
+          // The type id names the case only once its value has been parsed, or is not the type id of the case.
+          parser.Fallback();
+        }
+      } else if (length == 1u && *key == '$') {
+        parser.SkipValue();
+      } else {
+        const typename cases_t::Case* c = cases.Find(key, length);
+        if (c ? parsed_case != nullptr : !kByTypeID) {
+          // More than one case, to be told apart by the type id, or an unknown case, which is an error.
+          parser.Fallback();
+        } else if (c) {
+          parsed_case = c;
+          c->parser(parser, destination);
+        } else {
+          // The members other than the case and its type id are ignored.
+          parser.SkipValue();
+        }
+      }
+    });
+    if (!parsed_case || (kByTypeID && !type_id_confirmed)) {
+      parser.Fallback();
+    }
+  }
+};
+
+}  // namespace current::serialization::json
+
 }  // namespace current::serialization
 }  // namespace current
 
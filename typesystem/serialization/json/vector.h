@@ -36,25 +36,23 @@ namespace serialization {
 template <class JSON_FORMAT, typename T, typename TA>
 struct SerializeImpl<json::JSONStringifier<JSON_FORMAT>, std::vector<T, TA>> {
   static void DoSerialize(json::JSONStringifier<JSON_FORMAT>& json_stringifier, const std::vector<T>& value) {
-    json_stringifier.Current().SetArray();
+    json_stringifier.StartArray();
     for (const auto& element : value) {
-      rapidjson::Value element_to_push;
-      json_stringifier.Inner(&element_to_push, element);
-      json_stringifier.Current().PushBack(std::move(element_to_push.Move()), json_stringifier.Allocator());
+      json_stringifier.Inner(element);
     }
+    json_stringifier.EndArray();
   }
 };
 
 template <class JSON_FORMAT, typename TA>
 struct SerializeImpl<json::JSONStringifier<JSON_FORMAT>, std::vector<bool, TA>> {
   static void DoSerialize(json::JSONStringifier<JSON_FORMAT>& json_stringifier, const std::vector<bool, TA>& value) {
-    json_stringifier.Current().SetArray();
+    json_stringifier.StartArray();
     for (const auto& element : value) {
-      rapidjson::Value element_to_push;
       const bool tmp = element;
-      json_stringifier.Inner(&element_to_push, tmp);
-      json_stringifier.Current().PushBack(std::move(element_to_push.Move()), json_stringifier.Allocator());
+      json_stringifier.Inner(tmp);
     }
+    json_stringifier.EndArray();
   }
 };
 
@@ -97,6 +95,37 @@ struct IsJSONSerializable<std::vector<T, ALLOC>> {
 };
 }  // namespace json
 
+namespace json {
+
+// Parses into the elements already in `destination`, if any, so that their memory is reused. See `JSONParseArena`.
+template <class JSON_FORMAT, typename T, typename TA>
+struct JSONDirectDeserializeImpl<JSON_FORMAT, std::vector<T, TA>> {
+  static void DoDeserialize(JSONDirectParser<JSON_FORMAT>& parser, std::vector<T, TA>& destination) {
+    size_t size = 0u;
+    parser.Array([&parser, &destination, &size]() {
+      if (size == destination.size()) {
+        destination.emplace_back();
+      }
+      parser.Inner(destination[size++]);
+    });
+    destination.resize(size);
+  }
+};
+
+template <class JSON_FORMAT, typename TA>
+struct JSONDirectDeserializeImpl<JSON_FORMAT, std::vector<bool, TA>> {
+  static void DoDeserialize(JSONDirectParser<JSON_FORMAT>& parser, std::vector<bool, TA>& destination) {
+    destination.clear();
+    parser.Array([&parser, &destination]() {
+      bool tmp;
+      parser.Inner(tmp);
+      destination.push_back(tmp);
+    });
+  }
+};
+
+}  // namespace current::serialization::json
+
 }  // namespace current::serialization
 }  // namespace current
 
@@ -1238,6 +1238,241 @@ TEST(JSONSerialization, VariantNullOmittedInMinimalisticFormat) {
   EXPECT_EQ("null", JSON(Variant<Empty>()));
 }
 
+TEST(JSONSerialization, AbsentValuesInMinimalisticFormat) {
+  using namespace serialization_test;
+
+  // Only the members of objects are omitted, absent elements of arrays or values of maps are `null`-s.
+  WithOptional object;
+  object.b = true;
+  EXPECT_EQ("{\"b\":true}", JSON<JSONFormat::Minimalistic>(object));
+  EXPECT_EQ("[{\"b\":true},{}]", JSON<JSONFormat::Minimalistic>(std::vector<WithOptional>({object, WithOptional()})));
+  EXPECT_EQ("[1,null,3]", JSON<JSONFormat::Minimalistic>(std::vector<Optional<int>>({1, nullptr, 3})));
+  EXPECT_EQ("{\"a\":null,\"b\":2}",
+            JSON<JSONFormat::Minimalistic>(std::map<std::string, Optional<int>>({{"a", nullptr}, {"b", 2}})));
+  EXPECT_EQ("null", JSON<JSONFormat::Minimalistic>(Optional<int>()));
+}
+
+TEST(JSONSerialization, AppendJSON) {
+  using namespace serialization_test;
+
+  std::string output = "data=";
+  AppendJSON(output, std::vector<int>({1, 2}));
+  EXPECT_EQ("data=[1,2]", output);
+
+  WithOptional object;
+  object.i = 42;
+  output += ';';
+  AppendJSON<JSONFormat::Minimalistic>(output, object);
+  EXPECT_EQ("data=[1,2];{\"i\":42}", output);
+}
+
+TEST(JSONSerialization, ParseMembersInAnyOrder) {
+  using namespace serialization_test;
+
+  {
+    // Unknown members are skipped, and, should a member be present more than once, the first one is used.
+    const auto result = ParseJSON<DerivedSerializable>(
+        "{ \"d\" : 0.5, \"unknown\" : { \"x\" : [ 1, { \"y\" : null } ] }, \"e\" : 100, \"b\" : true,"
+        " \"s\" : \"first\", \"s\" : \"second\", \"i\" : 42 }");
+    EXPECT_EQ(42u, result.i);
+    EXPECT_EQ("first", result.s);
+    EXPECT_TRUE(result.b);
+    EXPECT_EQ(Enum::SET, result.e);
+    EXPECT_EQ(0.5, result.d);
+  }
+
+  {
+    // Missing optionals are null, and the variants within are parsed as well.
+    ContainsVariant object;
+    object.variant = Serializable(1);
+    const auto result = ParseJSON<std::vector<ContainsVariant>>("[ " + JSON(object) + " ]");
+    ASSERT_EQ(1u, result.size());
+    EXPECT_EQ(1u, Value<Serializable>(result[0].variant).i);
+    EXPECT_FALSE(Exists(ParseJSON<WithOptional>("{\"b\":true}").i));
+  }
+
+  {
+    // The errors are reported in exactly the same way regardless of the order of members.
+    try {
+      ParseJSON<DerivedSerializable>("{\"d\":0.5,\"i\":1,\"s\":\"\",\"b\":false,\"e\":\"bad\"}");
+      ASSERT_TRUE(false);
+    } catch (const JSONSchemaException& e) {
+      EXPECT_EQ(std::string("Expected number for `e`, got: \"bad\""), e.OriginalDescription());
+    }
+    ASSERT_THROW(ParseJSON<DerivedSerializable>("{\"d\":0.5,\"i\":1,\"s\":\"\",\"b\":false,\"e\":0,}"),
+                 InvalidJSONException);
+  }
+}
+
+TEST(JSONSerialization, ParseVariantsAndFallBackPerValue) {
+  using namespace serialization_test;
+  using namespace serialization_test::named_variant;
+  using current::serialization::json::ReusableJSONParserMemory;
+
+  OuterA outer;
+  outer.a = Y();
+  WrappedQ wrapped;
+  wrapped = outer;
+
+  {
+    // The variants, the nested ones included, are parsed with no DOM.
+    const uint64_t before = ReusableJSONParserMemory::ValuesParsedViaDOM();
+    const auto result = ParseJSON<WrappedQ>(JSON(wrapped));
+    EXPECT_EQ(2, Value<Y>(Value<OuterA>(result).a).y);
+    const auto minimalistic = ParseJSON<WrappedQ, JSONFormat::Minimalistic>(JSON<JSONFormat::Minimalistic>(wrapped));
+    EXPECT_EQ(JSON(wrapped), JSON(minimalistic));
+    const auto javascript = ParseJSON<WrappedQ, JSONFormat::JavaScript>(JSON<JSONFormat::JavaScript>(wrapped));
+    EXPECT_EQ(JSON(wrapped), JSON(javascript));
+    EXPECT_EQ(before, ReusableJSONParserMemory::ValuesParsedViaDOM());
+  }
+
+  {
+    // Only the values not parsed directly are parsed via the DOM, not the whole document.
+    WithVectorOfPairs pairs;
+    pairs.v.emplace_back(1, "one");
+    std::vector<WithInnerVariant> input(3u);
+    input[0].v = pairs;
+    input[1].v = WithOptional();
+    input[2].v = pairs;
+    const uint64_t before = ReusableJSONParserMemory::ValuesParsedViaDOM();
+    const auto result = ParseJSON<std::vector<WithInnerVariant>>(JSON(input));
+    EXPECT_EQ(before + 2u, ReusableJSONParserMemory::ValuesParsedViaDOM());
+    EXPECT_EQ(JSON(input), JSON(result));
+  }
+
+  {
+    // The type id that does not follow its case is left to the DOM, and so are the errors.
+    WrappedQ other;
+    other = OuterB();
+    const std::string other_json = JSON(other);
+    const std::string other_type_id = other_json.substr(other_json.rfind("\"\":"));
+    const std::string json = JSON(wrapped);
+    const std::string type_id = json.substr(json.rfind("\"\":"));
+    EXPECT_EQ(json, JSON(ParseJSON<WrappedQ>("{" + type_id.substr(0u, type_id.length() - 1u) + ",\"OuterA\":" +
+                                             JSON(outer) + "}")));
+    try {
+      ParseJSON<WrappedQ>("{\"OuterA\":" + JSON(outer) + "," + other_type_id);
+      ASSERT_TRUE(false);
+    } catch (const JSONSchemaException& e) {
+      EXPECT_EQ(0u, std::string(e.OriginalDescription()).find("Expected variant case `OuterB`"));
+    }
+  }
+}
+
+TEST(JSONSerialization, ParseJSONFields) {
+  using namespace serialization_test;
+
+  ComplexSerializable object('a', 'c');
+  object.j = 42u;
+  object.q = "q";
+  object.z = Serializable(1, "one", true, Enum::SET);
+  const std::string json = JSON(object);
+
+  {
+    ComplexSerializable result;
+    result.q = "intact";
+    ParseJSONFields(json, result, &ComplexSerializable::j, &ComplexSerializable::z);
+    EXPECT_EQ(42u, result.j);
+    EXPECT_EQ("intact", result.q);
+    EXPECT_TRUE(result.v.empty());
+    EXPECT_EQ("one", result.z.s);
+  }
+
+  {
+    // The values of the fields not requested are not parsed.
+    DerivedSerializable result;
+    ParseJSONFields(
+        "{\"s\":[{\"whatever\":true}],\"i\":1,\"d\":0.5,\"e\":\"not an enum\"}", result, &DerivedSerializable::d);
+    EXPECT_EQ(0.5, result.d);
+    ParseJSONFields("{\"s\":\"s\",\"i\":1,\"d\":0.5}", result, &DerivedSerializable::i, &DerivedSerializable::s);
+    EXPECT_EQ(1u, result.i);
+    EXPECT_EQ("s", result.s);
+  }
+
+  {
+    // The errors are reported for the requested fields only.
+    DerivedSerializable result;
+    try {
+      ParseJSONFields("{\"s\":42,\"i\":\"bad\"}", result, &DerivedSerializable::i);
+      ASSERT_TRUE(false);
+    } catch (const JSONSchemaException& e) {
+      EXPECT_EQ(std::string("Expected unsigned integer for `i`, got: \"bad\""), e.OriginalDescription());
+    }
+    try {
+      ParseJSONFields("{\"s\":42}", result, &DerivedSerializable::i);
+      ASSERT_TRUE(false);
+    } catch (const JSONSchemaException& e) {
+      EXPECT_EQ(std::string("Expected unsigned integer for `i`, got: missing field."), e.OriginalDescription());
+    }
+    ASSERT_THROW(ParseJSONFields("[]", result, &DerivedSerializable::i), JSONSchemaException);
+    ASSERT_THROW(ParseJSONFields("{\"i\":1,}", result, &DerivedSerializable::i), InvalidJSONException);
+  }
+}
+
+TEST(JSONSerialization, JSONParseArena) {
+  using namespace serialization_test;
+
+  JSONParseArena<ComplexSerializable> arena;
+  EXPECT_TRUE(arena.Empty());
+
+  const ComplexSerializable& first = arena.Parse(JSON(ComplexSerializable('a', 'z')));
+  const ComplexSerializable& second = arena.Parse(JSON(ComplexSerializable('0', '1')));
+  ASSERT_EQ(2u, arena.Size());
+  EXPECT_EQ(26u, first.v.size());
+  EXPECT_EQ("1", second.v.back());
+  EXPECT_EQ(&first, &arena[0]);
+
+  ASSERT_THROW(arena.Parse("{\"j\":\"bad\"}"), JSONSchemaException);
+  EXPECT_EQ(2u, arena.Size());
+
+  // The objects released by `Clear()` are parsed into again, reusing their memory.
+  const std::string* const first_element = &first.v[0];
+  arena.Clear();
+  EXPECT_TRUE(arena.Empty());
+  const ComplexSerializable& reused = arena.Parse(JSON(ComplexSerializable('x', 'y')));
+  EXPECT_EQ(&first, &reused);
+  EXPECT_EQ(first_element, &reused.v[0]);
+  ASSERT_EQ(2u, reused.v.size());
+  EXPECT_EQ("x", reused.v[0]);
+  EXPECT_EQ("y", reused.v[1]);
+}
+
+TEST(JSONSerialization, StringsWithCharactersToEscape) {
+  const std::string specials("\"\\\b\f\n\r\t\x01\x1f", 9u);
+  for (size_t length = 0u; length < 100u; ++length) {
+    for (size_t position = 0u; position <= length; ++position) {
+      for (const char special : specials) {
+        std::string s(length, 'x');
+        if (position < length) {
+          s[position] = special;
+        }
+        s += "\xd0\x96";  // UTF-8 is kept as is.
+
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        writer.String(s.c_str(), static_cast<rapidjson::SizeType>(s.length()));
+        const std::string json = JSON(s);
+        ASSERT_EQ(buffer.GetString(), json);
+        ASSERT_EQ(s, ParseJSON<std::string>(json));
+
+        // The strings within the input are found correctly regardless of their alignment.
+        const char* p = s.c_str();
+        const char* expected = current::serialization::json::scan::FindSpecialCharacterScalar(p);
+        ASSERT_EQ(expected, current::serialization::json::FindJSONSpecialCharacter(p));
+#ifdef CURRENT_JSON_SIMD_SSE2
+        ASSERT_EQ(expected, current::serialization::json::scan::FindSpecialCharacterSSE2(p));
+#endif
+#ifdef CURRENT_JSON_SIMD_AVX2
+        if (__builtin_cpu_supports("avx2")) {
+          ASSERT_EQ(expected, current::serialization::json::scan::FindSpecialCharacterAVX2(p));
+        }
+#endif
+      }
+    }
+  }
+  EXPECT_EQ("\"/\b\u00e9\"", ParseJSON<std::string>("\"\\\"\\/\\b\\u00e9\\\"\""));
+}
+
 namespace serialization_test {
 
 CURRENT_STRUCT_T(TemplatedValue) {
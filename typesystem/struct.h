@@ -372,6 +372,7 @@ struct CurrentStructFieldsConsistency<T, 0u> {
   }
 
 #define CURRENT_FIELD_REFLECTION(idx, type, name)                                                                      \
+  constexpr static const char* CURRENT_REFLECTION_FIELD_NAME(::current::reflection::SimpleIndex<idx>) { return #name; } \
   template <class F>                                                                                                   \
   static void CURRENT_REFLECTION(F&& CURRENT_CALL_F,                                                                   \
                                  ::current::reflection::Index<::current::reflection::FieldTypeAndName, idx>) {         \
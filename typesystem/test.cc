@@ -209,6 +209,26 @@ TEST(TypeSystemTest, FieldDescriptions) {
   EXPECT_STREQ(nullptr, (current::reflection::FieldDescriptions::template Description<Baz, 4>()));
 }
 
+TEST(TypeSystemTest, FieldNames) {
+  using namespace struct_definition_test;
+  using baz_names_t = current::reflection::FieldNames<Baz>;
+  static_assert(baz_names_t::size == 5u, "");
+  static_assert(baz_names_t::lengths[0] == 2u, "");
+  static_assert(baz_names_t::names[3][0] == 'v' && baz_names_t::names[3][1] == '4', "");
+  EXPECT_STREQ("v1", baz_names_t::names[0]);
+  EXPECT_STREQ("v5", baz_names_t::names[4]);
+  EXPECT_STREQ(nullptr, baz_names_t::names[5]);
+
+  // The names of the fields of the super are not included.
+  using derived_names_t = current::reflection::FieldNames<DerivedFromFoo>;
+  static_assert(derived_names_t::size == 1u, "");
+  EXPECT_STREQ("baz", derived_names_t::names[0]);
+  EXPECT_EQ(3u, derived_names_t::lengths[0]);
+
+  static_assert(current::reflection::FieldNames<Empty>::size == 0u, "");
+  static_assert(current::reflection::FieldNames<Templated<bool>>::size == 2u, "");
+}
+
 TEST(TypeSystemTest, ExistsAndValueSemantics) {
   {
     int x = 1;
@@ -1522,6 +1542,104 @@ TEST(TypeSystemTest, InplaceVariantConstruction) {
   EXPECT_EQ(202u, Value<Bar>(v).j);
 }
 
+TEST(TypeSystemTest, VariantFromUniquePtr) {
+  using namespace struct_definition_test;
+
+  struct Visitor {
+    std::string s;
+    void operator()(const Foo& foo) { s = "Foo " + current::ToString(foo.i); }
+    void operator()(const Bar& bar) { s = "Bar " + current::ToString(bar.j); }
+    void operator()(const DerivedFromFoo&) { s = "DerivedFromFoo"; }
+  };
+  Visitor visitor;
+
+  using variant_t = Variant<Foo, Bar, DerivedFromFoo>;
+
+  {
+    variant_t v(current::BypassVariantTypeCheck(), std::make_unique<Bar>(1u));
+    v.Call(visitor);
+    EXPECT_EQ("Bar 1", visitor.s);
+    EXPECT_TRUE(Exists<Bar>(v));
+    EXPECT_FALSE(Exists<Foo>(v));
+  }
+
+  {
+    variant_t v;
+    v.UncheckedMoveFromUniquePtr(std::make_unique<DerivedFromFoo>());
+    v.Call(visitor);
+    EXPECT_EQ("DerivedFromFoo", visitor.s);
+    // The derived type can still be retrieved as the base one.
+    EXPECT_TRUE(Exists<DerivedFromFoo>(v));
+    EXPECT_TRUE(Exists<Foo>(v));
+    EXPECT_FALSE(Exists<Bar>(v));
+
+    variant_t moved_into(std::move(v));
+    EXPECT_FALSE(Exists(v));
+    EXPECT_FALSE(Exists<DerivedFromFoo>(v));
+    moved_into.Call(visitor);
+    EXPECT_EQ("DerivedFromFoo", visitor.s);
+
+    const variant_t copy(moved_into);
+    copy.Call(visitor);
+    EXPECT_EQ("DerivedFromFoo", visitor.s);
+  }
+
+  {
+    // A type not listed in the `Variant` is still reported via `Call()`.
+    Variant<Foo, DerivedFromFoo> v(current::BypassVariantTypeCheck(), std::make_unique<Bar>(2u));
+    try {
+      v.Call(visitor);
+      ASSERT_TRUE(false);  // LCOV_EXCL_LINE
+    } catch (const current::metaprogramming::UnlistedTypeException&) {
+    }
+  }
+}
+
+TEST(TypeSystemTest, VariantInlineStorage) {
+  using namespace struct_definition_test;
+
+  using variant_t = Variant<Foo, Baz>;
+
+  const auto is_inline = [](const variant_t& v, const void* object) {
+    return object >= static_cast<const void*>(&v) && object < static_cast<const void*>(&v + 1);
+  };
+
+  // Small objects are kept inline, larger ones go to the heap.
+  variant_t a(Foo(1u));
+  EXPECT_TRUE(is_inline(a, &Value<Foo>(a)));
+  Baz baz;
+  baz.v1.push_back(2u);
+  variant_t b(baz);
+  EXPECT_FALSE(is_inline(b, &Value<Baz>(b)));
+
+  // Moves and copies keep working across both.
+  variant_t c(std::move(a));
+  EXPECT_FALSE(Exists(a));
+  EXPECT_TRUE(is_inline(c, &Value<Foo>(c)));
+  EXPECT_EQ(1u, Value<Foo>(c).i);
+  a = c;
+  EXPECT_EQ(1u, Value<Foo>(a).i);
+  c = std::move(b);
+  EXPECT_FALSE(Exists(b));
+  EXPECT_EQ(2u, Value<Baz>(c).v1[0]);
+  b = std::move(a);
+  EXPECT_FALSE(Exists(a));
+  EXPECT_EQ(1u, Value<Foo>(b).i);
+
+  // Assigning a `Variant` its own object, or a part of it, is fine.
+  b = Value<Foo>(b);
+  EXPECT_EQ(1u, Value<Foo>(b).i);
+  b = b;
+  EXPECT_EQ(1u, Value<Foo>(b).i);
+  b.Construct<Foo>(Value<Foo>(b).i + 1u);
+  EXPECT_EQ(2u, Value<Foo>(b).i);
+
+  // Nested `Variant`-s are moved out of the enclosing object before it is destroyed.
+  Variant<Foo, variant_t> nested(variant_t(Foo(3u)));
+  nested = std::move(Value<variant_t>(nested));
+  EXPECT_EQ(3u, Value<Foo>(Value<variant_t>(nested)).i);
+}
+
 namespace struct_definition_test {
 
 CURRENT_STRUCT(DoesNotSupportPatch) {
@@ -255,8 +255,7 @@ struct VisitAllFields {
   // Visit all fields without an object. Used for enumerating fields and generating signatures.
   template <typename F>
   static void WithoutObject(F&& f) {
-    static NUM_INDEXES all_indexes;
-    WithoutObjectImpl(std::forward<F>(f), all_indexes);
+    WithoutObjectImpl(f, NUM_INDEXES());
   }
 
   // Visit all fields with an object, const or mutable. Used for serialization.
@@ -267,44 +266,61 @@ struct VisitAllFields {
   // So, I copy-pasted three implementations for now. -- D.K.
   template <typename F>
   static void WithObject(T& t, F&& f) {
-    static NUM_INDEXES all_indexes;
-    WithObjectImpl(t, std::forward<F>(f), all_indexes);
+    WithObjectImpl(t, f, NUM_INDEXES());
   }
   template <typename F>
   static void WithObject(const T& t, F&& f) {
-    static NUM_INDEXES all_indexes;
-    WithObjectImpl(t, std::forward<F>(f), all_indexes);
+    WithObjectImpl(t, f, NUM_INDEXES());
   }
   template <typename F>
   static void WithObject(T&& t, F&& f) {
-    static NUM_INDEXES all_indexes;
-    WithObjectImpl(t, std::forward<F>(f), all_indexes);
+    WithObjectImpl(t, f, NUM_INDEXES());
   }
 
  private:
-  template <typename F, int N, int... NS>
-  static void WithoutObjectImpl(F&& f, current::variadic_indexes::indexes<N, NS...>) {
-    static current::variadic_indexes::indexes<NS...> remaining_indexes;
-    T::CURRENT_REFLECTION(std::forward<F>(f), Index<VISITOR_TYPE, N>());
-    WithoutObjectImpl(std::forward<F>(f), remaining_indexes);
+  // All the fields are visited, in order, from a single pack expansion. Recursing over the indexes instead
+  // instantiated a function per field, with the names of all the remaining indexes in its signature, which made
+  // large structs slow to compile and bloated the binaries with symbols.
+  template <typename F, int... NS>
+  static void WithoutObjectImpl(F& f, current::variadic_indexes::indexes<NS...>) {
+    const int visit_in_order[] = {0, (T::CURRENT_REFLECTION(f, Index<VISITOR_TYPE, NS>()), 0)...};
+    static_cast<void>(visit_in_order);
   }
 
-  template <typename F>
-  static void WithoutObjectImpl(const F&, current::variadic_indexes::indexes<>) {}
-
-  template <typename TT, typename F, int N, int... NS>
-  static void WithObjectImpl(TT&& t, F&& f, current::variadic_indexes::indexes<N, NS...>) {
-    static current::variadic_indexes::indexes<NS...> remaining_indexes;
-    t.CURRENT_REFLECTION(std::forward<F>(f), Index<VISITOR_TYPE, N>());
+  template <typename TT, typename F, int... NS>
+  static void WithObjectImpl(TT& t, F& f, current::variadic_indexes::indexes<NS...>) {
     // `WithObjectImpl()` is called only from `WithObject()`, and by this point `TT` is `T`.
     static_assert(std::is_same<current::decay<TT>, T>::value, "");  // To be on the safe side.
-    WithObjectImpl(std::forward<TT>(t), std::forward<F>(f), remaining_indexes);
+    const int visit_in_order[] = {0, (t.CURRENT_REFLECTION(f, Index<VISITOR_TYPE, NS>()), 0)...};
+    static_cast<void>(visit_in_order);
   }
+};
 
-  template <typename TT, typename F>
-  static void WithObjectImpl(TT&&, const F&, crnt::vi::is<>) {}
+// The names of the fields of `T`, not including the ones of its super, and their lengths, as compile-time arrays
+// indexed by the field index. Each array has an extra trailing element, as the struct may have no fields.
+constexpr size_t FieldNameLength(const char* name, size_t i = 0u) {
+  return name[i] ? FieldNameLength(name, i + 1u) : i;
+}
+
+template <typename T, typename INDEXES = current::variadic_indexes::generate_indexes<FieldCounter<T>::value>>
+struct FieldNames;
+
+template <typename T, int... NS>
+struct FieldNames<T, current::variadic_indexes::indexes<NS...>> {
+  static_assert(IS_CURRENT_STRUCT(T), "`FieldNames` must be called with the type defined via `CURRENT_STRUCT` macro.");
+  constexpr static size_t size = sizeof...(NS);
+  constexpr static const char* names[sizeof...(NS) + 1u] = {T::CURRENT_REFLECTION_FIELD_NAME(SimpleIndex<NS>())...,
+                                                            nullptr};
+  constexpr static size_t lengths[sizeof...(NS) + 1u] = {
+      FieldNameLength(T::CURRENT_REFLECTION_FIELD_NAME(SimpleIndex<NS>()))..., 0u};
 };
 
+template <typename T, int... NS>
+constexpr const char* FieldNames<T, current::variadic_indexes::indexes<NS...>>::names[sizeof...(NS) + 1u];
+
+template <typename T, int... NS>
+constexpr size_t FieldNames<T, current::variadic_indexes::indexes<NS...>>::lengths[sizeof...(NS) + 1u];
+
 }  // namespace current::reflection
 
 namespace sfinae {
@@ -34,7 +34,11 @@ SOFTWARE.
 
 #include "../port.h"  // `make_unique`.
 
+#include <cstddef>
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
 
 #ifdef VARIANT_CHECKS_AT_RUNTIME_INSTEAD_OF_COMPILE_TIME
 // For runtime, not compile-time, extra checks.
@@ -68,6 +72,10 @@ struct BypassVariantTypeCheck {};
 
 namespace variant {
 
+// The size of the storage in which `Variant` keeps its object inline, to not allocate it on the heap.
+// Fits a `CURRENT_STRUCT` with a few primitive fields or an `std::string`; larger objects go to the heap.
+constexpr size_t kInlineStorageSize = 64u;
+
 #ifdef VARIANT_CHECKS_AT_RUNTIME_INSTEAD_OF_COMPILE_TIME
 template <typename T>
 struct RegisterType {
@@ -124,10 +132,19 @@ struct IHasUncheckedMoveFromUniquePtr : CurrentVariant {
 // The user hold the risk of having duplicate types, and it's their responsibility to pass in a `TypeList<...>`
 // instead of a `TypeListImpl<...>` in such a case, to ensure type de-duplication takes place.
 
-// Initializes an `std::unique_ptr<current::variant::object_base_t>` given the object of the right type.
-// The input object could be an object itself (in which case it's copied),
-// an `std::move()`-d `std::unique_ptr` to that object (in which case it's moved),
-// or a bare pointer (in which case it's captured).
+// Holds an object of one of the types of the type list, or nothing.
+// The input object could be an object itself (in which case it's copied or moved),
+// or an `std::unique_ptr` to that object (in which case it's captured).
+//
+// Along with the object, `VariantImpl` keeps the index of its type in `typelist_t`. The index is known at compile
+// time when the object is set via a typed method, and is looked up once by `typeid` when the object is handed over
+// as a bare `std::unique_ptr`. `Call()` then dispatches through a per-visitor table of functions, indexed by this
+// index, instead of the `RTTIDynamicCall` hash map lookup followed by a `dynamic_cast<>`.
+//
+// The object itself is kept inline, in the aligned storage of `VariantImpl`, as long as it fits there and can be
+// moved without throwing. Otherwise, as well as when it is handed over as an `std::unique_ptr`, it lives on the heap.
+// The inline storage is of fixed size, as the types of a `Variant` may still be incomplete where it is declared,
+// which is the case for recursive types.
 template <typename NAME, typename TYPE_LIST>
 struct VariantImpl;
 
@@ -142,8 +159,9 @@ struct VariantImpl<NAME, TypeListImpl<TYPES...>> : IHasUncheckedMoveFromUniquePt
 
   VariantImpl() {}
 
-  VariantImpl(BypassVariantTypeCheck, std::unique_ptr<current::variant::object_base_t>&& rhs)
-      : object_(std::move(rhs)) {}
+  VariantImpl(BypassVariantTypeCheck, std::unique_ptr<current::variant::object_base_t>&& rhs) {
+    Adopt(std::move(rhs));
+  }
 
   // Use deep copy helper for all Variant types, including our own.
   VariantImpl(const VariantImpl& rhs) { CopyFrom(rhs); }
@@ -152,8 +170,8 @@ struct VariantImpl<NAME, TypeListImpl<TYPES...>> : IHasUncheckedMoveFromUniquePt
     CopyFrom(rhs);
   }
 
-  // Default move constructor for the same Variant type as ours.
-  VariantImpl(VariantImpl&& rhs) = default;
+  // Plain move constructor for the same Variant type as ours.
+  VariantImpl(VariantImpl&& rhs) noexcept { MoveFromSameType(rhs); }
 
 #ifdef VARIANT_CHECKS_AT_RUNTIME_INSTEAD_OF_COMPILE_TIME
   template <typename... RHS>
@@ -172,25 +190,35 @@ struct VariantImpl<NAME, TypeListImpl<TYPES...>> : IHasUncheckedMoveFromUniquePt
   VariantImpl(X&& input) {
     using decayed_t = current::decay<X>;
     variant::RuntimeTypeListHelpers<typelist_t>::template AssertContains<decayed_t>();
-    object_ = std::make_unique<decayed_t>(std::forward<X>(input));
+    Emplace<decayed_t>(std::forward<X>(input));
   }
 #else
   template <typename X, class ENABLE = std::enable_if_t<TypeListContains<typelist_t, current::decay<X>>::value>>
   VariantImpl(X&& input) {
-    using decayed_t = current::decay<X>;
-    object_ = std::make_unique<decayed_t>(std::forward<X>(input));
+    Emplace<current::decay<X>>(std::forward<X>(input));
   }
 #endif  // VARIANT_CHECKS_AT_RUNTIME_INSTEAD_OF_COMPILE_TIME
 
-  void operator=(std::nullptr_t) { object_ = nullptr; }
+  ~VariantImpl() { Reset(); }
+
+  void operator=(std::nullptr_t) { Reset(); }
 
   VariantImpl& operator=(const VariantImpl& rhs) {
     CopyFrom(rhs);
     return *this;
   }
 
-  VariantImpl& operator=(VariantImpl&& rhs) {
-    object_ = std::move(rhs.object_);
+  VariantImpl& operator=(VariantImpl&& rhs) noexcept {
+    if (&rhs != this) {
+      if (object_) {
+        // `rhs` may be part of the object held now, so it is moved out before that object is destroyed.
+        VariantImpl moved(std::move(rhs));
+        Reset();
+        MoveFromSameType(moved);
+      } else {
+        MoveFromSameType(rhs);
+      }
+    }
     return *this;
   }
 
@@ -204,12 +232,13 @@ struct VariantImpl<NAME, TypeListImpl<TYPES...>> : IHasUncheckedMoveFromUniquePt
 #ifdef VARIANT_CHECKS_AT_RUNTIME_INSTEAD_OF_COMPILE_TIME
     variant::RuntimeTypeListHelpers<typelist_t>::template AssertContains<decayed_t>();
 #endif  // VARIANT_CHECKS_AT_RUNTIME_INSTEAD_OF_COMPILE_TIME
-    object_ = std::make_unique<decayed_t>(std::forward<X>(input));
+    Emplace<decayed_t>(std::forward<X>(input));
     return *this;
   }
 
   void UncheckedMoveFromUniquePtr(std::unique_ptr<current::variant::object_base_t> input) override {
-    object_ = std::move(input);
+    Reset();
+    Adopt(std::move(input));
   }
 
 #ifdef VARIANT_CHECKS_AT_RUNTIME_INSTEAD_OF_COMPILE_TIME
@@ -218,15 +247,14 @@ struct VariantImpl<NAME, TypeListImpl<TYPES...>> : IHasUncheckedMoveFromUniquePt
   template <typename T, typename... ARGS, class ENABLE = std::enable_if_t<TypeListContains<typelist_t, T>::value>>
 #endif  // VARIANT_CHECKS_AT_RUNTIME_INSTEAD_OF_COMPILE_TIME
   T& Construct(ARGS&&... args) {
-    object_ = std::make_unique<T>(std::forward<ARGS>(args)...);
-    return *dynamic_cast<T*>(object_.get());
+    return Emplace<T>(std::forward<ARGS>(args)...);
   }
   operator bool() const { return object_ ? true : false; }
 
   template <typename F>
   void Call(F&& f) {
     if (object_) {
-      current::metaprogramming::RTTIDynamicCall<typelist_t>(*object_, std::forward<F>(f));
+      Dispatch(std::forward<F>(f));
     } else {
       CURRENT_THROW(UninitializedVariantOfTypeException<TYPES...>());
     }
@@ -235,7 +263,7 @@ struct VariantImpl<NAME, TypeListImpl<TYPES...>> : IHasUncheckedMoveFromUniquePt
   template <typename F>
   void Call(F&& f) const {
     if (object_) {
-      current::metaprogramming::RTTIDynamicCall<typelist_t>(*object_, std::forward<F>(f));
+      Dispatch(std::forward<F>(f));
     } else {
       CURRENT_THROW(UninitializedVariantOfTypeException<TYPES...>());
     }
@@ -247,16 +275,20 @@ struct VariantImpl<NAME, TypeListImpl<TYPES...>> : IHasUncheckedMoveFromUniquePt
   // regardless of whether the base one is present in `typelist_t`.
   // Use `Call()` to run a strict check.
 
-  bool ExistsImpl() const { return (object_.get() != nullptr); }
+  bool ExistsImpl() const { return object_ != nullptr; }
 
+  // The exact type match, which is the most common case, is resolved by the type index, without RTTI.
   template <typename X>
   std::enable_if_t<!std::is_same<X, current::variant::object_base_t>::value, bool> VariantExistsImpl() const {
-    return dynamic_cast<const X*>(object_.get()) != nullptr;
+    return ExactTypePtr<X>() != nullptr || dynamic_cast<const X*>(object_) != nullptr;
   }
 
   template <typename X>
   std::enable_if_t<!std::is_same<X, current::variant::object_base_t>::value, X&> VariantValueImpl() {
-    X* ptr = dynamic_cast<X*>(object_.get());
+    X* ptr = ExactTypePtr<X>();
+    if (!ptr) {
+      ptr = dynamic_cast<X*>(object_);
+    }
     if (ptr) {
       return *ptr;
     } else {
@@ -266,7 +298,10 @@ struct VariantImpl<NAME, TypeListImpl<TYPES...>> : IHasUncheckedMoveFromUniquePt
 
   template <typename X>
   const X& VariantValueImpl() const {
-    const X* ptr = dynamic_cast<const X*>(object_.get());
+    const X* ptr = ExactTypePtr<X>();
+    if (!ptr) {
+      ptr = dynamic_cast<const X*>(object_);
+    }
     if (ptr) {
       return *ptr;
     } else {
@@ -284,21 +319,88 @@ struct VariantImpl<NAME, TypeListImpl<TYPES...>> : IHasUncheckedMoveFromUniquePt
   }
 
  private:
+  using storage_t = typename std::aligned_storage<variant::kInlineStorageSize, alignof(std::max_align_t)>::type;
+
+  // Moves the object of type `T` from the inline storage of one `VariantImpl` into that of another one.
+  using move_inline_t = current::variant::object_base_t* (*)(current::variant::object_base_t&, storage_t&);
+
+  template <typename T>
+  struct FitsInline {
+    constexpr static bool value = sizeof(T) <= sizeof(storage_t) && alignof(T) <= alignof(storage_t) &&
+                                  std::is_nothrow_move_constructible<T>::value;
+  };
+
+  template <typename T>
+  static current::variant::object_base_t* MoveInline(current::variant::object_base_t& from, storage_t& into) {
+    return new (&into) T(std::move(static_cast<T&>(from)));
+  }
+
+  template <typename T, typename... ARGS>
+  std::enable_if_t<FitsInline<T>::value, T&> Emplace(ARGS&&... args) {
+    if (object_) {
+      // The arguments may refer to the object held now, so it is only destroyed once the new one is constructed.
+      T object(std::forward<ARGS>(args)...);
+      Reset();
+      return EmplaceInline<T>(std::move(object));
+    } else {
+      return EmplaceInline<T>(std::forward<ARGS>(args)...);
+    }
+  }
+
+  template <typename T, typename... ARGS>
+  std::enable_if_t<!FitsInline<T>::value, T&> Emplace(ARGS&&... args) {
+    auto object = std::make_unique<T>(std::forward<ARGS>(args)...);
+    T& result = *object;
+    Reset();
+    object_ = object.release();
+    type_index_ = TypeListIndex<typelist_t, T>::value;
+    return result;
+  }
+
+  // Must be called with no object held.
+  template <typename T, typename... ARGS>
+  T& EmplaceInline(ARGS&&... args) {
+    T* object = new (&storage_) T(std::forward<ARGS>(args)...);
+    object_ = object;
+    move_inline_ = &MoveInline<T>;
+    type_index_ = TypeListIndex<typelist_t, T>::value;
+    return *object;
+  }
+
+  // Must be called with no object held.
+  void Adopt(std::unique_ptr<current::variant::object_base_t>&& input) {
+    object_ = input.release();
+    type_index_ = TypeIndexOf(object_);
+  }
+
+  void Reset() {
+    if (object_) {
+      if (move_inline_) {
+        object_->~CurrentSuper();
+        move_inline_ = nullptr;
+      } else {
+        delete object_;
+      }
+      object_ = nullptr;
+      type_index_ = typelist_size;
+    }
+  }
+
   struct TypeAwareClone {
-    std::unique_ptr<current::variant::object_base_t>& into;
-    TypeAwareClone(std::unique_ptr<current::variant::object_base_t>& into) : into(into) {}
+    VariantImpl& into;
+    TypeAwareClone(VariantImpl& into) : into(into) {}
 
 #ifdef VARIANT_CHECKS_AT_RUNTIME_INSTEAD_OF_COMPILE_TIME
     template <typename U>
     void operator()(const U& instance) {
       using decayed_u = current::decay<U>;
       variant::RuntimeTypeListHelpers<typelist_t>::template AssertContains<decayed_u>();
-      into = std::make_unique<decayed_u>(instance);
+      into.template Emplace<decayed_u>(instance);
     }
 #else
     template <typename U>
     std::enable_if_t<TypeListContains<typelist_t, current::decay<U>>::value> operator()(const U& instance) {
-      into = std::make_unique<current::decay<U>>(instance);
+      into.template Emplace<current::decay<U>>(instance);
     }
 
     template <typename U>
@@ -309,55 +411,142 @@ struct VariantImpl<NAME, TypeListImpl<TYPES...>> : IHasUncheckedMoveFromUniquePt
   };
 
   struct TypeAwareMove {
-    // `from` should not be an rvalue reference, as the move operation in `operator()` may still throw.
-    std::unique_ptr<current::variant::object_base_t>& from;
-    std::unique_ptr<current::variant::object_base_t>& into;
-    TypeAwareMove(std::unique_ptr<current::variant::object_base_t>& from,
-                  std::unique_ptr<current::variant::object_base_t>& into)
-        : from(from), into(into) {}
+    // The object is taken over if it lives on the heap, and is moved from if it is inline.
+    // It is not released from its `Variant` here, as the move operation in `operator()` may still throw.
+    VariantImpl& into;
+    const bool from_heap;
+    TypeAwareMove(VariantImpl& into, bool from_heap) : into(into), from_heap(from_heap) {}
 
 #ifdef VARIANT_CHECKS_AT_RUNTIME_INSTEAD_OF_COMPILE_TIME
     template <typename U>
-    void operator()(U&&) {
+    void operator()(U& instance) {
       using decayed_u = current::decay<U>;
       variant::RuntimeTypeListHelpers<typelist_t>::template AssertContains<decayed_u>();
-      into = std::move(from);
+      Move<decayed_u>(instance);
     }
 #else
     template <typename U>
-    std::enable_if_t<TypeListContains<typelist_t, current::decay<U>>::value> operator()(U&&) {
-      into = std::move(from);
+    std::enable_if_t<TypeListContains<typelist_t, current::decay<U>>::value> operator()(U& instance) {
+      Move<current::decay<U>>(instance);
     }
 
     template <typename U>
-    std::enable_if_t<!TypeListContains<typelist_t, current::decay<U>>::value> operator()(U&&) {
+    std::enable_if_t<!TypeListContains<typelist_t, current::decay<U>>::value> operator()(U&) {
       CURRENT_THROW(IncompatibleVariantTypeException<current::decay<U>>());
     }
 #endif  // VARIANT_CHECKS_AT_RUNTIME_INSTEAD_OF_COMPILE_TIME
+
+    template <typename U>
+    void Move(U& instance) {
+      if (from_heap) {
+        into.object_ = &instance;
+        into.type_index_ = TypeListIndex<typelist_t, U>::value;
+      } else {
+        into.template Emplace<U>(std::move(instance));
+      }
+    }
   };
 
   template <typename... RHS>
   void CopyFrom(const VariantImpl<RHS...>& rhs) {
     if (rhs.object_) {
-      TypeAwareClone cloner(object_);
+      TypeAwareClone cloner(*this);
       rhs.Call(cloner);
     } else {
-      object_ = nullptr;
+      Reset();
     }
   }
 
+  // Must be called with no object held.
   template <typename... RHS>
   void MoveFrom(VariantImpl<RHS...>&& rhs) {
     if (rhs.object_) {
-      TypeAwareMove mover(rhs.object_, object_);
+      const bool from_heap = !rhs.move_inline_;
+      TypeAwareMove mover(*this, from_heap);
       rhs.Call(mover);
+      if (from_heap) {
+        rhs.object_ = nullptr;
+        rhs.type_index_ = VariantImpl<RHS...>::typelist_size;
+      } else {
+        rhs.Reset();
+      }
+    }
+  }
+
+  // Must be called with no object held.
+  void MoveFromSameType(VariantImpl& rhs) noexcept {
+    if (rhs.object_) {
+      if (rhs.move_inline_) {
+        object_ = rhs.move_inline_(*rhs.object_, storage_);
+        move_inline_ = rhs.move_inline_;
+        type_index_ = rhs.type_index_;
+        rhs.Reset();
+      } else {
+        object_ = rhs.object_;
+        type_index_ = rhs.type_index_;
+        rhs.object_ = nullptr;
+        rhs.type_index_ = typelist_size;
+      }
+    }
+  }
+
+  // Returns `typelist_size` for a null object, as well as for the object of a type not listed in `typelist_t`.
+  static size_t TypeIndexOf(const current::variant::object_base_t* object) {
+    if (object) {
+      static const std::type_info* const types[] = {&typeid(TYPES)...};
+      const std::type_info& type = typeid(*object);
+      for (size_t i = 0u; i < typelist_size; ++i) {
+        if (*types[i] == type) {
+          return i;
+        }
+      }
+    }
+    return typelist_size;
+  }
+
+  // Returns the object if it is of type `X` exactly, and `nullptr` otherwise.
+  template <typename X>
+  std::enable_if_t<TypeListContains<typelist_t, X>::value, X*> ExactTypePtr() const {
+    return type_index_ == TypeListIndex<typelist_t, X>::value ? static_cast<X*>(object_) : nullptr;
+  }
+
+  template <typename X>
+  std::enable_if_t<!TypeListContains<typelist_t, X>::value, X*> ExactTypePtr() const {
+    return nullptr;
+  }
+
+  // The table of functions to invoke the visitor of type `F` on the object, one per type of `typelist_t`.
+  // Just as with `RTTIDynamicCall`, the visitor is invoked with a mutable reference even from `Call() const`.
+  template <typename F>
+  struct DispatchTable {
+    using handler_t = void (*)(current::variant::object_base_t&, F&);
+
+    template <typename T>
+    static void Handle(current::variant::object_base_t& object, F& f) {
+      f(static_cast<T&>(object));
+    }
+
+    static handler_t Handler(size_t type_index) {
+      static const handler_t handlers[] = {&DispatchTable::template Handle<TYPES>...};
+      return handlers[type_index];
+    }
+  };
+
+  template <typename F>
+  void Dispatch(F&& f) const {
+    if (type_index_ < typelist_size) {
+      DispatchTable<typename std::remove_reference<F>::type>::Handler(type_index_)(*object_, f);
     } else {
-      object_ = nullptr;
+      // The type of the object is not in `typelist_t`, let `RTTIDynamicCall` throw the proper exception.
+      current::metaprogramming::RTTIDynamicCall<typelist_t>(*object_, std::forward<F>(f));
     }
   }
 
  private:
-  std::unique_ptr<current::variant::object_base_t> object_;
+  storage_t storage_;
+  current::variant::object_base_t* object_ = nullptr;  // Points either into `storage_`, or to the heap.
+  move_inline_t move_inline_ = nullptr;                // Set if and only if `object_` points into `storage_`.
+  size_t type_index_ = typelist_size;                  // The index of the type of `object_` in `typelist_t`.
 };
 
 // `Variant<...>` can accept either a list of types, or a `TypeList<...>`.
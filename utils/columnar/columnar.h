@@ -0,0 +1,875 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2016 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+// Columnar, struct-of-arrays, export and scan of `CURRENT_STRUCT` entries, for ad-hoc analytics over streams.
+//
+// `ColumnarWriter<T>` walks the fields of `T` via reflection and writes each into a file of its own, so that
+// an aggregation only reads the columns it needs, and runs over a plain array of values:
+// * primitives, enums, and `std::chrono::microseconds` / `milliseconds` are stored as is, fixed width,
+// * strings are dictionary-encoded: a `uint32_t` code per entry, plus the dictionary of distinct values,
+// * the fields of nested `CURRENT_STRUCT`-s become the columns named "outer.inner", the fields of the super first,
+// * an `Optional<>` field adds a bitmap of which entries have the value; missing values are stored as zeroes.
+//
+// `ColumnarReader` loads the columns back, type-checked against `manifest.json`, and the free functions
+// below, `Sum()`, `Min()`, `Where()`, `CountBy()`, etc., aggregate over them.
+//
+//   {
+//     current::columnar::ColumnarWriter<Ride> writer("rides");
+//     writer.AddAll(*stream->Data());
+//   }
+//   current::columnar::ColumnarReader rides("rides");
+//   const auto months = rides.Read<uint8_t>("pickup.month");
+//   const auto fares = rides.Read<int32_t>("fare_amount_cents");
+//   const auto total_fare_by_month = current::columnar::SumBy(months, fares);
+
+#ifndef CURRENT_UTILS_COLUMNAR_COLUMNAR_H
+#define CURRENT_UTILS_COLUMNAR_COLUMNAR_H
+
+#include "../../port.h"
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <unordered_map>
+
+#include "../../typesystem/struct.h"
+#include "../../typesystem/optional.h"
+#include "../../typesystem/reflection/reflection.h"
+#include "../../typesystem/serialization/json.h"
+
+#include "../../bricks/exception.h"
+#include "../../bricks/file/file.h"
+
+namespace current {
+namespace columnar {
+
+struct ColumnarException : Exception {
+  using Exception::Exception;
+};
+
+struct ColumnarFileException : ColumnarException {
+  using ColumnarException::ColumnarException;
+};
+
+struct ColumnarColumnNotFoundException : ColumnarException {
+  using ColumnarException::ColumnarException;
+};
+
+struct ColumnarColumnTypeMismatchException : ColumnarException {
+  using ColumnarException::ColumnarException;
+};
+
+CURRENT_STRUCT(ColumnDescription) {
+  CURRENT_FIELD(name, std::string);
+  CURRENT_FIELD(type, std::string);
+  CURRENT_FIELD(type_id, reflection::TypeID);
+  CURRENT_FIELD(bytes_per_value, uint32_t, 0u);
+  CURRENT_FIELD(dictionary, bool, false);
+  CURRENT_FIELD(nullable, bool, false);
+};
+
+CURRENT_STRUCT(ColumnarManifest) {
+  CURRENT_FIELD(rows, uint64_t, 0u);
+  CURRENT_FIELD(columns, std::vector<ColumnDescription>);
+};
+
+constexpr static const char* kColumnarManifestFileName = "manifest.json";
+
+namespace impl {
+
+inline std::string ValuesFileName(const std::string& directory, const std::string& column) {
+  return FileSystem::JoinPath(directory, column + ".values");
+}
+
+inline std::string PresenceFileName(const std::string& directory, const std::string& column) {
+  return FileSystem::JoinPath(directory, column + ".present");
+}
+
+inline std::string DictionaryFileName(const std::string& directory, const std::string& column) {
+  return FileSystem::JoinPath(directory, column + ".dictionary");
+}
+
+// Buffers and writes the files of one column.
+class ColumnSink final {
+ public:
+  ColumnSink(const std::string& directory, const ColumnDescription& column)
+      : bytes_per_value_(column.bytes_per_value),
+        nullable_(column.nullable),
+        values_(ValuesFileName(directory, column.name), std::ofstream::binary) {
+    if (!values_.good()) {
+      CURRENT_THROW(ColumnarFileException("Can not write `" + ValuesFileName(directory, column.name) + "`."));
+    }
+    if (nullable_) {
+      present_.open(PresenceFileName(directory, column.name), std::ofstream::binary);
+      if (!present_.good()) {
+        CURRENT_THROW(ColumnarFileException("Can not write `" + PresenceFileName(directory, column.name) + "`."));
+      }
+    }
+    if (column.dictionary) {
+      dictionary_file_name_ = DictionaryFileName(directory, column.name);
+    }
+  }
+
+  template <typename X>
+  void Write(const X& value) {
+    values_buffer_.append(reinterpret_cast<const char*>(&value), sizeof(X));
+    MarkPresent(true);
+  }
+
+  void WriteString(const std::string& value) {
+    const auto it = codes_.find(value);
+    if (it != codes_.end()) {
+      Write(it->second);
+    } else {
+      const uint32_t code = static_cast<uint32_t>(dictionary_.size());
+      codes_.emplace(value, code);
+      dictionary_.push_back(value);
+      Write(code);
+    }
+  }
+
+  void WriteMissing() {
+    values_buffer_.append(bytes_per_value_, '\0');
+    MarkPresent(false);
+  }
+
+  void Close() {
+    Flush(true);
+    if (!dictionary_file_name_.empty()) {
+      std::ofstream fo(dictionary_file_name_, std::ofstream::binary);
+      for (const std::string& word : dictionary_) {
+        const uint32_t length = static_cast<uint32_t>(word.length());
+        fo.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        fo.write(word.data(), word.length());
+      }
+      if (!fo.good()) {
+        CURRENT_THROW(ColumnarFileException("Can not write `" + dictionary_file_name_ + "`."));
+      }
+    }
+    if (!values_.good() || (nullable_ && !present_.good())) {
+      CURRENT_THROW(ColumnarFileException("Failed to write a column file."));
+    }
+  }
+
+ private:
+  void MarkPresent(bool present) {
+    if (nullable_) {
+      if (present) {
+        present_bits_ |= static_cast<uint8_t>(1u << present_count_);
+      }
+      if (++present_count_ == 8u) {
+        present_buffer_.push_back(static_cast<char>(present_bits_));
+        present_bits_ = 0u;
+        present_count_ = 0u;
+      }
+    }
+    if (values_buffer_.length() >= kFlushThreshold) {
+      Flush(false);
+    }
+  }
+
+  void Flush(bool last) {
+    values_.write(values_buffer_.data(), values_buffer_.length());
+    values_buffer_.clear();
+    if (nullable_) {
+      if (last && present_count_) {
+        present_buffer_.push_back(static_cast<char>(present_bits_));
+      }
+      present_.write(present_buffer_.data(), present_buffer_.length());
+      present_buffer_.clear();
+    }
+  }
+
+  constexpr static size_t kFlushThreshold = 1u << 16;
+
+  const size_t bytes_per_value_;
+  const bool nullable_;
+  std::ofstream values_;
+  std::ofstream present_;
+  std::string values_buffer_;
+  std::string present_buffer_;
+  uint8_t present_bits_ = 0u;
+  uint32_t present_count_ = 0u;
+  std::string dictionary_file_name_;
+  std::unordered_map<std::string, uint32_t> codes_;
+  std::vector<std::string> dictionary_;
+};
+
+// Walks the columns of an entry in the same order as `ColumnarField<T>::Describe()` has listed them.
+struct ColumnCursor final {
+  std::unique_ptr<ColumnSink>* next;
+  ColumnSink& Next() { return **next++; }
+};
+
+template <typename X>
+struct IsFixedWidthColumn {
+  constexpr static bool value = std::is_arithmetic<X>::value || std::is_enum<X>::value ||
+                                std::is_same<X, std::chrono::microseconds>::value ||
+                                std::is_same<X, std::chrono::milliseconds>::value;
+};
+
+inline std::string ColumnName(const std::string& prefix, const char* name) {
+  return prefix.empty() ? name : prefix + '.' + name;
+}
+
+template <typename X, typename ENABLE = void>
+struct ColumnarField {
+  static_assert(sizeof(X) == 0u,
+                "Only primitives, enums, strings, `Optional<>`-s and nested `CURRENT_STRUCT`-s can be columns.");
+};
+
+template <typename X>
+struct ColumnarField<X, std::enable_if_t<IsFixedWidthColumn<X>::value>> {
+  static void Describe(const std::string& name, bool nullable, std::vector<ColumnDescription>& columns) {
+    columns.push_back(ColumnDescription());
+    ColumnDescription& column = columns.back();
+    column.name = name;
+    column.type = reflection::CurrentTypeName<X>();
+    column.type_id = reflection::CurrentTypeID<X>();
+    column.bytes_per_value = static_cast<uint32_t>(sizeof(X));
+    column.nullable = nullable;
+  }
+  static void Write(const X& value, ColumnCursor& cursor) { cursor.Next().Write(value); }
+  static void WriteMissing(ColumnCursor& cursor) { cursor.Next().WriteMissing(); }
+};
+
+template <>
+struct ColumnarField<std::string> {
+  static void Describe(const std::string& name, bool nullable, std::vector<ColumnDescription>& columns) {
+    columns.push_back(ColumnDescription());
+    ColumnDescription& column = columns.back();
+    column.name = name;
+    column.type = reflection::CurrentTypeName<std::string>();
+    column.type_id = reflection::CurrentTypeID<std::string>();
+    column.bytes_per_value = static_cast<uint32_t>(sizeof(uint32_t));
+    column.dictionary = true;
+    column.nullable = nullable;
+  }
+  static void Write(const std::string& value, ColumnCursor& cursor) { cursor.Next().WriteString(value); }
+  static void WriteMissing(ColumnCursor& cursor) { cursor.Next().WriteMissing(); }
+};
+
+template <typename X>
+struct ColumnarField<Optional<X>> {
+  static void Describe(const std::string& name, bool, std::vector<ColumnDescription>& columns) {
+    ColumnarField<X>::Describe(name, true, columns);
+  }
+  static void Write(const Optional<X>& value, ColumnCursor& cursor) {
+    if (Exists(value)) {
+      ColumnarField<X>::Write(Value(value), cursor);
+    } else {
+      ColumnarField<X>::WriteMissing(cursor);
+    }
+  }
+  static void WriteMissing(ColumnCursor& cursor) { ColumnarField<X>::WriteMissing(cursor); }
+};
+
+template <typename X>
+struct ColumnarStructFields {
+  struct Describer final {
+    const std::string& prefix;
+    const bool nullable;
+    std::vector<ColumnDescription>& columns;
+    template <typename F>
+    void operator()(reflection::TypeSelector<F>, const char* name) const {
+      ColumnarField<F>::Describe(ColumnName(prefix, name), nullable, columns);
+    }
+  };
+
+  struct Writer final {
+    ColumnCursor& cursor;
+    template <typename F>
+    void operator()(const char*, const F& value) const {
+      ColumnarField<F>::Write(value, cursor);
+    }
+  };
+
+  struct MissingWriter final {
+    ColumnCursor& cursor;
+    template <typename F>
+    void operator()(reflection::TypeSelector<F>, const char*) const {
+      ColumnarField<F>::WriteMissing(cursor);
+    }
+  };
+
+  static void Describe(const std::string& prefix, bool nullable, std::vector<ColumnDescription>& columns) {
+    ColumnarStructFields<reflection::SuperType<X>>::Describe(prefix, nullable, columns);
+    reflection::VisitAllFields<X, reflection::FieldTypeAndName>::WithoutObject(Describer{prefix, nullable, columns});
+  }
+  static void Write(const X& value, ColumnCursor& cursor) {
+    ColumnarStructFields<reflection::SuperType<X>>::Write(value, cursor);
+    reflection::VisitAllFields<X, reflection::FieldNameAndImmutableValue>::WithObject(value, Writer{cursor});
+  }
+  static void WriteMissing(ColumnCursor& cursor) {
+    ColumnarStructFields<reflection::SuperType<X>>::WriteMissing(cursor);
+    reflection::VisitAllFields<X, reflection::FieldTypeAndName>::WithoutObject(MissingWriter{cursor});
+  }
+};
+
+template <>
+struct ColumnarStructFields<CurrentStruct> {
+  static void Describe(const std::string&, bool, std::vector<ColumnDescription>&) {}
+  static void Write(const CurrentStruct&, ColumnCursor&) {}
+  static void WriteMissing(ColumnCursor&) {}
+};
+
+template <typename X>
+struct ColumnarField<X, std::enable_if_t<IS_CURRENT_STRUCT(X)>> : ColumnarStructFields<X> {};
+
+// The number of set bits, for the presence bitmaps.
+inline uint64_t PopCount(uint8_t bits) {
+#ifdef __GNUC__
+  return static_cast<uint64_t>(__builtin_popcount(bits));
+#else
+  uint64_t result = 0u;
+  for (; bits; bits &= static_cast<uint8_t>(bits - 1u)) {
+    ++result;
+  }
+  return result;
+#endif
+}
+
+}  // namespace current::columnar::impl
+
+// Writes the entries of type `T` into the per-field column files in `directory`.
+// The files are complete, and `manifest.json` is written, on `Close()`, or when the writer goes out of scope.
+template <typename T>
+class ColumnarWriter final {
+ public:
+  static_assert(IS_CURRENT_STRUCT(T), "`ColumnarWriter` must be used with the type defined via `CURRENT_STRUCT`.");
+
+  explicit ColumnarWriter(const std::string& directory) : directory_(directory) {
+    FileSystem::MkDir(directory_, FileSystem::MkDirParameters::Silent);
+    impl::ColumnarField<T>::Describe("", false, manifest_.columns);
+    sinks_.reserve(manifest_.columns.size());
+    for (const ColumnDescription& column : manifest_.columns) {
+      sinks_.emplace_back(std::make_unique<impl::ColumnSink>(directory_, column));
+    }
+  }
+
+  ~ColumnarWriter() {
+    if (!closed_) {
+      try {
+        Close();
+      } catch (const Exception&) {
+        // The manifest is not written, so the incomplete export can not be read.
+      }
+    }
+  }
+
+  ColumnarWriter(const ColumnarWriter&) = delete;
+  ColumnarWriter& operator=(const ColumnarWriter&) = delete;
+
+  void Add(const T& entry) {
+    CURRENT_ASSERT(!closed_);
+    impl::ColumnCursor cursor{sinks_.data()};
+    impl::ColumnarField<T>::Write(entry, cursor);
+    ++manifest_.rows;
+  }
+
+  // Exports a stream, `writer.AddAll(*stream->Data())`, or any other persister, such as a `persistence::File<T>`.
+  template <typename PERSISTER>
+  void AddAll(const PERSISTER& persister) {
+    for (const auto& e : persister.Iterate()) {
+      Add(e.entry);
+    }
+  }
+
+  uint64_t Size() const { return manifest_.rows; }
+
+  void Close() {
+    CURRENT_ASSERT(!closed_);
+    closed_ = true;
+    for (auto& sink : sinks_) {
+      sink->Close();
+    }
+    sinks_.clear();
+    const std::string file_name = FileSystem::JoinPath(directory_, kColumnarManifestFileName);
+    try {
+      FileSystem::WriteStringToFile(JSON(manifest_), file_name.c_str());
+    } catch (const FileException&) {
+      CURRENT_THROW(ColumnarFileException("Can not write `" + file_name + "`."));
+    }
+  }
+
+ private:
+  const std::string directory_;
+  ColumnarManifest manifest_;
+  std::vector<std::unique_ptr<impl::ColumnSink>> sinks_;
+  bool closed_ = false;
+};
+
+// The bitmap of which entries of a nullable column have values; all of them do for a non-nullable one.
+class ColumnPresence {
+ public:
+  bool Nullable() const { return nullable_; }
+  bool Has(size_t i) const { return !nullable_ || ((present_[i >> 3] >> (i & 7u)) & 1u); }
+  const std::vector<uint8_t>& PresenceBitmap() const { return present_; }
+
+ protected:
+  friend class ColumnarReader;
+  bool nullable_ = false;
+  std::vector<uint8_t> present_;
+};
+
+// Not an `std::vector<X>`, to keep `Data()` for `bool`-s.
+template <typename X>
+class Column final : public ColumnPresence {
+ public:
+  using value_t = X;
+
+  size_t Size() const { return size_; }
+  const X* Data() const { return values_.get(); }
+  const X& operator[](size_t i) const { return values_[i]; }
+  const X* begin() const { return values_.get(); }
+  const X* end() const { return values_.get() + size_; }
+
+ private:
+  friend class ColumnarReader;
+  size_t size_ = 0u;
+  std::unique_ptr<X[]> values_;
+};
+
+template <>
+class Column<std::string> final : public ColumnPresence {
+ public:
+  using value_t = std::string;
+
+  size_t Size() const { return codes_.size(); }
+  uint32_t Code(size_t i) const { return codes_[i]; }
+  const std::vector<uint32_t>& Codes() const { return codes_; }
+  const std::vector<std::string>& Dictionary() const { return dictionary_; }
+  // Must only be called for the entries that have a value, see `Has()`.
+  const std::string& operator[](size_t i) const { return dictionary_[codes_[i]]; }
+
+ private:
+  friend class ColumnarReader;
+  std::vector<uint32_t> codes_;
+  std::vector<std::string> dictionary_;
+};
+
+// Reads the columns written by `ColumnarWriter<T>`. Does not need `T` itself.
+class ColumnarReader final {
+ public:
+  explicit ColumnarReader(const std::string& directory) : directory_(directory) {
+    const std::string file_name = FileSystem::JoinPath(directory_, kColumnarManifestFileName);
+    try {
+      manifest_ = ParseJSON<ColumnarManifest>(FileSystem::ReadFileAsString(file_name));
+    } catch (const FileException&) {
+      CURRENT_THROW(ColumnarFileException("Can not read `" + file_name + "`."));
+    }
+  }
+
+  const ColumnarManifest& Manifest() const { return manifest_; }
+  uint64_t Size() const { return manifest_.rows; }
+
+  bool Has(const std::string& name) const { return Find(name) != nullptr; }
+
+  template <typename X>
+  Column<X> Read(const std::string& name) const {
+    const ColumnDescription& column = FindOrThrow<X>(name);
+    Column<X> result;
+    ReadFile(ValuesFileName(column), sizeof(X) * manifest_.rows, [&result](size_t bytes) {
+      result.size_ = bytes / sizeof(X);
+      result.values_.reset(new X[result.size_]);
+      return reinterpret_cast<char*>(result.values_.get());
+    });
+    ReadPresence(column, result);
+    return result;
+  }
+
+ private:
+  const ColumnDescription* Find(const std::string& name) const {
+    for (const ColumnDescription& column : manifest_.columns) {
+      if (column.name == name) {
+        return &column;
+      }
+    }
+    return nullptr;
+  }
+
+  template <typename X>
+  const ColumnDescription& FindOrThrow(const std::string& name) const {
+    const ColumnDescription* column = Find(name);
+    if (!column) {
+      CURRENT_THROW(ColumnarColumnNotFoundException("No column `" + name + "` in `" + directory_ + "`."));
+    }
+    if (column->type_id != reflection::CurrentTypeID<X>()) {
+      CURRENT_THROW(ColumnarColumnTypeMismatchException("Column `" + name + "` is of type `" + column->type +
+                                                        "`, not `" + reflection::CurrentTypeName<X>() + "`."));
+    }
+    return *column;
+  }
+
+  std::string ValuesFileName(const ColumnDescription& column) const {
+    return impl::ValuesFileName(directory_, column.name);
+  }
+
+  void ReadPresence(const ColumnDescription& column, ColumnPresence& presence) const {
+    presence.nullable_ = column.nullable;
+    if (column.nullable) {
+      ReadFile(impl::PresenceFileName(directory_, column.name), (manifest_.rows + 7u) / 8u, [&presence](size_t bytes) {
+        presence.present_.resize(bytes);
+        return reinterpret_cast<char*>(presence.present_.data());
+      });
+    }
+  }
+
+  template <typename F>
+  void ReadFile(const std::string& file_name, uint64_t expected_bytes, F&& allocate) const {
+    std::ifstream fi(file_name, std::ifstream::binary);
+    if (!fi.good()) {
+      CURRENT_THROW(ColumnarFileException("Can not read `" + file_name + "`."));
+    }
+    fi.seekg(0, std::ifstream::end);
+    const uint64_t bytes = static_cast<uint64_t>(fi.tellg());
+    if (bytes != expected_bytes) {
+      CURRENT_THROW(ColumnarFileException("Unexpected size of `" + file_name + "`."));
+    }
+    fi.seekg(0, std::ifstream::beg);
+    if (bytes && !fi.read(allocate(static_cast<size_t>(bytes)), static_cast<std::streamsize>(bytes))) {
+      CURRENT_THROW(ColumnarFileException("Can not read `" + file_name + "`."));
+    }
+  }
+
+  void ReadDictionary(const ColumnDescription& column, std::vector<std::string>& dictionary) const {
+    const std::string file_name = impl::DictionaryFileName(directory_, column.name);
+    const std::string contents = FileSystem::ReadFileAsString(file_name);
+    size_t offset = 0u;
+    while (offset < contents.length()) {
+      uint32_t length;
+      if (offset + sizeof(length) > contents.length()) {
+        CURRENT_THROW(ColumnarFileException("Malformed `" + file_name + "`."));
+      }
+      std::memcpy(&length, contents.data() + offset, sizeof(length));
+      offset += sizeof(length);
+      if (offset + length > contents.length()) {
+        CURRENT_THROW(ColumnarFileException("Malformed `" + file_name + "`."));
+      }
+      dictionary.emplace_back(contents.data() + offset, length);
+      offset += length;
+    }
+  }
+
+  const std::string directory_;
+  ColumnarManifest manifest_;
+};
+
+template <>
+inline Column<std::string> ColumnarReader::Read<std::string>(const std::string& name) const {
+  const ColumnDescription& column = FindOrThrow<std::string>(name);
+  Column<std::string> result;
+  ReadFile(ValuesFileName(column), sizeof(uint32_t) * manifest_.rows, [&result](size_t bytes) {
+    result.codes_.resize(bytes / sizeof(uint32_t));
+    return reinterpret_cast<char*>(result.codes_.data());
+  });
+  ReadDictionary(column, result.dictionary_);
+  ReadPresence(column, result);
+  for (size_t i = 0u; i < result.codes_.size(); ++i) {
+    if (result.Has(i) && result.codes_[i] >= result.dictionary_.size()) {
+      CURRENT_THROW(ColumnarFileException("Malformed dictionary of column `" + name + "`."));
+    }
+  }
+  return result;
+}
+
+// The aggregations. The loops run over the plain arrays of values, and branch-free where possible, so that
+// the compiler vectorizes them.
+
+// The rows to aggregate over, one byte per row, `0` or `1`.
+using Selection = std::vector<uint8_t>;
+
+template <typename X>
+using sum_t = typename std::conditional<std::is_floating_point<X>::value,
+                                        double,
+                                        typename std::conditional<std::is_signed<X>::value, int64_t, uint64_t>::type>::type;
+
+// The rows for which `predicate(value)` is `true`. The rows with no value are not selected.
+template <typename X, typename F>
+Selection Where(const Column<X>& column, F&& predicate) {
+  const size_t n = column.Size();
+  Selection selection(n);
+  const X* values = column.Data();
+  for (size_t i = 0u; i < n; ++i) {
+    selection[i] = static_cast<uint8_t>(predicate(values[i]) ? 1u : 0u);
+  }
+  if (column.Nullable()) {
+    for (size_t i = 0u; i < n; ++i) {
+      selection[i] &= static_cast<uint8_t>(column.Has(i));
+    }
+  }
+  return selection;
+}
+
+// For strings, `predicate` is called once per distinct value.
+template <typename F>
+Selection Where(const Column<std::string>& column, F&& predicate) {
+  const auto& dictionary = column.Dictionary();
+  Selection matches(dictionary.size());
+  for (size_t code = 0u; code < dictionary.size(); ++code) {
+    matches[code] = static_cast<uint8_t>(predicate(dictionary[code]) ? 1u : 0u);
+  }
+  const size_t n = column.Size();
+  Selection selection(n);
+  const uint32_t* codes = column.Codes().data();
+  for (size_t i = 0u; i < n; ++i) {
+    selection[i] = column.Has(i) ? matches[codes[i]] : static_cast<uint8_t>(0u);
+  }
+  return selection;
+}
+
+inline Selection And(const Selection& lhs, const Selection& rhs) {
+  CURRENT_ASSERT(lhs.size() == rhs.size());
+  Selection result(lhs.size());
+  for (size_t i = 0u; i < lhs.size(); ++i) {
+    result[i] = lhs[i] & rhs[i];
+  }
+  return result;
+}
+
+inline uint64_t Count(const Selection& selection) {
+  uint64_t count = 0u;
+  for (const uint8_t s : selection) {
+    count += s;
+  }
+  return count;
+}
+
+// The number of rows which have a value.
+template <typename X>
+uint64_t Count(const Column<X>& column) {
+  if (!column.Nullable()) {
+    return column.Size();
+  }
+  uint64_t count = 0u;
+  for (const uint8_t bits : column.PresenceBitmap()) {
+    count += impl::PopCount(bits);
+  }
+  return count;
+}
+
+// Missing values are stored as zeroes, so the sums need not look at the presence bitmap.
+template <typename X>
+sum_t<X> Sum(const Column<X>& column) {
+  static_assert(std::is_arithmetic<X>::value, "`Sum()` is only defined for numeric columns.");
+  const size_t n = column.Size();
+  const X* values = column.Data();
+  sum_t<X> sum = 0;
+  for (size_t i = 0u; i < n; ++i) {
+    sum += static_cast<sum_t<X>>(values[i]);
+  }
+  return sum;
+}
+
+template <typename X>
+sum_t<X> Sum(const Column<X>& column, const Selection& selection) {
+  static_assert(std::is_arithmetic<X>::value, "`Sum()` is only defined for numeric columns.");
+  CURRENT_ASSERT(selection.size() == column.Size());
+  const size_t n = column.Size();
+  const X* values = column.Data();
+  sum_t<X> sum = 0;
+  for (size_t i = 0u; i < n; ++i) {
+    sum += selection[i] ? static_cast<sum_t<X>>(values[i]) : static_cast<sum_t<X>>(0);
+  }
+  return sum;
+}
+
+template <typename X>
+Optional<double> Mean(const Column<X>& column) {
+  const uint64_t count = Count(column);
+  return count ? Optional<double>(static_cast<double>(Sum(column)) / count) : Optional<double>();
+}
+
+template <typename X>
+Optional<double> Mean(const Column<X>& column, const Selection& selection) {
+  CURRENT_ASSERT(selection.size() == column.Size());
+  uint64_t count = 0u;
+  for (size_t i = 0u; i < selection.size(); ++i) {
+    count += static_cast<uint64_t>(selection[i] && column.Has(i));
+  }
+  return count ? Optional<double>(static_cast<double>(Sum(column, selection)) / count) : Optional<double>();
+}
+
+namespace impl {
+
+template <typename X, typename F>
+Optional<X> Reduce(const Column<X>& column, const Selection* selection, F&& better) {
+  const size_t n = column.Size();
+  const X* values = column.Data();
+  if (!column.Nullable() && !selection) {
+    if (!n) {
+      return nullptr;
+    }
+    X result = values[0];
+    for (size_t i = 1u; i < n; ++i) {
+      result = better(values[i], result) ? values[i] : result;
+    }
+    return result;
+  }
+  Optional<X> result;
+  for (size_t i = 0u; i < n; ++i) {
+    if ((!selection || (*selection)[i]) && column.Has(i) && (!Exists(result) || better(values[i], Value(result)))) {
+      result = values[i];
+    }
+  }
+  return result;
+}
+
+struct Less final {
+  template <typename X>
+  bool operator()(const X& a, const X& b) const {
+    return a < b;
+  }
+};
+
+struct Greater final {
+  template <typename X>
+  bool operator()(const X& a, const X& b) const {
+    return b < a;
+  }
+};
+
+// Groups the rows by a key of one or two bytes via an array, and by any other key via an `std::map`.
+template <typename K, bool DENSE = (sizeof(K) <= 2u) && !std::is_floating_point<K>::value>
+struct GroupBy final {
+  using bits_t = typename std::conditional<sizeof(K) == 1u, uint8_t, uint16_t>::type;
+  template <typename A, typename F>
+  static std::map<K, A> Run(const Column<K>& keys, const Selection* selection, F&& value) {
+    std::vector<A> accumulators(static_cast<size_t>(std::numeric_limits<bits_t>::max()) + 1u);
+    std::vector<uint8_t> seen(accumulators.size());
+    const K* data = keys.Data();
+    for (size_t i = 0u; i < keys.Size(); ++i) {
+      if ((!selection || (*selection)[i]) && keys.Has(i)) {
+        const size_t bucket = static_cast<size_t>(static_cast<bits_t>(data[i]));
+        accumulators[bucket] += value(i);
+        seen[bucket] = 1u;
+      }
+    }
+    std::map<K, A> result;
+    for (size_t bucket = 0u; bucket < accumulators.size(); ++bucket) {
+      if (seen[bucket]) {
+        result[static_cast<K>(static_cast<bits_t>(bucket))] = accumulators[bucket];
+      }
+    }
+    return result;
+  }
+};
+
+template <typename K>
+struct GroupBy<K, false> final {
+  template <typename A, typename F>
+  static std::map<K, A> Run(const Column<K>& keys, const Selection* selection, F&& value) {
+    std::map<K, A> result;
+    const K* data = keys.Data();
+    for (size_t i = 0u; i < keys.Size(); ++i) {
+      if ((!selection || (*selection)[i]) && keys.Has(i)) {
+        result[data[i]] += value(i);
+      }
+    }
+    return result;
+  }
+};
+
+template <>
+struct GroupBy<std::string, false> final {
+  template <typename A, typename F>
+  static std::map<std::string, A> Run(const Column<std::string>& keys, const Selection* selection, F&& value) {
+    const auto& dictionary = keys.Dictionary();
+    std::vector<A> accumulators(dictionary.size());
+    std::vector<uint8_t> seen(dictionary.size());
+    const uint32_t* codes = keys.Codes().data();
+    for (size_t i = 0u; i < keys.Size(); ++i) {
+      if ((!selection || (*selection)[i]) && keys.Has(i)) {
+        accumulators[codes[i]] += value(i);
+        seen[codes[i]] = 1u;
+      }
+    }
+    std::map<std::string, A> result;
+    for (size_t code = 0u; code < dictionary.size(); ++code) {
+      if (seen[code]) {
+        result[dictionary[code]] = accumulators[code];
+      }
+    }
+    return result;
+  }
+};
+
+template <typename K, typename V>
+std::map<K, sum_t<V>> SumBy(const Column<K>& keys, const Column<V>& values, const Selection* selection) {
+  static_assert(std::is_arithmetic<V>::value, "`SumBy()` is only defined for numeric columns.");
+  CURRENT_ASSERT(keys.Size() == values.Size());
+  const V* data = values.Data();
+  return GroupBy<K>::template Run<sum_t<V>>(
+      keys, selection, [data](size_t i) { return static_cast<sum_t<V>>(data[i]); });
+}
+
+}  // namespace current::columnar::impl
+
+template <typename X>
+Optional<X> Min(const Column<X>& column) {
+  return impl::Reduce(column, nullptr, impl::Less());
+}
+
+template <typename X>
+Optional<X> Min(const Column<X>& column, const Selection& selection) {
+  return impl::Reduce(column, &selection, impl::Less());
+}
+
+template <typename X>
+Optional<X> Max(const Column<X>& column) {
+  return impl::Reduce(column, nullptr, impl::Greater());
+}
+
+template <typename X>
+Optional<X> Max(const Column<X>& column, const Selection& selection) {
+  return impl::Reduce(column, &selection, impl::Greater());
+}
+
+// The number of rows per key. The rows with no key are skipped.
+template <typename K>
+std::map<K, uint64_t> CountBy(const Column<K>& keys) {
+  return impl::GroupBy<K>::template Run<uint64_t>(keys, nullptr, [](size_t) { return 1u; });
+}
+
+template <typename K>
+std::map<K, uint64_t> CountBy(const Column<K>& keys, const Selection& selection) {
+  return impl::GroupBy<K>::template Run<uint64_t>(keys, &selection, [](size_t) { return 1u; });
+}
+
+// The sums of `values` per key. The rows with no key are skipped, and the rows with no value count as zero.
+template <typename K, typename V>
+std::map<K, sum_t<V>> SumBy(const Column<K>& keys, const Column<V>& values) {
+  return impl::SumBy(keys, values, nullptr);
+}
+
+template <typename K, typename V>
+std::map<K, sum_t<V>> SumBy(const Column<K>& keys, const Column<V>& values, const Selection& selection) {
+  return impl::SumBy(keys, values, &selection);
+}
+
+}  // namespace current::columnar
+}  // namespace current
+
+#endif  // CURRENT_UTILS_COLUMNAR_COLUMNAR_H
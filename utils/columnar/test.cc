@@ -0,0 +1,276 @@
+/*******************************************************************************
+The MIT License (MIT)
+
+Copyright (c) 2016 Dmitry "Dima" Korolev <dmitry.korolev@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+
+#include "columnar.h"
+
+#include "../../blocks/persistence/memory.h"
+#include "../../bricks/dflags/dflags.h"
+#include "../../3rdparty/gtest/gtest-main-with-dflags.h"
+
+DEFINE_string(columnar_test_tmpdir, ".current", "Local path for the test to create temporary files in.");
+
+namespace columnar_test {
+
+CURRENT_ENUM(Vendor, uint8_t){Yellow = 1u, Green = 2u};
+
+CURRENT_STRUCT(Timestamp) {
+  CURRENT_FIELD(month, uint8_t);
+  CURRENT_FIELD(hour, uint8_t);
+};
+
+CURRENT_STRUCT(Record) { CURRENT_FIELD(id, uint32_t); };
+
+CURRENT_STRUCT(Ride, Record) {
+  CURRENT_FIELD(pickup, Timestamp);
+  CURRENT_FIELD(dropoff, Optional<Timestamp>);
+  CURRENT_FIELD(vendor, Vendor);
+  CURRENT_FIELD(payment, std::string);
+  CURRENT_FIELD(fare_cents, int32_t);
+  CURRENT_FIELD(tip_cents, Optional<int32_t>);
+  CURRENT_FIELD(distance, double);
+  CURRENT_FIELD(note, Optional<std::string>);
+  CURRENT_FIELD(shared, bool);
+  CURRENT_FIELD(us, std::chrono::microseconds);
+};
+
+inline Ride MakeRide(uint32_t i) {
+  Ride ride;
+  ride.id = i;
+  ride.pickup.month = static_cast<uint8_t>(1u + i % 12u);
+  ride.pickup.hour = static_cast<uint8_t>(i % 24u);
+  if (i % 3u) {
+    ride.dropoff = Timestamp();
+    Value(ride.dropoff).month = ride.pickup.month;
+    Value(ride.dropoff).hour = static_cast<uint8_t>((i + 1u) % 24u);
+  }
+  ride.vendor = (i % 4u) ? Vendor::Yellow : Vendor::Green;
+  ride.payment = (i % 2u) ? "card" : "cash";
+  ride.fare_cents = static_cast<int32_t>(500u + i);
+  if (i % 5u == 0u) {
+    ride.tip_cents = static_cast<int32_t>(i);
+  }
+  ride.distance = 0.5 * i;
+  if (i % 7u == 0u) {
+    ride.note = "note #" + current::ToString(i / 7u % 3u);
+  }
+  ride.shared = (i % 10u == 0u);
+  ride.us = std::chrono::microseconds(1000000ll * i);
+  return ride;
+}
+
+}  // namespace columnar_test
+
+TEST(Columnar, ExportAndRead) {
+  using namespace columnar_test;
+  using namespace current::columnar;
+
+  const std::string dir = current::FileSystem::JoinPath(FLAGS_columnar_test_tmpdir, "export_and_read");
+  const auto dir_remover = current::FileSystem::ScopedRmDir(dir);
+
+  const uint32_t n = 1000u;
+  {
+    ColumnarWriter<Ride> writer(dir);
+    for (uint32_t i = 0u; i < n; ++i) {
+      writer.Add(MakeRide(i));
+    }
+    EXPECT_EQ(n, writer.Size());
+  }
+
+  const ColumnarReader reader(dir);
+  EXPECT_EQ(n, reader.Size());
+
+  std::vector<std::string> names;
+  for (const auto& column : reader.Manifest().columns) {
+    names.push_back(column.name + (column.nullable ? "?" : "") + (column.dictionary ? "*" : ""));
+  }
+  EXPECT_EQ(
+      "id pickup.month pickup.hour dropoff.month? dropoff.hour? vendor payment* fare_cents tip_cents? distance note?* "
+      "shared us",
+      current::strings::Join(names, ' '));
+
+  const auto id = reader.Read<uint32_t>("id");
+  const auto pickup_month = reader.Read<uint8_t>("pickup.month");
+  const auto dropoff_hour = reader.Read<uint8_t>("dropoff.hour");
+  const auto vendor = reader.Read<Vendor>("vendor");
+  const auto payment = reader.Read<std::string>("payment");
+  const auto fare_cents = reader.Read<int32_t>("fare_cents");
+  const auto tip_cents = reader.Read<int32_t>("tip_cents");
+  const auto distance = reader.Read<double>("distance");
+  const auto note = reader.Read<std::string>("note");
+  const auto shared = reader.Read<bool>("shared");
+  const auto us = reader.Read<std::chrono::microseconds>("us");
+
+  EXPECT_FALSE(payment.Nullable());
+  EXPECT_TRUE(note.Nullable());
+  EXPECT_EQ("cash card", current::strings::Join(payment.Dictionary(), ' '));
+  EXPECT_EQ(3u, note.Dictionary().size());
+
+  for (uint32_t i = 0u; i < n; ++i) {
+    const Ride ride = MakeRide(i);
+    ASSERT_EQ(ride.id, id[i]);
+    ASSERT_EQ(ride.pickup.month, pickup_month[i]);
+    ASSERT_EQ(Exists(ride.dropoff), dropoff_hour.Has(i));
+    ASSERT_EQ(Exists(ride.dropoff) ? Value(ride.dropoff).hour : 0u, dropoff_hour[i]);
+    ASSERT_TRUE(ride.vendor == vendor[i]);
+    ASSERT_EQ(ride.payment, payment[i]);
+    ASSERT_EQ(ride.fare_cents, fare_cents[i]);
+    ASSERT_EQ(Exists(ride.tip_cents), tip_cents.Has(i));
+    ASSERT_EQ(Exists(ride.tip_cents) ? Value(ride.tip_cents) : 0, tip_cents[i]);
+    ASSERT_EQ(ride.distance, distance[i]);
+    ASSERT_EQ(Exists(ride.note), note.Has(i));
+    if (Exists(ride.note)) {
+      ASSERT_EQ(Value(ride.note), note[i]);
+    }
+    ASSERT_EQ(ride.shared, shared[i]);
+    ASSERT_EQ(ride.us.count(), us[i].count());
+  }
+
+  ASSERT_THROW(reader.Read<uint32_t>("no_such_column"), ColumnarColumnNotFoundException);
+  ASSERT_THROW(reader.Read<int64_t>("id"), ColumnarColumnTypeMismatchException);
+  ASSERT_THROW(reader.Read<std::string>("vendor"), ColumnarColumnTypeMismatchException);
+  ASSERT_THROW(ColumnarReader(dir + ".nonexistent"), ColumnarFileException);
+}
+
+TEST(Columnar, ManifestCanNotBeWritten) {
+  using namespace columnar_test;
+  using namespace current::columnar;
+
+  const std::string dir = current::FileSystem::JoinPath(FLAGS_columnar_test_tmpdir, "manifest_can_not_be_written");
+  const auto dir_remover = current::FileSystem::ScopedRmDir(dir);
+  current::FileSystem::MkDir(dir, current::FileSystem::MkDirParameters::Silent);
+  // A directory in place of the manifest makes writing it fail.
+  current::FileSystem::MkDir(current::FileSystem::JoinPath(dir, kColumnarManifestFileName));
+
+  {
+    ColumnarWriter<Ride> writer(dir);
+    writer.Add(MakeRide(1u));
+    ASSERT_THROW(writer.Close(), ColumnarFileException);
+  }
+  {
+    // Neither does the destructor, which closes the writer if it was not closed, throw.
+    ColumnarWriter<Ride> writer(dir);
+    writer.Add(MakeRide(2u));
+  }
+}
+
+TEST(Columnar, Aggregations) {
+  using namespace columnar_test;
+  using namespace current::columnar;
+
+  const std::string dir = current::FileSystem::JoinPath(FLAGS_columnar_test_tmpdir, "aggregations");
+  const auto dir_remover = current::FileSystem::ScopedRmDir(dir);
+
+  const uint32_t n = 1200u;
+  std::vector<Ride> rides;
+  {
+    // Export from a persister, same as from a stream, with `writer.AddAll(*stream->Data())`.
+    std::mutex mutex;
+    current::persistence::Memory<Ride> persister(mutex, current::ss::StreamNamespaceName("ns", "Ride"));
+    for (uint32_t i = 0u; i < n; ++i) {
+      rides.push_back(MakeRide(i));
+      persister.Publish(rides.back(), std::chrono::microseconds(i + 1u));
+    }
+    ColumnarWriter<Ride> writer(dir);
+    writer.AddAll(persister);
+    writer.Close();
+  }
+
+  const ColumnarReader reader(dir);
+  ASSERT_EQ(n, reader.Size());
+
+  const auto pickup_month = reader.Read<uint8_t>("pickup.month");
+  const auto vendor = reader.Read<Vendor>("vendor");
+  const auto payment = reader.Read<std::string>("payment");
+  const auto fare_cents = reader.Read<int32_t>("fare_cents");
+  const auto tip_cents = reader.Read<int32_t>("tip_cents");
+  const auto distance = reader.Read<double>("distance");
+  const auto note = reader.Read<std::string>("note");
+  const auto dropoff_hour = reader.Read<uint8_t>("dropoff.hour");
+
+  int64_t total_fare = 0;
+  int64_t total_tip = 0;
+  int64_t total_card_fare = 0;
+  uint64_t tips = 0u;
+  uint64_t card_rides_with_tips = 0u;
+  double total_distance = 0.0;
+  std::map<uint8_t, uint64_t> rides_by_month;
+  std::map<uint8_t, int64_t> fare_by_month;
+  std::map<Vendor, uint64_t> rides_by_vendor;
+  std::map<std::string, int64_t> tip_by_payment;
+  std::map<std::string, uint64_t> rides_by_note;
+  std::map<uint8_t, uint64_t> card_rides_by_dropoff_hour;
+  for (const Ride& ride : rides) {
+    total_fare += ride.fare_cents;
+    total_distance += ride.distance;
+    ++rides_by_month[ride.pickup.month];
+    fare_by_month[ride.pickup.month] += ride.fare_cents;
+    ++rides_by_vendor[ride.vendor];
+    tip_by_payment[ride.payment] += Exists(ride.tip_cents) ? Value(ride.tip_cents) : 0;
+    if (Exists(ride.tip_cents)) {
+      total_tip += Value(ride.tip_cents);
+      ++tips;
+    }
+    if (Exists(ride.note)) {
+      ++rides_by_note[Value(ride.note)];
+    }
+    if (ride.payment == "card") {
+      total_card_fare += ride.fare_cents;
+      if (Exists(ride.tip_cents)) {
+        ++card_rides_with_tips;
+      }
+      if (Exists(ride.dropoff)) {
+        ++card_rides_by_dropoff_hour[Value(ride.dropoff).hour];
+      }
+    }
+  }
+
+  EXPECT_EQ(total_fare, Sum(fare_cents));
+  EXPECT_EQ(total_tip, Sum(tip_cents));
+  EXPECT_EQ(total_distance, Sum(distance));
+  EXPECT_EQ(n, Count(fare_cents));
+  EXPECT_EQ(tips, Count(tip_cents));
+  EXPECT_EQ(static_cast<double>(total_tip) / tips, Value(Mean(tip_cents)));
+
+  EXPECT_EQ(500, Value(Min(fare_cents)));
+  EXPECT_EQ(static_cast<int32_t>(500u + n - 1u), Value(Max(fare_cents)));
+  EXPECT_EQ(0, Value(Min(tip_cents)));
+  EXPECT_EQ(static_cast<int32_t>(n - 5u), Value(Max(tip_cents)));
+
+  const Selection card = Where(payment, [](const std::string& s) { return s == "card"; });
+  const Selection tipped = Where(tip_cents, [](int32_t) { return true; });
+  EXPECT_EQ(n / 2u, Count(card));
+  EXPECT_EQ(tips, Count(tipped));
+  EXPECT_EQ(card_rides_with_tips, Count(And(card, tipped)));
+  EXPECT_EQ(total_card_fare, Sum(fare_cents, card));
+  EXPECT_EQ(static_cast<int32_t>(501), Value(Min(fare_cents, card)));
+  EXPECT_EQ(static_cast<int32_t>(n - 5u), Value(Max(tip_cents, And(card, tipped))));
+  EXPECT_FALSE(Exists(Max(tip_cents, Where(fare_cents, [](int32_t fare) { return fare < 500; }))));
+
+  EXPECT_EQ(rides_by_month, CountBy(pickup_month));
+  EXPECT_EQ(fare_by_month, SumBy(pickup_month, fare_cents));
+  EXPECT_EQ(rides_by_vendor, CountBy(vendor));
+  EXPECT_EQ(tip_by_payment, SumBy(payment, tip_cents));
+  EXPECT_EQ(rides_by_note, CountBy(note));
+  EXPECT_EQ(card_rides_by_dropoff_hour, CountBy(dropoff_hour, card));
+}